@@ -25,6 +25,7 @@
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
 #include <getopt.h>
+#include <string.h>
 
 #include <QDebug>
 
@@ -33,6 +34,9 @@
 #endif
 
 #include "pv/application.hpp"
+#ifdef ENABLE_DECODE_WORKERS
+#include "pv/data/decode/decodeprocess.hpp"
+#endif
 #include "pv/devicemanager.hpp"
 #include "pv/mainwindow.hpp"
 #ifdef ANDROID
@@ -72,6 +76,15 @@ int main(int argc, char *argv[])
 	std::shared_ptr<sigrok::Context> context;
 	std::string open_file, open_file_format;
 
+#ifdef ENABLE_DECODE_WORKERS
+	// Decode workers are started by the decoder stacks, and run without
+	// a GUI
+	if (argc == 4 && strcmp(argv[1],
+		pv::data::decode::DecodeProcess::WorkerOption) == 0)
+		return pv::data::decode::DecodeProcess::run_worker(
+			atoi(argv[2]), atoi(argv[3]));
+#endif
+
 	Application a(argc, argv);
 
 #ifdef ANDROID
@@ -22,8 +22,9 @@
 #include "analog.hpp"
 #include "analogsegment.hpp"
 
-using std::deque;
+using std::lock_guard;
 using std::max;
+using std::mutex;
 using std::shared_ptr;
 using std::vector;
 
@@ -31,38 +32,73 @@ namespace pv {
 namespace data {
 
 Analog::Analog() :
-	SignalData()
+	SignalData(),
+	first_frame_(0)
 {
 }
 
-void Analog::push_segment(shared_ptr<AnalogSegment> &segment)
+void Analog::push_segment(shared_ptr<AnalogSegment> &segment, uint64_t frame)
 {
-	segments_.push_front(segment);
+	lock_guard<mutex> lock(mutex_);
+
+	if (segments_.empty())
+		first_frame_ = frame;
+
+	assert(frame >= first_frame_ + segments_.size());
+	segments_.resize(frame - first_frame_);
+	segments_.push_back(segment);
 }
 
-const deque< shared_ptr<AnalogSegment> >& Analog::analog_segments() const
+shared_ptr<AnalogSegment> Analog::analog_segment(uint64_t frame) const
 {
-	return segments_;
+	lock_guard<mutex> lock(mutex_);
+
+	if (frame < first_frame_ || frame - first_frame_ >= segments_.size())
+		return nullptr;
+
+	return segments_[frame - first_frame_];
 }
 
 vector< shared_ptr<Segment> > Analog::segments() const
 {
-	return vector< shared_ptr<Segment> >(
-		segments_.begin(), segments_.end());
+	lock_guard<mutex> lock(mutex_);
+
+	vector< shared_ptr<Segment> > segments;
+	for (const shared_ptr<AnalogSegment> &s : segments_)
+		if (s)
+			segments.push_back(s);
+	return segments;
+}
+
+shared_ptr<Segment> Analog::frame_segment(uint64_t frame) const
+{
+	return analog_segment(frame);
+}
+
+void Analog::drop_frames_before(uint64_t frame)
+{
+	lock_guard<mutex> lock(mutex_);
+
+	for (; first_frame_ < frame && !segments_.empty(); first_frame_++)
+		segments_.pop_front();
 }
 
 void Analog::clear()
 {
+	lock_guard<mutex> lock(mutex_);
+
 	segments_.clear();
+	first_frame_ = 0;
 }
 
 uint64_t Analog::max_sample_count() const
 {
+	lock_guard<mutex> lock(mutex_);
+
 	uint64_t l = 0;
-	for (const std::shared_ptr<AnalogSegment> s : segments_) {
-		assert(s);
-		l = max(l, s->get_sample_count());
-	}
+	for (const shared_ptr<AnalogSegment> &s : segments_)
+		if (s)
+			l = max(l, s->get_sample_count());
 	return l;
 }
 
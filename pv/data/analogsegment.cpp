@@ -20,6 +20,7 @@
 #include <extdef.h>
 
 #include <assert.h>
+#include <float.h>
 #include <string.h>
 #include <stdlib.h>
 #include <cmath>
@@ -27,13 +28,21 @@
 #include <algorithm>
 
 #include "analogsegment.hpp"
+#include "kernels.hpp"
 
-using std::lock_guard;
-using std::recursive_mutex;
+using boost::shared_lock;
+using boost::shared_mutex;
+using boost::unique_lock;
+
+using std::default_delete;
 using std::max;
 using std::max_element;
 using std::min;
 using std::min_element;
+using std::shared_ptr;
+using std::sort;
+using std::unique;
+using std::vector;
 
 namespace pv {
 namespace data {
@@ -42,63 +51,291 @@ const int AnalogSegment::EnvelopeScalePower = 4;
 const int AnalogSegment::EnvelopeScaleFactor = 1 << EnvelopeScalePower;
 const float AnalogSegment::LogEnvelopeScaleFactor =
 	logf(EnvelopeScaleFactor);
-const uint64_t AnalogSegment::EnvelopeDataUnit = 64*1024;	// bytes
+const uint64_t AnalogSegment::ConversionTileLength = 1024;
+
+double AnalogSegment::Statistics::peak_to_peak() const
+{
+	return (count > 0) ? (double)max - min : 0.0;
+}
+
+double AnalogSegment::Statistics::mean() const
+{
+	return (count > 0) ? sum / count : 0.0;
+}
+
+double AnalogSegment::Statistics::rms() const
+{
+	return (count > 0) ? sqrt(sum_sq / count) : 0.0;
+}
+
+double AnalogSegment::Statistics::ac_rms() const
+{
+	// Rounding may leave the variance of a constant signal just below 0
+	const double m = mean();
+	return (count > 0) ? sqrt(std::max(sum_sq / count - m * m, 0.0)) : 0.0;
+}
 
 AnalogSegment::AnalogSegment(
-	uint64_t samplerate, const uint64_t expected_num_samples) :
-	Segment(samplerate, sizeof(float))
+	uint64_t samplerate, const uint64_t expected_num_samples,
+	shared_ptr<ChunkAllocator> allocator, SampleFormat format,
+	float scale, float offset) :
+	Segment(samplerate, (format == FloatFormat) ?
+		sizeof(float) : sizeof(int16_t), allocator),
+	format_(format),
+	scale_(scale),
+	offset_(offset),
+	float_chunk_((format == FloatFormat) ? 0 : ~0ULL),
+	float_sample_((format == FloatFormat) ? 0 : ~0ULL)
 {
 	set_capacity(expected_num_samples);
 
-	lock_guard<recursive_mutex> lock(mutex_);
-	memset(envelope_levels_, 0, sizeof(envelope_levels_));
+	for (Envelope &e : envelope_levels_) {
+		e.length = 0;
+		e.samples = PagedArray(sizeof(EnvelopeSample));
+		e.sums = PagedArray(sizeof(SumSample));
+	}
 }
 
 AnalogSegment::~AnalogSegment()
 {
-	lock_guard<recursive_mutex> lock(mutex_);
-	for (Envelope &e : envelope_levels_)
-		free(e.samples);
+	unique_lock<shared_mutex> lock(mutex_);
+}
+
+AnalogSegment::SampleFormat AnalogSegment::format() const
+{
+	return (float_chunk_ == ~0ULL) ? format_ : FloatFormat;
+}
+
+float AnalogSegment::scale() const
+{
+	return scale_;
+}
+
+float AnalogSegment::offset() const
+{
+	return offset_;
+}
+
+bool AnalogSegment::find_int16_scale(const float *data,
+	size_t sample_count, size_t stride, float &scale, float &offset)
+{
+	// Fewer codes may not show the actual step of the ADC
+	const size_t MinCodeCount = 16;
+	const size_t MaxSampleCount = 65536;
+
+	vector<float> codes;
+	for (size_t i = 0; i < min(sample_count, MaxSampleCount); i++) {
+		if (!std::isfinite(data[i * stride]))
+			return false;
+		codes.push_back(data[i * stride]);
+	}
+
+	sort(codes.begin(), codes.end());
+	codes.erase(unique(codes.begin(), codes.end()), codes.end());
+	if (codes.size() < MinCodeCount)
+		return false;
+
+	float step = FLT_MAX;
+	for (size_t i = 1; i < codes.size(); i++)
+		step = min(step, codes[i] - codes[i - 1]);
+
+	// Every code must be a multiple of the step, and most neighbours
+	// must be one step apart. Otherwise the actual step may be smaller.
+	// The step is refined over the growing distance from the first
+	// code, which evens out the rounding of the codes.
+	size_t single_steps = 0;
+	for (size_t i = 1; i < codes.size(); i++) {
+		const float k = (codes[i] - codes[0]) / step;
+		if (fabsf(k - nearbyintf(k)) > 0.1f)
+			return false;
+		step = (codes[i] - codes[0]) / nearbyintf(k);
+		if (codes[i] - codes[i - 1] < 1.5f * step)
+			single_steps++;
+	}
+
+	const float span = (codes.back() - codes.front()) / step;
+	if (single_steps * 2 < codes.size() - 1 || span > INT16_MAX)
+		return false;
+
+	// Center the codes of the packet in the integer range
+	scale = step;
+	offset = codes.front() + nearbyintf(span / 2) * step;
+	return true;
+}
+
+bool AnalogSegment::fits_format(const float *data, size_t sample_count,
+	size_t stride) const
+{
+	if (format() == FloatFormat)
+		return true;
+
+	// Samples up to half a step beyond the extreme codes saturate to
+	// them. NaNs fail either comparison.
+	const float lo = offset_ + (INT16_MIN - 0.5f) * scale_;
+	const float hi = offset_ + (INT16_MAX + 0.5f) * scale_;
+	for (size_t i = 0; i < sample_count; i++, data += stride)
+		if (!(*data >= lo && *data <= hi))
+			return false;
+
+	return true;
+}
+
+void AnalogSegment::store_as_floats()
+{
+	if (format() == FloatFormat)
+		return;
+
+	const uint64_t sample_count = sample_count_;
+	const uint64_t chunk_num = sample_count >> chunk_sample_power_;
+
+	unique_lock<shared_mutex> lock(mutex_);
+
+	// The chunk being filled is kept aside with the samples it holds so
+	// far, and it is allocated anew for the floats that follow, as are
+	// the chunks beyond it
+	if (sample_count & (chunk_samples_ - 1))
+		boundary_chunk_ = data_chunks_[chunk_num - chunk_offset_];
+	release_chunks(chunk_num);
+
+	float_chunk_ = chunk_num;
+	float_sample_ = sample_count;
 }
 
 void AnalogSegment::append_interleaved_samples(const float *data,
 	size_t sample_count, size_t stride)
 {
-	assert(unit_size_ == sizeof(float));
-
-	lock_guard<recursive_mutex> lock(mutex_);
+	vector<float> tile;
 
 	// If we're out of memory, this will throw std::bad_alloc
-	data_.resize((sample_count_ + sample_count) * sizeof(float));
+	set_capacity(sample_count_ + sample_count);
+
+	// The samples are copied without the lock, and published by
+	// updating the sample count. @see Segment::append_data()
+	uint64_t end = sample_count_;
+	while (sample_count > 0) {
+		uint64_t n = sample_count;
+		uint8_t *stored;
+		SampleFormat format;
+		stored_samples(end, n, stored, format);
+
+		// Other formats are converted from a tile of floats
+		float *dst = (float*)stored;
+		if (format != FloatFormat) {
+			n = min(n, ConversionTileLength);
+			tile.resize(n);
+			dst = tile.data();
+		}
+
+		const float *dst_end = dst + n;
+		while (dst != dst_end) {
+			*dst++ = *data;
+			data += stride;
+		}
+
+		if (format != FloatFormat)
+			encode_samples(tile.data(), stored, n);
 
-	float *dst = (float*)data_.data() + sample_count_;
-	const float *dst_end = dst + sample_count;
-	while (dst != dst_end) {
-		*dst++ = *data;
-		data += stride;
+		end += n;
+		sample_count -= n;
 	}
 
-	sample_count_ += sample_count;
+	sample_count_ = end;
 
-	// Generate the first mip-map from the data
-	append_payload_to_envelope_levels();
+	// The envelope is built later on by summarize(), off the data feed
+	// thread
 }
 
-const float* AnalogSegment::get_samples(
+void AnalogSegment::append_interleaved_samples(
+	const vector< shared_ptr<AnalogSegment> > &segments,
+	const float *data, size_t sample_count)
+{
+	const unsigned int channel_count = segments.size();
+	vector<uint64_t> ends(channel_count);
+	vector<uint8_t*> stored(channel_count);
+	vector<float*> dests(channel_count);
+	vector< vector<float> > tiles(channel_count);
+
+	// If we're out of memory, this will throw std::bad_alloc
+	for (unsigned int c = 0; c < channel_count; c++) {
+		AnalogSegment &s = *segments[c];
+		s.set_capacity(s.sample_count_ + sample_count);
+		ends[c] = s.sample_count_;
+
+		// Other formats are converted from a tile of floats
+		if (s.format() != FloatFormat)
+			tiles[c].resize(ConversionTileLength);
+	}
+
+	// The segments may have been started at different times, so their
+	// chunk boundaries need not line up. The packet is split into runs
+	// that are contiguous in every segment.
+	while (sample_count > 0) {
+		uint64_t n = sample_count;
+		for (unsigned int c = 0; c < channel_count; c++) {
+			SampleFormat format;
+			segments[c]->stored_samples(ends[c], n, stored[c], format);
+			if (!tiles[c].empty())
+				n = min(n, ConversionTileLength);
+		}
+
+		for (unsigned int c = 0; c < channel_count; c++)
+			dests[c] = tiles[c].empty() ?
+				(float*)stored[c] : tiles[c].data();
+
+		kernels::analog_deinterleave(data, dests.data(), channel_count, n);
+
+		for (unsigned int c = 0; c < channel_count; c++)
+			if (!tiles[c].empty())
+				segments[c]->encode_samples(tiles[c].data(),
+					stored[c], n);
+
+		for (uint64_t &end : ends)
+			end += n;
+		data += n * channel_count;
+		sample_count -= n;
+	}
+
+	for (unsigned int c = 0; c < channel_count; c++)
+		segments[c]->sample_count_ = ends[c];
+}
+
+SegmentDataView AnalogSegment::get_samples(
 	int64_t start_sample, int64_t end_sample) const
 {
 	assert(start_sample >= 0);
-	assert(start_sample < (int64_t)sample_count_);
+	assert(start_sample <= (int64_t)sample_count_);
 	assert(end_sample >= 0);
-	assert(end_sample < (int64_t)sample_count_);
+	assert(end_sample <= (int64_t)sample_count_);
 	assert(start_sample <= end_sample);
 
-	lock_guard<recursive_mutex> lock(mutex_);
+	if (start_sample == end_sample)
+		return SegmentDataView();
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	// The samples that have been dropped read as zeros
+	uint64_t count = end_sample - start_sample;
+	if ((uint64_t)start_sample < first_sample_) {
+		count = min(min(count, first_sample_ - start_sample),
+			contiguous_samples(start_sample));
+		const shared_ptr<uint8_t> zeros(
+			new uint8_t[count * sizeof(float)](),
+			default_delete<uint8_t[]>());
+		return SegmentDataView(zeros, zeros.get(), count, sizeof(float));
+	}
+
+	uint8_t *data;
+	SampleFormat format;
+	const shared_ptr<uint8_t> chunk = stored_samples(start_sample, count,
+		data, format);
+	if (format == FloatFormat)
+		return SegmentDataView(chunk, data, count, sizeof(float));
+
+	const shared_ptr<uint8_t> samples(new uint8_t[count * sizeof(float)],
+		default_delete<uint8_t[]>());
+	decode_samples(format, data, (float*)samples.get(), count);
 
-	float *const data = new float[end_sample - start_sample];
-	memcpy(data, (float*)data_.data() + start_sample, sizeof(float) *
-		(end_sample - start_sample));
-	return data;
+	return SegmentDataView(samples, samples.get(), count, sizeof(float));
 }
 
 void AnalogSegment::get_envelope_section(EnvelopeSection &s,
@@ -108,10 +345,14 @@ void AnalogSegment::get_envelope_section(EnvelopeSection &s,
 	assert(start <= end);
 	assert(min_length > 0);
 
-	lock_guard<recursive_mutex> lock(mutex_);
+	shared_lock<shared_mutex> lock(mutex_);
 
-	const unsigned int min_level = max((int)floorf(logf(min_length) /
-		LogEnvelopeScaleFactor) - 1, 0);
+	// The samples before the first one held have been dropped
+	start = max(start, (uint64_t)first_sample_);
+	end = max(end, start);
+
+	const unsigned int min_level = min(max((int)floorf(logf(min_length) /
+		LogEnvelopeScaleFactor) - 1, 0), (int)ScaleStepCount - 1);
 	const unsigned int scale_power = (min_level + 1) *
 		EnvelopeScalePower;
 	start >>= scale_power;
@@ -120,52 +361,385 @@ void AnalogSegment::get_envelope_section(EnvelopeSection &s,
 	s.start = start << scale_power;
 	s.scale = 1 << scale_power;
 	s.length = end - start;
-	s.samples = new EnvelopeSample[s.length];
-	memcpy(s.samples, envelope_levels_[min_level].samples + start,
-		s.length * sizeof(EnvelopeSample));
+	s.samples = nullptr;
+	s.page.reset();
+
+	if (s.length == 0)
+		return;
+
+	// Point into the blocks the envelope covers, up to the end of their
+	// page
+	const Envelope &e = envelope_levels_[min_level];
+	if (start < e.length) {
+		s.length = min(min(end, e.length) - start,
+			e.samples.contiguous_entries(start));
+		s.samples = (const EnvelopeSample*)e.samples.entry(start);
+		s.page = e.samples.page(start);
+		return;
+	}
+
+	// Compute the rest from the raw samples
+	const shared_ptr<uint8_t> samples(
+		new uint8_t[s.length * sizeof(EnvelopeSample)],
+		default_delete<uint8_t[]>());
+	EnvelopeSample *const dest = (EnvelopeSample*)samples.get();
+	for (uint64_t block = start; block < end; block++)
+		dest[block - start] = get_raw_envelope_sample(
+			block << scale_power, s.scale);
+
+	s.samples = dest;
+	s.page = samples;
 }
 
-void AnalogSegment::reallocate_envelope(Envelope &e)
+void AnalogSegment::get_envelope_columns(EnvelopeSample *dest,
+	unsigned int width, double start, double samples_per_column) const
 {
-	const uint64_t new_data_length = ((e.length + EnvelopeDataUnit - 1) /
-		EnvelopeDataUnit) * EnvelopeDataUnit;
-	if (new_data_length > e.data_length) {
-		e.data_length = new_data_length;
-		e.samples = (EnvelopeSample*)realloc(e.samples,
-			new_data_length * sizeof(EnvelopeSample));
+	assert(samples_per_column > 0);
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	const uint64_t first = first_sample_;
+	const uint64_t count = sample_count_;
+
+	// Find the coarsest level whose blocks fit into a column. Narrower
+	// columns are summarized from the raw samples.
+	int level = -1;
+	while (level + 1 < (int)ScaleStepCount && (double)(1ULL <<
+			((level + 2) * EnvelopeScalePower)) <= samples_per_column)
+		level++;
+
+	for (unsigned int i = 0; i < width; i++) {
+		EnvelopeSample &column = dest[i];
+		column.min = FLT_MAX;
+		column.max = -FLT_MAX;
+
+		const double column_start = start + i * samples_per_column;
+		const double column_end = column_start + samples_per_column;
+		if (column_end <= first || column_start >= count)
+			continue;
+
+		const uint64_t s0 = max((uint64_t)max(column_start, 0.0), first);
+		const uint64_t s1 = min(max((uint64_t)column_end, s0 + 1), count);
+
+		add_envelope_range(column, level, s0, s1);
 	}
 }
 
-void AnalogSegment::append_payload_to_envelope_levels()
+void AnalogSegment::add_envelope_range(EnvelopeSample &sample, int level,
+	uint64_t start, uint64_t end) const
+{
+	if (start >= end)
+		return;
+
+	if (level < 0) {
+		const EnvelopeSample raw = get_raw_envelope_sample(start,
+			end - start);
+		sample.min = min(sample.min, raw.min);
+		sample.max = max(sample.max, raw.max);
+		return;
+	}
+
+	// Take the whole blocks the envelope covers, and leave the partial
+	// blocks at either end and the blocks not covered yet to the levels
+	// below
+	const Envelope &e = envelope_levels_[level];
+	const unsigned int scale_power = (level + 1) * EnvelopeScalePower;
+	const uint64_t b0 = (start + (1ULL << scale_power) - 1) >> scale_power;
+	const uint64_t b1 = min(end >> scale_power, e.length);
+	if (b0 >= b1) {
+		add_envelope_range(sample, level - 1, start, end);
+		return;
+	}
+
+	for (uint64_t block = b0; block < b1; block++) {
+		const EnvelopeSample *const s =
+			(const EnvelopeSample*)e.samples.entry(block);
+		sample.min = min(sample.min, s->min);
+		sample.max = max(sample.max, s->max);
+	}
+
+	add_envelope_range(sample, level - 1, start, b0 << scale_power);
+	add_envelope_range(sample, level - 1, b1 << scale_power, end);
+}
+
+AnalogSegment::Statistics AnalogSegment::get_statistics(uint64_t start,
+	uint64_t end) const
+{
+	assert(end <= get_sample_count());
+	assert(start <= end);
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	Statistics st = {0, 0.0, 0.0, FLT_MAX, -FLT_MAX};
+
+	// The samples before the first one held have been dropped
+	start = max(start, (uint64_t)first_sample_);
+	if (start >= end)
+		return st;
+
+	// Climb the levels while the blocks of the next level up fit into
+	// the range, taking the blocks up to the first aligned one
+	unsigned int level = 0;
+	while (level < ScaleStepCount) {
+		const uint64_t next = 1ULL << ((level + 1) * EnvelopeScalePower);
+		const uint64_t aligned = (start + next - 1) & ~(next - 1);
+		if (aligned + next > end)
+			break;
+
+		start = add_statistics(st, level, start, aligned);
+		if (start != aligned)
+			break;
+		level++;
+	}
+
+	// Descend again, taking the largest blocks that fit. Blocks that are
+	// not summarized yet are taken from the levels below.
+	for (;; level--) {
+		const uint64_t size = 1ULL << (level * EnvelopeScalePower);
+		start = add_statistics(st, level, start,
+			start + (end - start) / size * size);
+		if (level == 0)
+			break;
+	}
+
+	assert(start == end);
+	return st;
+}
+
+uint64_t AnalogSegment::find_level(uint64_t start, uint64_t end,
+	float level, bool above, bool last) const
+{
+	assert(end <= get_sample_count());
+	assert(start <= end);
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	vector<float> tile(ConversionTileLength);
+	const uint64_t covered =
+		envelope_levels_[0].length << EnvelopeScalePower;
+
+	// The range that is left to search shrinks from the end that is
+	// searched first. Level 0 stands for the raw samples, and level n
+	// for the blocks of envelope level n-1.
+	uint64_t lo = max(start, (uint64_t)first_sample_), hi = end;
+	unsigned int ceiling = ScaleStepCount;
+
+	while (lo < hi) {
+		const uint64_t index = last ? hi : lo;
+
+		// Find the largest summarized block that begins, or ends, at
+		// the index and fits into the range
+		unsigned int l = 0;
+		while (l < ceiling) {
+			const unsigned int power = (l + 1) * EnvelopeScalePower;
+			if ((index & ((1ULL << power) - 1)) != 0 ||
+				hi - lo < (1ULL << power))
+				break;
+
+			const uint64_t block = last ?
+				(index >> power) - 1 : index >> power;
+			if (block >= envelope_levels_[l].length)
+				break;
+			l++;
+		}
+
+		if (l > 0) {
+			const unsigned int power = l * EnvelopeScalePower;
+			const uint64_t block = last ?
+				(index >> power) - 1 : index >> power;
+			const EnvelopeSample *const s = (const EnvelopeSample*)
+				envelope_levels_[l - 1].samples.entry(block);
+
+			// Look into the block if it may hold the level, or else
+			// skip it
+			if (above ? (s->max >= level) : (s->min <= level)) {
+				ceiling = l - 1;
+			} else {
+				if (last)
+					hi -= 1ULL << power;
+				else
+					lo += 1ULL << power;
+				ceiling = ScaleStepCount;
+			}
+
+			continue;
+		}
+
+		// Read the raw samples up to the next block boundary, or a tile
+		// of them where the envelope does not reach yet
+		const uint64_t block_mask = EnvelopeScaleFactor - 1;
+		uint64_t n;
+		if (last)
+			n = (hi > covered) ?
+				min(hi - max(lo, covered), ConversionTileLength) :
+				hi - max(lo, (hi - 1) & ~block_mask);
+		else
+			n = (lo >= covered) ?
+				min(hi - lo, ConversionTileLength) :
+				min(hi, (lo | block_mask) + 1) - lo;
+
+		const uint64_t from = last ? hi - n : lo;
+		read_samples(tile.data(), from, n);
+
+		for (uint64_t i = 0; i < n; i++) {
+			const uint64_t j = last ? n - 1 - i : i;
+			if (above ? (tile[j] >= level) : (tile[j] <= level))
+				return from + j;
+		}
+
+		if (last)
+			hi = from;
+		else
+			lo = from + n;
+		ceiling = ScaleStepCount;
+	}
+
+	return end;
+}
+
+MemoryUsage AnalogSegment::memory_usage() const
+{
+	MemoryUsage usage = Segment::memory_usage();
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	for (const Envelope &e : envelope_levels_)
+		usage.summaries += e.samples.memory_usage() +
+			e.sums.memory_usage();
+
+	if (boundary_chunk_)
+		usage.samples += chunk_samples_ * unit_size_ + sizeof(uint64_t);
+
+	return usage;
+}
+
+void AnalogSegment::summarize(uint64_t end)
+{
+	append_payload_to_envelope_levels(end);
+}
+
+void AnalogSegment::drop_summaries(uint64_t start)
+{
+	// The blocks that hold the first sample are kept
+	for (unsigned int level = 0; level < ScaleStepCount; level++) {
+		Envelope &e = envelope_levels_[level];
+		const uint64_t block = start >> ((level + 1) * EnvelopeScalePower);
+		e.samples.drop_before(block);
+		e.sums.drop_before(block);
+	}
+
+	if (start >= float_sample_)
+		boundary_chunk_.reset();
+}
+
+unsigned int AnalogSegment::chunk_unit_size(uint64_t chunk_num) const
+{
+	return (chunk_num < float_chunk_) ? unit_size_ : sizeof(float);
+}
+
+shared_ptr<uint8_t> AnalogSegment::stored_samples(uint64_t index,
+	uint64_t &count, uint8_t *&data, SampleFormat &format) const
+{
+	const uint64_t chunk_num = index >> chunk_sample_power_;
+	shared_ptr<uint8_t> chunk;
+
+	count = min(count, contiguous_samples(index));
+	if (chunk_num == float_chunk_ && index < float_sample_) {
+		chunk = boundary_chunk_;
+		count = min(count, float_sample_ - index);
+	} else
+		chunk = chunk_data(chunk_num);
+
+	format = (index < float_sample_) ? format_ : FloatFormat;
+	data = chunk.get() + (index & (chunk_samples_ - 1)) *
+		((format == FloatFormat) ? sizeof(float) : unit_size_);
+
+	return chunk;
+}
+
+AnalogSegment::EnvelopeSample AnalogSegment::get_raw_envelope_sample(
+	uint64_t start, uint64_t count) const
+{
+	assert(count > 0);
+
+	// Large blocks may reach back into compressed chunks
+	EnvelopeSample sample = {FLT_MAX, -FLT_MAX};
+	vector<float> tile;
+
+	while (count > 0) {
+		uint64_t n = count;
+		uint8_t *data;
+		SampleFormat format;
+		const shared_ptr<uint8_t> chunk = stored_samples(start, n, data,
+			format);
+
+		// Other formats are converted a tile at a time
+		const float *src_ptr = (const float*)data;
+		if (format != FloatFormat) {
+			n = min(n, ConversionTileLength);
+			tile.resize(n);
+			decode_samples(format, data, tile.data(), n);
+			src_ptr = tile.data();
+		}
+
+		sample.min = min(sample.min, *min_element(src_ptr, src_ptr + n));
+		sample.max = max(sample.max, *max_element(src_ptr, src_ptr + n));
+
+		start += n;
+		count -= n;
+	}
+
+	return sample;
+}
+
+void AnalogSegment::append_payload_to_envelope_levels(uint64_t end)
 {
 	Envelope &e0 = envelope_levels_[0];
 	uint64_t prev_length;
-	EnvelopeSample *dest_ptr;
 
 	// Expand the data buffer to fit the new samples
 	prev_length = e0.length;
-	e0.length = sample_count_ / EnvelopeScaleFactor;
+	e0.length = end / EnvelopeScaleFactor;
 
 	// Break off if there are no new samples to compute
 	if (e0.length == prev_length)
 		return;
 
-	reallocate_envelope(e0);
-
-	dest_ptr = e0.samples + prev_length;
-
-	// Iterate through the samples to populate the first level mipmap
-	const float *const end_src_ptr = (float*)data_.data() +
-		e0.length * EnvelopeScaleFactor;
-	for (const float *src_ptr = (float*)data_.data() +
-			prev_length * EnvelopeScaleFactor;
-			src_ptr < end_src_ptr; src_ptr += EnvelopeScaleFactor) {
-		const EnvelopeSample sub_sample = {
-			*min_element(src_ptr, src_ptr + EnvelopeScaleFactor),
-			*max_element(src_ptr, src_ptr + EnvelopeScaleFactor),
-		};
-
-		*dest_ptr++ = sub_sample;
+	e0.samples.reserve(e0.length);
+	e0.sums.reserve(e0.length);
+
+	// Populate the first level mipmap and its sums one contiguous run of
+	// samples at a time. The chunk size is a multiple of the scale factor, so the
+	// samples of one block are always stored contiguously in floats.
+	// Other formats are converted a tile at a time, which also covers
+	// the block that straddles the change to floats.
+	vector<float> tile;
+	for (uint64_t block = prev_length; block < e0.length;) {
+		const uint64_t index = block * EnvelopeScaleFactor;
+		uint64_t count = min(min(e0.length - block,
+			e0.samples.contiguous_entries(block)),
+			e0.sums.contiguous_entries(block));
+		uint64_t n = count * EnvelopeScaleFactor;
+		uint8_t *data;
+		SampleFormat format;
+		const shared_ptr<uint8_t> chunk = stored_samples(index, n, data,
+			format);
+		const float *src_ptr = (const float*)data;
+
+		if (format != FloatFormat) {
+			count = min(count,
+				ConversionTileLength / EnvelopeScaleFactor);
+			tile.resize(count * EnvelopeScaleFactor);
+			read_samples(tile.data(), index, tile.size());
+			src_ptr = tile.data();
+		} else
+			count = n / EnvelopeScaleFactor;
+
+		kernels::analog_envelope_minmax(src_ptr,
+			(float*)e0.samples.entry(block), count);
+		kernels::analog_block_sums(src_ptr,
+			(double*)e0.sums.entry(block), count);
+		block += count;
 	}
 
 	// Compute higher level mipmaps
@@ -181,26 +755,151 @@ void AnalogSegment::append_payload_to_envelope_levels()
 		if (e.length == prev_length)
 			break;
 
-		reallocate_envelope(e);
-
-		// Subsample the level lower level
-		const EnvelopeSample *src_ptr =
-			el.samples + prev_length * EnvelopeScaleFactor;
-		const EnvelopeSample *const end_dest_ptr = e.samples + e.length;
-		for (dest_ptr = e.samples + prev_length;
-				dest_ptr < end_dest_ptr; dest_ptr++) {
-			const EnvelopeSample *const end_src_ptr =
-				src_ptr + EnvelopeScaleFactor;
-
-			EnvelopeSample sub_sample = *src_ptr++;
-			while (src_ptr < end_src_ptr) {
-				sub_sample.min = min(sub_sample.min, src_ptr->min);
-				sub_sample.max = max(sub_sample.max, src_ptr->max);
-				src_ptr++;
+		e.samples.reserve(e.length);
+		e.sums.reserve(e.length);
+
+		// Subsample the level lower level, one run of pages at a time
+		for (uint64_t offset = prev_length; offset < e.length;) {
+			const uint64_t src_offset = offset * EnvelopeScaleFactor;
+			const uint64_t n = min(min(min(e.length - offset,
+				e.samples.contiguous_entries(offset)),
+				e.sums.contiguous_entries(offset)),
+				el.sums.contiguous_entries(src_offset) /
+					EnvelopeScaleFactor);
+			assert(n > 0);
+
+			kernels::analog_envelope_reduce(
+				(const float*)el.samples.entry(src_offset),
+				(float*)e.samples.entry(offset), n);
+			kernels::analog_sums_reduce(
+				(const double*)el.sums.entry(src_offset),
+				(double*)e.sums.entry(offset), n);
+
+			offset += n;
+		}
+	}
+}
+
+uint64_t AnalogSegment::add_statistics(Statistics &st,
+	unsigned int level, uint64_t start, uint64_t end) const
+{
+	if (level > 0) {
+		const Envelope &e = envelope_levels_[level - 1];
+		const unsigned int scale_power = level * EnvelopeScalePower;
+		end = min(end, max(start, e.length << scale_power));
+
+		for (uint64_t block = start >> scale_power;
+				block < (end >> scale_power); block++) {
+			const SumSample *const s =
+				(const SumSample*)e.sums.entry(block);
+			const EnvelopeSample *const m =
+				(const EnvelopeSample*)e.samples.entry(block);
+			st.sum += s->sum;
+			st.sum_sq += s->sum_sq;
+			st.min = min(st.min, m->min);
+			st.max = max(st.max, m->max);
+		}
+
+		st.count += end - start;
+		return end;
+	}
+
+	// Raw samples are read a chunk, or a tile of converted samples, at
+	// a time
+	vector<float> tile;
+	for (uint64_t index = start; index < end;) {
+		uint64_t n = end - index;
+		uint8_t *data;
+		SampleFormat format;
+		const shared_ptr<uint8_t> chunk = stored_samples(index, n, data,
+			format);
+
+		const float *src_ptr = (const float*)data;
+		if (format != FloatFormat) {
+			n = min(n, ConversionTileLength);
+			tile.resize(n);
+			decode_samples(format, data, tile.data(), n);
+			src_ptr = tile.data();
+		}
+
+		// Whole blocks go through the kernels, a batch at a time
+		const uint64_t BatchLength = 64;
+		float envelope[2 * BatchLength];
+		double sums[2 * BatchLength];
+
+		uint64_t i = 0;
+		while (n - i >= kernels::BlockLength) {
+			const uint64_t blocks = min(
+				(n - i) / kernels::BlockLength, BatchLength);
+			kernels::analog_envelope_minmax(src_ptr + i, envelope, blocks);
+			kernels::analog_block_sums(src_ptr + i, sums, blocks);
+
+			for (uint64_t b = 0; b < blocks; b++) {
+				st.min = min(st.min, envelope[2 * b]);
+				st.max = max(st.max, envelope[2 * b + 1]);
+				st.sum += sums[2 * b];
+				st.sum_sq += sums[2 * b + 1];
 			}
 
-			*dest_ptr = sub_sample;
+			i += blocks * kernels::BlockLength;
+		}
+
+		for (; i < n; i++) {
+			st.min = min(st.min, src_ptr[i]);
+			st.max = max(st.max, src_ptr[i]);
+			st.sum += src_ptr[i];
+			st.sum_sq += (double)src_ptr[i] * src_ptr[i];
 		}
+
+		index += n;
+	}
+
+	st.count += end - start;
+	return end;
+}
+
+void AnalogSegment::read_samples(float *dest, uint64_t start,
+	uint64_t count) const
+{
+	while (count > 0) {
+		uint64_t n = count;
+		uint8_t *data;
+		SampleFormat format;
+		const shared_ptr<uint8_t> chunk = stored_samples(start, n, data,
+			format);
+		decode_samples(format, data, dest, n);
+
+		dest += n;
+		start += n;
+		count -= n;
+	}
+}
+
+void AnalogSegment::encode_samples(const float *src, uint8_t *dest,
+	uint64_t count) const
+{
+	switch (format_) {
+	case FloatFormat:
+		memcpy(dest, src, count * sizeof(float));
+		break;
+	case Int16Format:
+		kernels::analog_float_to_int16(src, (int16_t*)dest, count,
+			scale_, offset_);
+		break;
+	}
+}
+
+void AnalogSegment::decode_samples(SampleFormat format, const uint8_t *src,
+	float *dest, uint64_t count) const
+{
+	switch (format) {
+	case FloatFormat:
+		memcpy(dest, src, count * sizeof(float));
+		break;
+	case Int16Format:
+		kernels::analog_int16_to_float((const int16_t*)src, dest, count,
+			scale_, offset_);
+		break;
 	}
 }
 
@@ -20,6 +20,7 @@
 #ifndef PULSEVIEW_PV_DATA_ANALOGSEGMENT_HPP
 #define PULSEVIEW_PV_DATA_ANALOGSEGMENT_HPP
 
+#include "pagedarray.hpp"
 #include "segment.hpp"
 
 #include <utility>
@@ -35,26 +36,70 @@ namespace data {
 class AnalogSegment : public Segment
 {
 public:
+	enum SampleFormat {
+		/// 32-bit floats, as delivered by the device
+		FloatFormat,
+		/// 16-bit integers, which are multiplied by @c scale() and
+		/// shifted by @c offset(). Best for the codes of an ADC.
+		Int16Format
+	};
+
 	struct EnvelopeSample
 	{
 		float min;
 		float max;
 	};
 
+	/**
+	 * A run of envelope samples. The samples point straight into the
+	 * envelope, and @c page keeps them valid.
+	 */
 	struct EnvelopeSection
 	{
 		uint64_t start;
 		unsigned int scale;
 		uint64_t length;
-		EnvelopeSample *samples;
+		const EnvelopeSample *samples;
+		std::shared_ptr<const uint8_t> page;
+	};
+
+	/**
+	 * The extremes, the sum and the sum of squares of a range of
+	 * samples, from which their mean and RMS follow. @c min is above
+	 * @c max for an empty range.
+	 */
+	struct Statistics
+	{
+		uint64_t count;
+		double sum;
+		double sum_sq;
+		float min;
+		float max;
+
+		double peak_to_peak() const;
+
+		double mean() const;
+
+		double rms() const;
+
+		/// The RMS of the samples with their mean removed
+		double ac_rms() const;
 	};
 
 private:
+	struct SumSample
+	{
+		double sum;
+		double sum_sq;
+	};
+
 	struct Envelope
 	{
 		uint64_t length;
-		uint64_t data_length;
-		EnvelopeSample *samples;
+		/// The EnvelopeSample of every block
+		PagedArray samples;
+		/// The SumSample of every block
+		PagedArray sums;
 	};
 
 private:
@@ -62,28 +107,196 @@ private:
 	static const int EnvelopeScalePower;
 	static const int EnvelopeScaleFactor;
 	static const float LogEnvelopeScaleFactor;
-	static const uint64_t EnvelopeDataUnit;
+
+	/// The number of samples that are converted at a time when they are
+	/// not stored as floats
+	static const uint64_t ConversionTileLength;
 
 public:
-	AnalogSegment(uint64_t samplerate, uint64_t expected_num_samples = 0);
+	AnalogSegment(uint64_t samplerate, uint64_t expected_num_samples = 0,
+		std::shared_ptr<ChunkAllocator> allocator =
+			std::shared_ptr<ChunkAllocator>(),
+		SampleFormat format = FloatFormat,
+		float scale = 1.0f, float offset = 0.0f);
 
 	virtual ~AnalogSegment();
 
+	/**
+	 * Returns the format that new samples are stored in.
+	 */
+	SampleFormat format() const;
+
+	float scale() const;
+
+	float offset() const;
+
+	/**
+	 * Looks for the step of the ADC codes in @c sample_count samples that
+	 * are @c stride floats apart. If the samples are dense multiples of
+	 * one step, @c scale and @c offset are set so that @c Int16Format
+	 * stores the codes exactly, and true is returned.
+	 */
+	static bool find_int16_scale(const float *data, size_t sample_count,
+		size_t stride, float &scale, float &offset);
+
+	/**
+	 * Returns true if @c sample_count samples that are @c stride floats
+	 * apart fit the format that new samples are stored in. Only the
+	 * range of the samples is checked against the range of the
+	 * @c Int16Format codes, as their step was found beforehand.
+	 */
+	bool fits_format(const float *data, size_t sample_count,
+		size_t stride) const;
+
+	/**
+	 * Stores the samples appended from now on as floats, for when they
+	 * no longer fit the format of the segment. The samples held so far
+	 * keep their format, so none of them are converted.
+	 */
+	void store_as_floats();
+
 	void append_interleaved_samples(const float *data,
 		size_t sample_count, size_t stride);
 
-	const float* get_samples(int64_t start_sample,
+	/**
+	 * Appends a packet that interleaves one channel per segment of
+	 * @c segments, in that order. The packet is de-interleaved into all
+	 * segments in a single pass.
+	 */
+	static void append_interleaved_samples(
+		const std::vector< std::shared_ptr<AnalogSegment> > &segments,
+		const float *data, size_t sample_count);
+
+	/**
+	 * Returns a view onto the samples from @c start_sample up to
+	 * @c end_sample as floats. The view may end early at a storage chunk
+	 * boundary, or where the samples start to be stored as floats. It is
+	 * zero-copy for floats, and a converted copy otherwise.
+	 * @see Segment::get_raw_samples_view()
+	 */
+	SegmentDataView get_samples(int64_t start_sample,
 		int64_t end_sample) const;
 
+	/**
+	 * Returns the minima and maxima of the samples from @c start up to
+	 * @c end in blocks of at most @c min_length samples. The section is
+	 * zero-copy and may end early at a page boundary of the envelope.
+	 * Blocks that the envelope does not cover yet are computed from the
+	 * raw samples.
+	 */
 	void get_envelope_section(EnvelopeSection &s,
 		uint64_t start, uint64_t end, float min_length) const;
 
+	/**
+	 * Resamples the envelope to @c width columns of
+	 * @c samples_per_column samples each, the first of which starts at
+	 * sample @c start. Each column is summarized from the coarsest level
+	 * whose blocks fit into it, so that only a few envelope samples are
+	 * read per column, and its edges from finer levels so that no
+	 * sample outside the column is included. Columns outside the samples
+	 * held are set to @c min > @c max.
+	 */
+	void get_envelope_columns(EnvelopeSample *dest, unsigned int width,
+		double start, double samples_per_column) const;
+
+	/**
+	 * Returns the statistics of the samples from @c start up to @c end.
+	 * The range is assembled from the largest summarized blocks that
+	 * fit into it, so this takes logarithmic time.
+	 */
+	Statistics get_statistics(uint64_t start, uint64_t end) const;
+
+	/**
+	 * Returns the first sample from @c start up to @c end that is at or
+	 * above @c level if @c above is true, or at or below it otherwise.
+	 * If @c last is true, the last such sample is returned instead.
+	 * Returns @c end if there is none. Envelope blocks that cannot
+	 * hold such a sample are skipped without reading their samples.
+	 */
+	uint64_t find_level(uint64_t start, uint64_t end, float level,
+		bool above, bool last = false) const;
+
+	MemoryUsage memory_usage() const;
+
+protected:
+	void summarize(uint64_t end);
+
+	void drop_summaries(uint64_t start);
+
+	unsigned int chunk_unit_size(uint64_t chunk_num) const;
+
 private:
-	void reallocate_envelope(Envelope &e);
+	/**
+	 * Looks up the stored samples from @c index onwards. Returns the
+	 * chunk that holds them, points @c data at the sample at @c index and
+	 * sets @c format to the format it is stored in. @c count is limited
+	 * to the samples that follow contiguously in that format. Must be
+	 * called with the lock held, unless by the writer.
+	 */
+	std::shared_ptr<uint8_t> stored_samples(uint64_t index,
+		uint64_t &count, uint8_t *&data, SampleFormat &format) const;
+
+	/**
+	 * Extends the envelope over the samples up to @c end.
+	 */
+	void append_payload_to_envelope_levels(uint64_t end);
+
+	/**
+	 * Computes the minimum and maximum of @c count raw samples.
+	 */
+	EnvelopeSample get_raw_envelope_sample(uint64_t start,
+		uint64_t count) const;
+
+	/**
+	 * Adds the minimum and maximum of the samples from @c start up to
+	 * @c end to @c sample. The whole blocks of envelope @c level are
+	 * read from the envelope, and the partial blocks at either end from
+	 * the next finer level down, or the raw samples below level 0.
+	 */
+	void add_envelope_range(EnvelopeSample &sample, int level,
+		uint64_t start, uint64_t end) const;
+
+	/**
+	 * Adds the blocks of @c level to @c st that lie from @c start up to
+	 * @c end, where level 0 stands for the raw samples and level @c n
+	 * for the blocks of envelope level @c n-1. Returns where the
+	 * summarized blocks end, if that is before @c end.
+	 */
+	uint64_t add_statistics(Statistics &st, unsigned int level,
+		uint64_t start, uint64_t end) const;
 
-	void append_payload_to_envelope_levels();
+	/**
+	 * Copies @c count samples from @c start to @c dest as floats.
+	 */
+	void read_samples(float *dest, uint64_t start, uint64_t count) const;
+
+	/**
+	 * Converts @c count floats into the compact format of the segment at
+	 * @c dest.
+	 */
+	void encode_samples(const float *src, uint8_t *dest,
+		uint64_t count) const;
+
+	/**
+	 * Converts @c count samples stored at @c src in @c format into
+	 * floats.
+	 */
+	void decode_samples(SampleFormat format, const uint8_t *src,
+		float *dest, uint64_t count) const;
 
 private:
+	/// The format the segment was created with
+	const SampleFormat format_;
+	const float scale_;
+	const float offset_;
+
+	/// The first chunk that stores floats. Its samples before
+	/// float_sample_ are held in boundary_chunk_ in the format of the
+	/// segment.
+	uint64_t float_chunk_;
+	uint64_t float_sample_;
+	std::shared_ptr<uint8_t> boundary_chunk_;
+
 	struct Envelope envelope_levels_[ScaleStepCount];
 
 	friend struct AnalogSegmentTest::Basic;
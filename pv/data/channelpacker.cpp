@@ -0,0 +1,113 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include <algorithm>
+
+#include "channelpacker.hpp"
+
+using std::find;
+using std::max;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+const unsigned int ChannelPacker::MaxSourceUnitSize;
+
+ChannelPacker::ChannelPacker(const vector<unsigned int> &channels,
+	unsigned int source_unit_size) :
+	channels_(channels),
+	source_unit_size_(source_unit_size),
+	unit_size_(max((channels.size() + 7) / 8, (size_t)1)),
+	pack_table_(source_unit_size * 256, 0),
+	unpack_table_(unit_size_ * 256, 0)
+{
+	assert(source_unit_size_ <= MaxSourceUnitSize);
+	assert(unit_size_ <= source_unit_size_);
+
+	for (unsigned int i = 0; i < channels_.size(); i++) {
+		const unsigned int channel = channels_[i];
+		assert(channel < source_unit_size_ * 8);
+		assert(i == 0 || channels_[i - 1] < channel);
+
+		const unsigned int byte = channel / 8;
+		if (find(pack_bytes_.begin(), pack_bytes_.end(), byte) ==
+				pack_bytes_.end())
+			pack_bytes_.push_back(byte);
+
+		// Add the bit to every table entry that has it set
+		for (unsigned int value = 0; value < 256; value++) {
+			if (value & (1 << (channel % 8)))
+				pack_table_[byte * 256 + value] |= 1ULL << i;
+			if (value & (1 << (i % 8)))
+				unpack_table_[(i / 8) * 256 + value] |=
+					1ULL << channel;
+		}
+	}
+}
+
+unsigned int ChannelPacker::unit_size() const
+{
+	return unit_size_;
+}
+
+unsigned int ChannelPacker::source_unit_size() const
+{
+	return source_unit_size_;
+}
+
+int ChannelPacker::packed_index(unsigned int channel) const
+{
+	const auto i = find(channels_.begin(), channels_.end(), channel);
+	return (i == channels_.end()) ? -1 : (i - channels_.begin());
+}
+
+void ChannelPacker::pack(const uint8_t *src, uint64_t count,
+	uint8_t *dest) const
+{
+	for (uint64_t i = 0; i < count; i++) {
+		uint64_t sample = 0;
+		for (unsigned int byte : pack_bytes_)
+			sample |= pack_table_[byte * 256 + src[byte]];
+
+		for (unsigned int j = 0; j < unit_size_; j++, sample >>= 8)
+			*dest++ = (uint8_t)sample;
+		src += source_unit_size_;
+	}
+}
+
+void ChannelPacker::unpack(const uint8_t *src, uint64_t count,
+	uint8_t *dest) const
+{
+	for (uint64_t i = 0; i < count; i++) {
+		uint64_t sample = 0;
+		for (unsigned int j = 0; j < unit_size_; j++)
+			sample |= unpack_table_[j * 256 + src[j]];
+
+		for (unsigned int j = 0; j < source_unit_size_; j++, sample >>= 8)
+			*dest++ = (uint8_t)sample;
+		src += unit_size_;
+	}
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,92 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CHANNELPACKER_HPP
+#define PULSEVIEW_PV_DATA_CHANNELPACKER_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace pv {
+namespace data {
+
+/**
+ * Repacks logic samples to a subset of their channels.
+ *
+ * The bits of the kept channels are moved next to each other, in the
+ * order of their bits in the source samples, so that the samples can be
+ * stored in a narrower unit. Both directions are done with one table
+ * lookup per byte.
+ */
+class ChannelPacker
+{
+public:
+	/// The widest source samples that can be repacked, in bytes
+	static const unsigned int MaxSourceUnitSize = 8;
+
+public:
+	/**
+	 * @param channels The bits of the kept channels in the source
+	 * 	samples, in ascending order.
+	 * @param source_unit_size The size of the source samples in bytes.
+	 * 	Must not exceed @c MaxSourceUnitSize.
+	 */
+	ChannelPacker(const std::vector<unsigned int> &channels,
+		unsigned int source_unit_size);
+
+	/**
+	 * Returns the size of the packed samples in bytes.
+	 */
+	unsigned int unit_size() const;
+
+	unsigned int source_unit_size() const;
+
+	/**
+	 * Returns the bit of a source channel in the packed samples, or -1
+	 * if the channel is not kept.
+	 */
+	int packed_index(unsigned int channel) const;
+
+	void pack(const uint8_t *src, uint64_t count, uint8_t *dest) const;
+
+	/**
+	 * Restores the layout of the source samples. The bits of the
+	 * channels that are not kept are cleared.
+	 */
+	void unpack(const uint8_t *src, uint64_t count, uint8_t *dest) const;
+
+private:
+	const std::vector<unsigned int> channels_;
+	const unsigned int source_unit_size_;
+	const unsigned int unit_size_;
+
+	/// The bits that every value of every source byte maps to
+	std::vector<uint64_t> pack_table_;
+
+	/// The source bytes that hold kept channels
+	std::vector<unsigned int> pack_bytes_;
+
+	/// The source bits that every value of every packed byte maps to
+	std::vector<uint64_t> unpack_table_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CHANNELPACKER_HPP
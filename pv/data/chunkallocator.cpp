@@ -0,0 +1,253 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <new>
+
+#include <QDir>
+#include <QTemporaryFile>
+
+#include "chunkallocator.hpp"
+
+using std::bad_alloc;
+using std::get_deleter;
+using std::lock_guard;
+using std::max;
+using std::mutex;
+using std::shared_ptr;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+class ChunkAllocator::ResidentDeleter
+{
+public:
+	ResidentDeleter(shared_ptr<ChunkAllocator> allocator, uint64_t size) :
+		allocator_(allocator),
+		size_(size)
+	{
+	}
+
+	void operator()(uint8_t *data) const
+	{
+		delete[] data;
+		allocator_->resident_bytes_ -= size_;
+	}
+
+private:
+	shared_ptr<ChunkAllocator> allocator_;
+	uint64_t size_;
+};
+
+class ChunkAllocator::SpilledDeleter
+{
+public:
+	SpilledDeleter(shared_ptr<ChunkAllocator> allocator, uint64_t size) :
+		allocator_(allocator),
+		size_(size)
+	{
+	}
+
+	void operator()(uint8_t *data) const
+	{
+		allocator_->release_spilled(data, size_);
+	}
+
+private:
+	shared_ptr<ChunkAllocator> allocator_;
+	uint64_t size_;
+};
+
+const uint64_t ChunkAllocator::SpillRegionSize = 64 * 1024 * 1024;
+
+ChunkAllocator::ChunkAllocator() :
+	ram_budget_(0),
+	resident_bytes_(0),
+	spilled_bytes_(0),
+	spill_directory_(QDir::tempPath()),
+	spill_file_(nullptr),
+	spill_directory_changed_(false),
+	spill_region_free_(nullptr),
+	spill_region_free_size_(0)
+{
+}
+
+ChunkAllocator::~ChunkAllocator()
+{
+	// Every chunk holds a reference on the allocator, so none are left
+	delete spill_file_;
+}
+
+uint64_t ChunkAllocator::ram_budget() const
+{
+	return ram_budget_;
+}
+
+void ChunkAllocator::set_ram_budget(uint64_t ram_budget)
+{
+	ram_budget_ = ram_budget;
+}
+
+QString ChunkAllocator::spill_directory() const
+{
+	lock_guard<mutex> lock(spill_mutex_);
+	return spill_directory_;
+}
+
+void ChunkAllocator::set_spill_directory(const QString &spill_directory)
+{
+	lock_guard<mutex> lock(spill_mutex_);
+
+	if (spill_directory == spill_directory_)
+		return;
+
+	spill_directory_ = spill_directory;
+
+	// Start a new scratch file in the new directory, once the current
+	// one holds no more chunks
+	if (spilled_bytes_ == 0)
+		close_spill_file();
+	else
+		spill_directory_changed_ = true;
+}
+
+uint64_t ChunkAllocator::resident_bytes() const
+{
+	return resident_bytes_;
+}
+
+uint64_t ChunkAllocator::spilled_bytes() const
+{
+	return spilled_bytes_;
+}
+
+shared_ptr<uint8_t> ChunkAllocator::allocate_resident(uint64_t size)
+{
+	// Reserve the space within the budget before allocating it, so that
+	// segments filled in parallel cannot overshoot it together
+	const uint64_t budget = ram_budget_;
+	uint64_t resident = resident_bytes_;
+	do {
+		if (budget != 0 && resident + size > budget)
+			return shared_ptr<uint8_t>();
+	} while (!resident_bytes_.compare_exchange_weak(resident,
+		resident + size));
+
+	uint8_t *data;
+	try {
+		// If we're out of memory, this will throw std::bad_alloc
+		data = new uint8_t[size];
+	} catch (bad_alloc&) {
+		resident_bytes_ -= size;
+		throw;
+	}
+
+	return shared_ptr<uint8_t>(data,
+		ResidentDeleter(shared_from_this(), size));
+}
+
+shared_ptr<uint8_t> ChunkAllocator::allocate_spilled(uint64_t size)
+{
+	uint8_t *data;
+
+	{
+		lock_guard<mutex> lock(spill_mutex_);
+
+		if (!spill_file_) {
+			// The file is removed again once it is closed
+			spill_file_ = new QTemporaryFile(
+				spill_directory_ + "/pulseview-XXXXXX.spill");
+			if (!spill_file_->open()) {
+				delete spill_file_;
+				spill_file_ = nullptr;
+				throw bad_alloc();
+			}
+		}
+
+		// Reuse a released chunk of the same size if there is one
+		vector<uint8_t*> &free_chunks = free_chunks_[size];
+		if (!free_chunks.empty()) {
+			data = free_chunks.back();
+			free_chunks.pop_back();
+		} else {
+			// Map another region of the file once the last one is
+			// used up. The rest of the last one is left unused.
+			if (spill_region_free_size_ < size) {
+				const uint64_t offset = spill_file_->size();
+				const uint64_t region_size =
+					max(SpillRegionSize, size);
+				if (!spill_file_->resize(offset + region_size))
+					throw bad_alloc();
+
+				uchar *const region =
+					spill_file_->map(offset, region_size);
+				if (!region) {
+					spill_file_->resize(offset);
+					throw bad_alloc();
+				}
+
+				spill_region_free_ = (uint8_t*)region;
+				spill_region_free_size_ = region_size;
+			}
+
+			data = spill_region_free_;
+			spill_region_free_ += size;
+			spill_region_free_size_ -= size;
+		}
+
+		spilled_bytes_ += size;
+	}
+
+	// The deleter takes the lock again
+	return shared_ptr<uint8_t>(data,
+		SpilledDeleter(shared_from_this(), size));
+}
+
+bool ChunkAllocator::is_spilled(const shared_ptr<uint8_t> &chunk)
+{
+	return get_deleter<SpilledDeleter>(chunk) != nullptr;
+}
+
+void ChunkAllocator::release_spilled(uint8_t *data, uint64_t size)
+{
+	lock_guard<mutex> lock(spill_mutex_);
+
+	free_chunks_[size].push_back(data);
+	spilled_bytes_ -= size;
+
+	// Move to the new spill directory once the old file is empty
+	if (spilled_bytes_ == 0 && spill_directory_changed_)
+		close_spill_file();
+}
+
+void ChunkAllocator::close_spill_file()
+{
+	// Closing the file unmaps all of its regions
+	delete spill_file_;
+	spill_file_ = nullptr;
+	spill_directory_changed_ = false;
+
+	spill_region_free_ = nullptr;
+	spill_region_free_size_ = 0;
+	free_chunks_.clear();
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,128 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CHUNKALLOCATOR_HPP
+#define PULSEVIEW_PV_DATA_CHUNKALLOCATOR_HPP
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QString>
+
+class QTemporaryFile;
+
+namespace pv {
+namespace data {
+
+/**
+ * Provides the storage chunks of the segments of a session.
+ *
+ * Chunks are kept in memory up to the RAM budget. Beyond it segments move
+ * their oldest chunks into a memory-mapped scratch file, from which the
+ * operating system pages them in and out as they are used. The summaries
+ * of the segments are not allocated here, so they always stay in memory.
+ *
+ * The scratch file is mapped in large regions that the spilled chunks are
+ * carved out of, so that spilling does not use up the mappings a process
+ * may have.
+ */
+class ChunkAllocator : public std::enable_shared_from_this<ChunkAllocator>
+{
+private:
+	class ResidentDeleter;
+	class SpilledDeleter;
+
+	/// The size of the regions the scratch file is mapped in
+	static const uint64_t SpillRegionSize;
+
+public:
+	ChunkAllocator();
+
+	~ChunkAllocator();
+
+	/**
+	 * Returns the number of bytes of chunks that may be kept in memory,
+	 * or 0 if there is no limit.
+	 */
+	uint64_t ram_budget() const;
+
+	void set_ram_budget(uint64_t ram_budget);
+
+	/**
+	 * Returns the directory the scratch file is created in. Changes take
+	 * effect once the current scratch file holds no more chunks.
+	 */
+	QString spill_directory() const;
+
+	void set_spill_directory(const QString &spill_directory);
+
+	uint64_t resident_bytes() const;
+
+	uint64_t spilled_bytes() const;
+
+	/**
+	 * Allocates a chunk in memory.
+	 * @return nullptr if the chunk would exceed the RAM budget.
+	 */
+	std::shared_ptr<uint8_t> allocate_resident(uint64_t size);
+
+	/**
+	 * Allocates a chunk in the scratch file.
+	 * @throws std::bad_alloc if the scratch file cannot be extended.
+	 */
+	std::shared_ptr<uint8_t> allocate_spilled(uint64_t size);
+
+	static bool is_spilled(const std::shared_ptr<uint8_t> &chunk);
+
+private:
+	void release_spilled(uint8_t *data, uint64_t size);
+
+	/**
+	 * Closes the scratch file, which removes it. Must be called with the
+	 * spill lock held, once no chunks are left in it.
+	 */
+	void close_spill_file();
+
+private:
+	std::atomic<uint64_t> ram_budget_;
+	std::atomic<uint64_t> resident_bytes_;
+	std::atomic<uint64_t> spilled_bytes_;
+
+	mutable std::mutex spill_mutex_;
+	QString spill_directory_;
+	QTemporaryFile *spill_file_;
+
+	/// Whether the spill directory changed since the file was created
+	bool spill_directory_changed_;
+
+	/// The unused part of the last mapped region of the scratch file
+	uint8_t *spill_region_free_;
+	uint64_t spill_region_free_size_;
+
+	/// The released chunks of the scratch file by size
+	std::map< uint64_t, std::vector<uint8_t*> > free_chunks_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CHUNKALLOCATOR_HPP
@@ -48,6 +48,15 @@ Annotation::Annotation(const srd_proto_data *const pdata) :
 	}
 }
 
+Annotation::Annotation(uint64_t start_sample, uint64_t end_sample,
+	int format, const std::vector<QString> &annotations) :
+	start_sample_(start_sample),
+	end_sample_(end_sample),
+	format_(format),
+	annotations_(annotations)
+{
+}
+
 uint64_t Annotation::start_sample() const
 {
 	return start_sample_;
@@ -68,6 +77,14 @@ const std::vector<QString>& Annotation::annotations() const
 	return annotations_;
 }
 
+uint64_t Annotation::text_size() const
+{
+	uint64_t size = annotations_.capacity() * sizeof(QString);
+	for (const QString &s : annotations_)
+		size += s.capacity() * sizeof(QChar);
+	return size;
+}
+
 } // namespace decode
 } // namespace data
 } // namespace pv
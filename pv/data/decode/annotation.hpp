@@ -22,6 +22,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include <QString>
 
 struct srd_proto_data;
@@ -34,12 +36,20 @@ class Annotation
 {
 public:
 	Annotation(const srd_proto_data *const pdata);
+	Annotation(uint64_t start_sample, uint64_t end_sample, int format,
+		const std::vector<QString> &annotations);
 
 	uint64_t start_sample() const;
 	uint64_t end_sample() const;
 	int format() const;
 	const std::vector<QString>& annotations() const;
 
+	/**
+	 * Returns the number of bytes allocated for the texts of the
+	 * annotation.
+	 */
+	uint64_t text_size() const;
+
 private:
 	uint64_t start_sample_;
 	uint64_t end_sample_;
@@ -0,0 +1,458 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libsigrokdecode/libsigrokdecode.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+#include "annotation.hpp"
+#include "decodeprocess.hpp"
+#include "decoder.hpp"
+#include "message.hpp"
+
+#include <pv/data/logicsegment.hpp>
+#include <pv/data/signalbase.hpp>
+
+#include "config.h"
+
+using std::list;
+using std::min;
+using std::runtime_error;
+using std::shared_ptr;
+using std::string;
+using std::to_string;
+using std::vector;
+
+namespace pv {
+namespace data {
+namespace decode {
+
+namespace {
+
+void write_error(int fd, const char *text)
+{
+	string m;
+	begin_message(m, ErrorMessage);
+	put_string(m, text);
+	end_message(m, 0);
+	write_messages(fd, m);
+}
+
+// The state of the decoders in a worker process
+struct WorkerState
+{
+	vector<srd_decoder_inst*> instances;
+	string output;
+};
+
+void worker_annotation_callback(srd_proto_data *pdata, void *state)
+{
+	assert(pdata);
+	assert(pdata->pdo);
+	WorkerState *const w = (WorkerState*)state;
+
+	const auto inst = std::find(w->instances.begin(), w->instances.end(),
+		pdata->pdo->di);
+	assert(inst != w->instances.end());
+
+	const srd_proto_data_annotation *const pda =
+		(const srd_proto_data_annotation*)pdata->data;
+	assert(pda);
+
+	const size_t offset = w->output.size();
+	begin_message(w->output, AnnotationMessage);
+	put_u32(w->output, inst - w->instances.begin());
+	put_u64(w->output, pdata->start_sample);
+	put_u64(w->output, pdata->end_sample);
+	put_u32(w->output, pda->ann_class);
+
+	uint32_t count = 0;
+	for (const char *const *t = (const char *const *)pda->ann_text; *t; t++)
+		count++;
+	put_u32(w->output, count);
+	for (const char *const *t = (const char *const *)pda->ann_text; *t; t++)
+		put_string(w->output, *t);
+
+	end_message(w->output, offset);
+}
+
+} // anonymous namespace
+
+const char *const DecodeProcess::WorkerOption = "--decode-worker";
+
+const uint64_t DecodeProcess::SlotSize = 256 * 1024;
+const unsigned int DecodeProcess::SlotCount = 4;
+
+DecodeProcess::DecodeProcess(const list< shared_ptr<Decoder> > &stack,
+	uint64_t samplerate, const LogicSegment &segment,
+	AnnotationHandler annotation_handler) :
+	unit_size_(segment.unit_size()),
+	annotation_handler_(annotation_handler),
+	pid_(-1),
+	socket_fd_(-1),
+	slots_(nullptr),
+	next_slot_(0),
+	slots_in_use_(0),
+	samples_decoded_(0)
+{
+	assert(unit_size_ > 0 && unit_size_ <= SlotSize);
+
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+		throw runtime_error("Failed to create the decode worker socket");
+
+	const int memory_fd = memfd_create("pulseview-decode", MFD_CLOEXEC);
+	void *slots = MAP_FAILED;
+	if (memory_fd >= 0 &&
+		ftruncate(memory_fd, SlotSize * SlotCount) == 0)
+		slots = mmap(nullptr, SlotSize * SlotCount,
+			PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd, 0);
+
+	if (slots == MAP_FAILED) {
+		if (memory_fd >= 0)
+			close(memory_fd);
+		close(fds[0]);
+		close(fds[1]);
+		throw runtime_error("Failed to map the decode worker memory");
+	}
+
+	// The arguments are prepared before forking, because the child may
+	// only make async-signal-safe calls until it has executed the worker
+	const string socket_arg = to_string(fds[1]);
+	const string memory_arg = to_string(memory_fd);
+
+	pid_ = fork();
+	if (pid_ == 0) {
+		fcntl(fds[1], F_SETFD, 0);
+		fcntl(memory_fd, F_SETFD, 0);
+		execl("/proc/self/exe", PV_BIN_NAME, WorkerOption,
+			socket_arg.c_str(), memory_arg.c_str(), (char*)nullptr);
+		_exit(127);
+	}
+
+	close(fds[1]);
+	close(memory_fd);
+	socket_fd_ = fds[0];
+	slots_ = (uint8_t*)slots;
+
+	if (pid_ < 0) {
+		stop();
+		throw runtime_error("Failed to start the decode worker");
+	}
+
+	// Describe the stack to the worker
+	string m;
+	begin_message(m, SetupMessage);
+	put_u64(m, samplerate);
+	put_u32(m, unit_size_);
+	put_u64(m, SlotSize);
+	put_u32(m, SlotCount);
+	put_u32(m, stack.size());
+
+	for (const shared_ptr<Decoder> &dec : stack) {
+		put_string(m, dec->decoder()->id);
+
+		put_u32(m, dec->options().size());
+		for (const auto &option : dec->options()) {
+			gchar *const value = g_variant_print(option.second, TRUE);
+			put_string(m, option.first.c_str());
+			put_string(m, value);
+			g_free(value);
+		}
+
+		// Channels that were not captured are left unassigned
+		vector< std::pair<const char*, uint32_t> > channels;
+		for (const auto &channel : dec->channels()) {
+			const int bit = segment.channel_bit(
+				channel.second->index());
+			if (bit >= 0)
+				channels.emplace_back(channel.first->id, bit);
+		}
+
+		put_u32(m, channels.size());
+		for (const auto &channel : channels) {
+			put_string(m, channel.first);
+			put_u32(m, channel.second);
+		}
+	}
+
+	end_message(m, 0);
+
+	try {
+		write_messages(socket_fd_, m);
+	} catch (...) {
+		stop();
+		throw;
+	}
+}
+
+DecodeProcess::~DecodeProcess()
+{
+	stop();
+}
+
+void DecodeProcess::send(uint64_t start_sample, const uint8_t *data,
+	uint64_t sample_count)
+{
+	const uint64_t slot_samples = SlotSize / unit_size_;
+
+	while (sample_count > 0) {
+		while (slots_in_use_ == SlotCount)
+			receive();
+
+		const uint64_t n = min(sample_count, slot_samples);
+		memcpy(slots_ + next_slot_ * SlotSize, data, n * unit_size_);
+
+		string m;
+		begin_message(m, SamplesMessage);
+		put_u32(m, next_slot_);
+		put_u64(m, start_sample);
+		put_u64(m, start_sample + n);
+		end_message(m, 0);
+		write_messages(socket_fd_, m);
+
+		next_slot_ = (next_slot_ + 1) % SlotCount;
+		slots_in_use_++;
+
+		start_sample += n;
+		data += n * unit_size_;
+		sample_count -= n;
+	}
+
+	// Pass on the annotations that are ready without waiting for more
+	pollfd p = {socket_fd_, POLLIN, 0};
+	while (slots_in_use_ > 0 && poll(&p, 1, 0) > 0)
+		receive();
+}
+
+void DecodeProcess::flush()
+{
+	while (slots_in_use_ > 0)
+		receive();
+}
+
+uint64_t DecodeProcess::samples_decoded() const
+{
+	return samples_decoded_;
+}
+
+int DecodeProcess::run_worker(int socket_fd, int memory_fd)
+{
+	uint32_t type;
+	string payload;
+
+	try {
+		if (!read_message(socket_fd, type, payload) ||
+			type != SetupMessage)
+			return 1;
+
+		MessageReader r(payload);
+		const uint64_t samplerate = r.u64();
+		const unsigned int unit_size = r.u32();
+		const uint64_t slot_size = r.u64();
+		const unsigned int slot_count = r.u32();
+
+		const uint8_t *const slots = (const uint8_t*)mmap(nullptr,
+			slot_size * slot_count, PROT_READ, MAP_SHARED, memory_fd, 0);
+		if (slots == MAP_FAILED) {
+			write_error(socket_fd, "Failed to map the decode memory");
+			return 1;
+		}
+
+		if (srd_init(nullptr) != SRD_OK) {
+			write_error(socket_fd, "libsigrokdecode init failed");
+			return 1;
+		}
+
+		srd_session *session;
+		srd_session_new(&session);
+		assert(session);
+
+		WorkerState state;
+		for (uint32_t d = r.u32(); d > 0; d--) {
+			const string id = r.str();
+			const int ret = srd_decoder_load(id.c_str());
+			if (ret != SRD_OK) {
+				write_error(socket_fd, ("Failed to load decoder " +
+					id + ": " + srd_strerror(ret)).c_str());
+				return 1;
+			}
+
+			GHashTable *const opt_hash = g_hash_table_new_full(
+				g_str_hash, g_str_equal, g_free,
+				(GDestroyNotify)g_variant_unref);
+			for (uint32_t o = r.u32(); o > 0; o--) {
+				const string key = r.str();
+				GVariant *const value = g_variant_parse(nullptr,
+					r.str().c_str(), nullptr, nullptr, nullptr);
+				if (value)
+					g_hash_table_replace(opt_hash,
+						g_strdup(key.c_str()), value);
+			}
+
+			srd_decoder_inst *const di = srd_inst_new(
+				session, id.c_str(), opt_hash);
+			g_hash_table_destroy(opt_hash);
+
+			if (!di) {
+				write_error(socket_fd,
+					"Failed to create decoder instance");
+				return 1;
+			}
+
+			GHashTable *const channels = g_hash_table_new_full(
+				g_str_hash, g_str_equal, g_free,
+				(GDestroyNotify)g_variant_unref);
+			for (uint32_t c = r.u32(); c > 0; c--) {
+				const string channel = r.str();
+				GVariant *const gvar = g_variant_new_int32(r.u32());
+				g_variant_ref_sink(gvar);
+				g_hash_table_insert(channels,
+					g_strdup(channel.c_str()), gvar);
+			}
+
+			srd_inst_channel_set_all(di, channels);
+			g_hash_table_destroy(channels);
+
+			if (!state.instances.empty())
+				srd_inst_stack(session, state.instances.back(), di);
+			state.instances.push_back(di);
+		}
+
+		srd_session_metadata_set(session, SRD_CONF_SAMPLERATE,
+			g_variant_new_uint64(samplerate));
+		srd_pd_output_callback_add(session, SRD_OUTPUT_ANN,
+			worker_annotation_callback, &state);
+		srd_session_start(session);
+
+		// Decode the slots until the stack is closed
+		while (read_message(socket_fd, type, payload)) {
+			if (type != SamplesMessage)
+				continue;
+
+			MessageReader s(payload);
+			const uint32_t slot = s.u32();
+			const uint64_t start = s.u64();
+			const uint64_t end = s.u64();
+
+			if (slot >= slot_count ||
+				(end - start) * unit_size > slot_size ||
+				srd_session_send(session, start, end,
+					slots + slot * slot_size,
+					(end - start) * unit_size,
+					unit_size) != SRD_OK) {
+				write_messages(socket_fd, state.output);
+				write_error(socket_fd, "Decoder reported an error");
+				return 1;
+			}
+
+			// The annotations go out before the slot is returned
+			const size_t offset = state.output.size();
+			begin_message(state.output, DoneMessage);
+			put_u64(state.output, end);
+			end_message(state.output, offset);
+
+			write_messages(socket_fd, state.output);
+			state.output.clear();
+		}
+
+		srd_session_destroy(session);
+		srd_exit();
+	} catch (const runtime_error&) {
+		return 1;
+	}
+
+	return 0;
+}
+
+void DecodeProcess::receive()
+{
+	uint32_t type;
+	string payload;
+	if (!read_message(socket_fd_, type, payload))
+		throw runtime_error("The decode worker exited");
+
+	MessageReader r(payload);
+	switch (type) {
+	case AnnotationMessage:
+	{
+		const unsigned int decoder = r.u32();
+		const uint64_t start = r.u64();
+		const uint64_t end = r.u64();
+		const int format = r.u32();
+
+		vector<QString> texts;
+		for (uint32_t t = r.u32(); t > 0; t--) {
+			const string s = r.str();
+			texts.push_back(QString::fromUtf8(s.data(), s.size()));
+		}
+
+		annotation_handler_(decoder,
+			Annotation(start, end, format, texts));
+		break;
+	}
+
+	case DoneMessage:
+		assert(slots_in_use_ > 0);
+		slots_in_use_--;
+		samples_decoded_ = r.u64();
+		break;
+
+	case ErrorMessage:
+		throw runtime_error(r.str());
+
+	default:
+		throw runtime_error("Unexpected decode worker message");
+	}
+}
+
+void DecodeProcess::stop()
+{
+	if (socket_fd_ >= 0) {
+		close(socket_fd_);
+		socket_fd_ = -1;
+	}
+
+	if (pid_ > 0) {
+		kill(pid_, SIGKILL);
+		waitpid(pid_, nullptr, 0);
+		pid_ = -1;
+	}
+
+	if (slots_) {
+		munmap(slots_, SlotSize * SlotCount);
+		slots_ = nullptr;
+	}
+}
+
+} // namespace decode
+} // namespace data
+} // namespace pv
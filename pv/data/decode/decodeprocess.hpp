@@ -0,0 +1,136 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_DECODE_DECODEPROCESS_HPP
+#define PULSEVIEW_PV_DATA_DECODE_DECODEPROCESS_HPP
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace pv {
+namespace data {
+
+class LogicSegment;
+
+namespace decode {
+
+class Annotation;
+class Decoder;
+
+/**
+ * Runs a stack of decoders in a worker process. libsigrokdecode can only
+ * be used by one thread of a process at a time, so decoder stacks that
+ * run in worker processes of their own decode in parallel.
+ *
+ * The worker is this executable, started with @c --decode-worker. The
+ * samples are handed over through a ring of slots in shared memory, and
+ * the worker reports its annotations and the slots it is done with over
+ * a socket.
+ */
+class DecodeProcess
+{
+public:
+	/// Called with the index of the decoder in the stack that made
+	/// an annotation
+	typedef std::function<void (unsigned int, const Annotation&)>
+		AnnotationHandler;
+
+	/// The command line option that starts a worker
+	static const char *const WorkerOption;
+
+private:
+	static const uint64_t SlotSize;
+	static const unsigned int SlotCount;
+
+public:
+	/**
+	 * Starts a worker and sets up @c stack in it to decode the samples
+	 * of @c segment.
+	 * @throws std::runtime_error if the worker could not be started.
+	 */
+	DecodeProcess(const std::list< std::shared_ptr<Decoder> > &stack,
+		uint64_t samplerate, const LogicSegment &segment,
+		AnnotationHandler annotation_handler);
+
+	/**
+	 * Stops the worker, abandoning the samples it has not decoded yet.
+	 */
+	~DecodeProcess();
+
+	/**
+	 * Hands @c sample_count samples over to the worker, the first of
+	 * which is @c start_sample. Waits for the worker whenever all slots
+	 * are in use, and passes the annotations it made meanwhile on to the
+	 * handler.
+	 * @throws std::runtime_error if the worker failed.
+	 */
+	void send(uint64_t start_sample, const uint8_t *data,
+		uint64_t sample_count);
+
+	/**
+	 * Waits until the worker has decoded all samples handed over.
+	 * @throws std::runtime_error if the worker failed.
+	 */
+	void flush();
+
+	/**
+	 * Returns the end of the samples the worker has decoded.
+	 */
+	uint64_t samples_decoded() const;
+
+	/**
+	 * The main function of a worker process, which decodes the samples
+	 * it receives over @c socket_fd from the slots in @c memory_fd.
+	 */
+	static int run_worker(int socket_fd, int memory_fd);
+
+private:
+	/**
+	 * Receives and handles one message from the worker.
+	 */
+	void receive();
+
+	/**
+	 * Closes the socket, ends the worker and unmaps the slots.
+	 */
+	void stop();
+
+private:
+	const unsigned int unit_size_;
+	const AnnotationHandler annotation_handler_;
+
+	pid_t pid_;
+	int socket_fd_;
+	uint8_t *slots_;
+
+	unsigned int next_slot_;
+	unsigned int slots_in_use_;
+	uint64_t samples_decoded_;
+};
+
+} // namespace decode
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_DECODE_DECODEPROCESS_HPP
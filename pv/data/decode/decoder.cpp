@@ -24,6 +24,7 @@
 
 #include "decoder.hpp"
 
+#include <pv/data/logicsegment.hpp>
 #include <pv/data/signalbase.hpp>
 
 using std::set;
@@ -110,7 +111,8 @@ set< shared_ptr<pv::data::Logic> > Decoder::get_data()
 	return data;
 }
 
-srd_decoder_inst* Decoder::create_decoder_inst(srd_session *session) const
+srd_decoder_inst* Decoder::create_decoder_inst(srd_session *session,
+	const LogicSegment &segment) const
 {
 	GHashTable *const opt_hash = g_hash_table_new_full(g_str_hash,
 		g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
@@ -135,7 +137,13 @@ srd_decoder_inst* Decoder::create_decoder_inst(srd_session *session) const
 
 	for (const auto& channel : channels_) {
 		shared_ptr<data::SignalBase> b(channel.second);
-		GVariant *const gvar = g_variant_new_int32(b->index());
+
+		// Channels that were not captured are left unassigned
+		const int bit = segment.channel_bit(b->index());
+		if (bit < 0)
+			continue;
+
+		GVariant *const gvar = g_variant_new_int32(bit);
 		g_variant_ref_sink(gvar);
 		g_hash_table_insert(channels, channel.first->id, gvar);
 	}
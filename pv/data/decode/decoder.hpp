@@ -36,6 +36,7 @@ namespace pv {
 namespace data {
 
 class Logic;
+class LogicSegment;
 class SignalBase;
 
 namespace decode {
@@ -63,8 +64,8 @@ public:
 
 	bool have_required_channels() const;
 
-	srd_decoder_inst* create_decoder_inst(
-		srd_session *session) const;
+	srd_decoder_inst* create_decoder_inst(srd_session *session,
+		const LogicSegment &segment) const;
 
 	std::set< std::shared_ptr<pv::data::Logic> > get_data();
 
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <stdexcept>
+
+#include "message.hpp"
+
+using std::runtime_error;
+using std::string;
+
+namespace pv {
+namespace data {
+namespace decode {
+
+const size_t MessageHeaderLength = 2 * sizeof(uint32_t);
+
+namespace {
+
+// Returns false at the end of the stream, before the first byte
+bool read_all(int fd, char *dest, size_t size)
+{
+	for (size_t offset = 0; offset < size;) {
+		const ssize_t n = ::recv(fd, dest + offset, size - offset, 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n == 0 && offset == 0)
+			return false;
+		if (n <= 0)
+			throw runtime_error("The decode worker exited");
+		offset += n;
+	}
+
+	return true;
+}
+
+} // anonymous namespace
+
+void put_u32(string &m, uint32_t value)
+{
+	m.append((const char*)&value, sizeof(value));
+}
+
+void put_u64(string &m, uint64_t value)
+{
+	m.append((const char*)&value, sizeof(value));
+}
+
+void put_string(string &m, const char *s)
+{
+	const uint32_t length = strlen(s);
+	put_u32(m, length);
+	m.append(s, length);
+}
+
+void begin_message(string &m, MessageType type)
+{
+	put_u32(m, type);
+	put_u32(m, 0);
+}
+
+void end_message(string &m, size_t offset)
+{
+	const uint32_t length = m.size() - offset - MessageHeaderLength;
+	memcpy(&m[offset + sizeof(uint32_t)], &length, sizeof(length));
+}
+
+void write_messages(int fd, const string &data)
+{
+	for (size_t offset = 0; offset < data.size();) {
+		const ssize_t n = ::send(fd, data.data() + offset,
+			data.size() - offset, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			throw runtime_error("The decode worker exited");
+		offset += n;
+	}
+}
+
+bool read_message(int fd, uint32_t &type, string &payload)
+{
+	uint32_t header[2];
+	if (!read_all(fd, (char*)header, sizeof(header)))
+		return false;
+
+	type = header[0];
+	payload.resize(header[1]);
+	if (header[1] > 0 && !read_all(fd, &payload[0], header[1]))
+		throw runtime_error("The decode worker exited");
+
+	return true;
+}
+
+MessageReader::MessageReader(const string &payload) :
+	pos_(payload.data()),
+	end_(payload.data() + payload.size())
+{
+}
+
+uint32_t MessageReader::u32()
+{
+	uint32_t value;
+	take(&value, sizeof(value));
+	return value;
+}
+
+uint64_t MessageReader::u64()
+{
+	uint64_t value;
+	take(&value, sizeof(value));
+	return value;
+}
+
+string MessageReader::str()
+{
+	const uint32_t length = u32();
+	if (length > (size_t)(end_ - pos_))
+		throw runtime_error("Malformed decode worker message");
+	const string s(pos_, length);
+	pos_ += length;
+	return s;
+}
+
+void MessageReader::take(void *dest, size_t size)
+{
+	if (size > (size_t)(end_ - pos_))
+		throw runtime_error("Malformed decode worker message");
+	memcpy(dest, pos_, size);
+	pos_ += size;
+}
+
+} // namespace decode
+} // namespace data
+} // namespace pv
@@ -0,0 +1,116 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_DECODE_MESSAGE_HPP
+#define PULSEVIEW_PV_DATA_DECODE_MESSAGE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace pv {
+namespace data {
+namespace decode {
+
+/**
+ * The messages between a @c DecodeProcess and its worker. Each message is
+ * a header of its type and its payload length, followed by the payload.
+ */
+enum MessageType {
+	SetupMessage,
+	SamplesMessage,
+	AnnotationMessage,
+	DoneMessage,
+	ErrorMessage
+};
+
+/// The length of the header of a message in bytes
+extern const size_t MessageHeaderLength;
+
+void put_u32(std::string &m, uint32_t value);
+
+void put_u64(std::string &m, uint64_t value);
+
+/**
+ * Appends the length of @c s and its characters.
+ */
+void put_string(std::string &m, const char *s);
+
+/**
+ * Appends the header of a message of @c type to @c m.
+ */
+void begin_message(std::string &m, MessageType type);
+
+/**
+ * Fills in the payload length of the last message in @c m, which begins
+ * at @c offset.
+ */
+void end_message(std::string &m, size_t offset);
+
+/**
+ * Writes @c data, which holds one or more whole messages, to the socket
+ * @c fd.
+ * @throws std::runtime_error if the other end has gone away.
+ */
+void write_messages(int fd, const std::string &data);
+
+/**
+ * Reads the next message from the socket @c fd. Returns false at the end
+ * of the stream.
+ * @throws std::runtime_error if the stream ends inside a message.
+ */
+bool read_message(int fd, uint32_t &type, std::string &payload);
+
+/**
+ * Reads the values of a message payload in the order they were put.
+ */
+class MessageReader
+{
+public:
+	MessageReader(const std::string &payload);
+
+	/**
+	 * @throws std::runtime_error if the payload is too short.
+	 */
+	uint32_t u32();
+
+	/**
+	 * @throws std::runtime_error if the payload is too short.
+	 */
+	uint64_t u64();
+
+	/**
+	 * @throws std::runtime_error if the payload is too short.
+	 */
+	std::string str();
+
+private:
+	void take(void *dest, size_t size);
+
+private:
+	const char *pos_;
+	const char *const end_;
+};
+
+} // namespace decode
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_DECODE_MESSAGE_HPP
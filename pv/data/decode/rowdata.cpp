@@ -25,7 +25,8 @@ namespace pv {
 namespace data {
 namespace decode {
 
-RowData::RowData()
+RowData::RowData() :
+	text_size_(0)
 {
 }
 
@@ -49,6 +50,12 @@ void RowData::get_annotation_subset(
 void RowData::push_annotation(const Annotation &a)
 {
 	annotations_.push_back(a);
+	text_size_ += a.text_size();
+}
+
+uint64_t RowData::memory_usage() const
+{
+	return annotations_.capacity() * sizeof(Annotation) + text_size_;
 }
 
 } // decode
@@ -45,8 +45,14 @@ public:
 
 	void push_annotation(const Annotation &a);
 
+	/**
+	 * Returns the number of bytes allocated for the annotations.
+	 */
+	uint64_t memory_usage() const;
+
 private:
 	std::vector<Annotation> annotations_;
+	uint64_t text_size_;
 };
 
 }
@@ -29,6 +29,9 @@
 #include <pv/data/logicsegment.hpp>
 #include <pv/data/decode/decoder.hpp>
 #include <pv/data/decode/annotation.hpp>
+#ifdef ENABLE_DECODE_WORKERS
+#include <pv/data/decode/decodeprocess.hpp>
+#endif
 #include <pv/session.hpp>
 #include <pv/view/logicsignal.hpp>
 
@@ -36,13 +39,13 @@ using std::lock_guard;
 using std::mutex;
 using boost::optional;
 using std::unique_lock;
-using std::deque;
 using std::make_pair;
 using std::max;
 using std::min;
 using std::list;
 using std::map;
 using std::pair;
+using std::runtime_error;
 using std::shared_ptr;
 using std::vector;
 
@@ -54,6 +57,7 @@ namespace data {
 const double DecoderStack::DecodeMargin = 1.0;
 const double DecoderStack::DecodeThreshold = 0.2;
 const int64_t DecoderStack::DecodeChunkLength = 4096;
+const int64_t DecoderStack::DecodePinLength = 1024 * 1024;	// bytes
 const unsigned int DecoderStack::DecodeNotifyPeriod = 1024;
 
 mutex DecoderStack::global_srd_mutex_;
@@ -63,6 +67,8 @@ DecoderStack::DecoderStack(pv::Session &session,
 	session_(session),
 	start_time_(0),
 	samplerate_(0),
+	frame_(0),
+	follow_newest_frame_(true),
 	sample_count_(0),
 	frame_complete_(false),
 	samples_decoded_(0)
@@ -123,6 +129,23 @@ const pv::util::Timestamp& DecoderStack::start_time() const
 	return start_time_;
 }
 
+uint64_t DecoderStack::frame() const
+{
+	return frame_;
+}
+
+void DecoderStack::set_frame(uint64_t frame)
+{
+	const uint64_t frame_count = session_.frame_count();
+	follow_newest_frame_ = (frame_count == 0 || frame + 1 >= frame_count);
+
+	if (frame == frame_ && segment_)
+		return;
+
+	frame_ = frame;
+	begin_decode();
+}
+
 int64_t DecoderStack::samples_decoded() const
 {
 	lock_guard<mutex> decode_lock(output_mutex_);
@@ -197,6 +220,7 @@ void DecoderStack::begin_decode()
 	}
 
 	clear();
+	segment_.reset();
 
 	// Check that all decoders have the required channels
 	for (const shared_ptr<decode::Decoder> &dec : stack_)
@@ -250,12 +274,18 @@ void DecoderStack::begin_decode()
 	if (!data)
 		return;
 
-	// Check we have a segment of data
-	const deque< shared_ptr<pv::data::LogicSegment> > &segments =
-		data->logic_segments();
-	if (segments.empty())
+	// Decode the newest frame unless another one was chosen, if it has
+	// logic samples
+	const uint64_t frame_count = session_.frame_count();
+	if (follow_newest_frame_ && frame_count > 0)
+		frame_ = frame_count - 1;
+	segment_ = data->logic_segment(frame_);
+	if (!segment_)
 		return;
-	segment_ = segments.front();
+
+	// Only the newest frame can still be growing
+	if (frame_ + 1 < frame_count)
+		frame_complete_ = true;
 
 	// Get the samplerate and start time
 	start_time_ = segment_->start_time();
@@ -278,6 +308,17 @@ uint64_t DecoderStack::max_sample_count() const
 	return max_sample_count;
 }
 
+MemoryUsage DecoderStack::memory_usage() const
+{
+	lock_guard<mutex> lock(output_mutex_);
+
+	MemoryUsage usage;
+	for (const auto& row : rows_)
+		usage.annotations += row.second.memory_usage();
+
+	return usage;
+}
+
 optional<int64_t> DecoderStack::wait_for_data() const
 {
 	unique_lock<mutex> input_lock(input_mutex_);
@@ -307,15 +348,38 @@ void DecoderStack::decode_data(
 	const unsigned int chunk_sample_count =
 		DecodeChunkLength / segment_->unit_size();
 
-	for (int64_t i = 0; !interrupt_ && i < sample_count;
-			i += chunk_sample_count) {
+	// Carry on from the last decoded sample, skipping any samples
+	// that have been dropped in roll mode
+	int64_t i;
+	{
+		lock_guard<mutex> lock(output_mutex_);
+		i = samples_decoded_;
+	}
+	i = max(i, (int64_t)segment_->get_first_sample());
+
+	shared_ptr<SegmentPin> pin;
+	int64_t pin_end = 0;
+
+	// Resumed decodes do not start at a multiple of the period, so the
+	// samples since the last notification are counted
+	int64_t notified = i;
+
+	while (!interrupt_ && i < sample_count) {
+		// Keep the samples ahead of the decoder decompressed, for the
+		// views that show them meanwhile
+		if (i >= pin_end) {
+			pin_end = i + DecodePinLength / unit_size;
+			pin = segment_->pin_samples(i, pin_end);
+		}
 
-		const int64_t chunk_end = min(
-			i + chunk_sample_count, sample_count);
-		const uint8_t* chunk = segment_->get_samples(i, chunk_end);
+		// The view points straight into the segment and may end early
+		// at a storage chunk boundary
+		const SegmentDataView chunk = segment_->get_samples(i,
+			min(i + chunk_sample_count, sample_count));
+		const int64_t chunk_end = i + chunk.sample_count();
 
-		if (srd_session_send(session, i, chunk_end, chunk,
-				(chunk_end - i) * unit_size, unit_size) != SRD_OK) {
+		if (srd_session_send(session, i, chunk_end, chunk.data(),
+				chunk.size(), unit_size) != SRD_OK) {
 			error_message_ = tr("Decoder reported an error");
 			break;
 		}
@@ -325,8 +389,12 @@ void DecoderStack::decode_data(
 			samples_decoded_ = chunk_end;
 		}
 
-		if (i % DecodeNotifyPeriod == 0)
+		if (chunk_end - notified >= DecodeNotifyPeriod) {
 			new_decode_data();
+			notified = chunk_end;
+		}
+
+		i = chunk_end;
 	}
 
 	new_decode_data();
@@ -340,6 +408,13 @@ void DecoderStack::decode_proc()
 
 	assert(segment_);
 
+#ifdef ENABLE_DECODE_WORKERS
+	if (session_.decode_worker_processes()) {
+		decode_in_worker();
+		return;
+	}
+#endif
+
 	// Prevent any other decode threads from accessing libsigrokdecode
 	lock_guard<mutex> srd_lock(global_srd_mutex_);
 
@@ -351,7 +426,8 @@ void DecoderStack::decode_proc()
 	const unsigned int unit_size = segment_->unit_size();
 
 	for (const shared_ptr<decode::Decoder> &dec : stack_) {
-		srd_decoder_inst *const di = dec->create_decoder_inst(session);
+		srd_decoder_inst *const di = dec->create_decoder_inst(session,
+			*segment_);
 
 		if (!di) {
 			error_message_ = tr("Failed to create decoder instance");
@@ -388,37 +464,101 @@ void DecoderStack::decode_proc()
 	srd_session_destroy(session);
 }
 
-void DecoderStack::annotation_callback(srd_proto_data *pdata, void *decoder)
+#ifdef ENABLE_DECODE_WORKERS
+void DecoderStack::decode_in_worker()
 {
-	assert(pdata);
-	assert(decoder);
+	vector<const srd_decoder*> decoders;
+	for (const shared_ptr<decode::Decoder> &dec : stack_)
+		decoders.push_back(dec->decoder());
 
-	DecoderStack *const d = (DecoderStack*)decoder;
-	assert(d);
+	optional<int64_t> sample_count;
+	{
+		unique_lock<mutex> input_lock(input_mutex_);
+		sample_count = sample_count_ = segment_->get_sample_count();
+	}
 
-	lock_guard<mutex> lock(d->output_mutex_);
+	try {
+		DecodeProcess process(stack_, (uint64_t)samplerate_,
+			*segment_,
+			[&](unsigned int index, const Annotation &a) {
+				push_annotation(decoders[index], a);
+			});
+
+		do {
+			// Carry on from the last decoded sample, skipping any
+			// samples that have been dropped in roll mode
+			int64_t i;
+			{
+				lock_guard<mutex> lock(output_mutex_);
+				i = samples_decoded_;
+			}
+			i = max(i, (int64_t)segment_->get_first_sample());
+
+			shared_ptr<SegmentPin> pin;
+			int64_t pin_end = 0;
+
+			while (!interrupt_ && i < *sample_count) {
+				if (i >= pin_end) {
+					pin_end = i + DecodePinLength /
+						segment_->unit_size();
+					pin = segment_->pin_samples(i, pin_end);
+				}
+
+				const SegmentDataView chunk =
+					segment_->get_samples(i, *sample_count);
+				process.send(i, chunk.data(), chunk.sample_count());
+				i += chunk.sample_count();
+
+				{
+					lock_guard<mutex> lock(output_mutex_);
+					samples_decoded_ = process.samples_decoded();
+				}
+
+				new_decode_data();
+			}
+
+			if (interrupt_)
+				break;
+
+			// The worker catches up before waiting for more data,
+			// which compares against samples_decoded_
+			process.flush();
+			{
+				lock_guard<mutex> lock(output_mutex_);
+				samples_decoded_ = max(samples_decoded_,
+					(int64_t)process.samples_decoded());
+			}
 
-	const Annotation a(pdata);
+			new_decode_data();
+		} while ((sample_count = wait_for_data()));
+	} catch (const runtime_error &e) {
+		qDebug() << "Decode worker failed:" << e.what();
+		error_message_ = QString::fromUtf8(e.what());
+		new_decode_data();
+	}
+}
+#endif
 
-	// Find the row
-	assert(pdata->pdo);
-	assert(pdata->pdo->di);
-	const srd_decoder *const decc = pdata->pdo->di->decoder;
+void DecoderStack::push_annotation(const srd_decoder *const decc,
+	const Annotation &a)
+{
 	assert(decc);
 
-	auto row_iter = d->rows_.end();
+	lock_guard<mutex> lock(output_mutex_);
+
+	auto row_iter = rows_.end();
 
 	// Try looking up the sub-row of this class
-	const auto r = d->class_rows_.find(make_pair(decc, a.format()));
-	if (r != d->class_rows_.end())
-		row_iter = d->rows_.find((*r).second);
+	const auto r = class_rows_.find(make_pair(decc, a.format()));
+	if (r != class_rows_.end())
+		row_iter = rows_.find((*r).second);
 	else {
 		// Failing that, use the decoder as a key
-		row_iter = d->rows_.find(Row(decc));	
+		row_iter = rows_.find(Row(decc));
 	}
 
-	assert(row_iter != d->rows_.end());
-	if (row_iter == d->rows_.end()) {
+	assert(row_iter != rows_.end());
+	if (row_iter == rows_.end()) {
 		qDebug() << "Unexpected annotation: decoder = " << decc <<
 			", format = " << a.format();
 		assert(0);
@@ -429,9 +569,24 @@ void DecoderStack::annotation_callback(srd_proto_data *pdata, void *decoder)
 	(*row_iter).second.push_annotation(a);
 }
 
+void DecoderStack::annotation_callback(srd_proto_data *pdata, void *decoder)
+{
+	assert(pdata);
+	assert(decoder);
+
+	DecoderStack *const d = (DecoderStack*)decoder;
+	assert(d);
+
+	assert(pdata->pdo);
+	assert(pdata->pdo->di);
+	d->push_annotation(pdata->pdo->di->decoder, Annotation(pdata));
+}
+
 void DecoderStack::on_new_frame()
 {
-	begin_decode();
+	// An older frame that is decoded stays as it is
+	if (follow_newest_frame_)
+		begin_decode();
 }
 
 void DecoderStack::on_data_received()
@@ -448,7 +603,7 @@ void DecoderStack::on_frame_ended()
 {
 	{
 		unique_lock<mutex> lock(input_mutex_);
-		if (segment_)
+		if (segment_ && frame_ + 1 >= session_.frame_count())
 			frame_complete_ = true;
 	}
 	input_cond_.notify_one();
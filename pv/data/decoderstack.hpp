@@ -75,6 +75,7 @@ private:
 	static const double DecodeMargin;
 	static const double DecodeThreshold;
 	static const int64_t DecodeChunkLength;
+	static const int64_t DecodePinLength;
 	static const unsigned int DecodeNotifyPeriod;
 
 public:
@@ -90,6 +91,18 @@ public:
 
 	const pv::util::Timestamp& start_time() const;
 
+	/**
+	 * Returns the number of the frame that is decoded.
+	 * @see Session::frame_count()
+	 */
+	uint64_t frame() const;
+
+	/**
+	 * Decodes a frame, e.g. the one that is shown. The newest frame is
+	 * followed as new frames begin if @c frame is the newest one.
+	 */
+	void set_frame(uint64_t frame);
+
 	int64_t samples_decoded() const;
 
 	std::vector<decode::Row> get_visible_rows() const;
@@ -108,6 +121,11 @@ public:
 
 	uint64_t max_sample_count() const;
 
+	/**
+	 * Returns the memory held by the annotations of all rows.
+	 */
+	MemoryUsage memory_usage() const;
+
 	void begin_decode();
 
 private:
@@ -118,6 +136,20 @@ private:
 
 	void decode_proc();
 
+#ifdef ENABLE_DECODE_WORKERS
+	/**
+	 * Decodes the segment in a worker process, which does not hold
+	 * global_srd_mutex_. @see decode::DecodeProcess
+	 */
+	void decode_in_worker();
+#endif
+
+	/**
+	 * Adds an annotation made by @c decc to its row.
+	 */
+	void push_annotation(const srd_decoder *const decc,
+		const decode::Annotation &a);
+
 	static void annotation_callback(srd_proto_data *pdata,
 		void *decoder);
 
@@ -147,6 +179,8 @@ private:
 
 	std::list< std::shared_ptr<decode::Decoder> > stack_;
 
+	uint64_t frame_;
+	bool follow_newest_frame_;
 	std::shared_ptr<pv::data::LogicSegment> segment_;
 
 	mutable std::mutex input_mutex_;
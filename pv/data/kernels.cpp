@@ -0,0 +1,915 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "kernels.hpp"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define HAVE_SSE2_KERNELS
+#include <emmintrin.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_AVX_KERNELS
+#define HAVE_AVX2_KERNELS
+#include <immintrin.h>
+#endif
+#endif
+
+using std::min;
+
+namespace pv {
+namespace data {
+namespace kernels {
+
+namespace {
+
+/**
+ * Summarizes @c block_count blocks of samples. The sample preceding
+ * @c src must be stored right in front of it.
+ */
+typedef void (*BlockFunction)(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size);
+
+struct LogicKernels
+{
+	BlockFunction transitions;
+	BlockFunction reduce;
+	BlockFunction any_low;
+};
+
+/**
+ * Summarizes @c block_count blocks of analog samples or envelope pairs.
+ */
+typedef void (*EnvelopeFunction)(const float *src, float *dest,
+	uint64_t block_count);
+
+struct AnalogKernels
+{
+	EnvelopeFunction minmax;
+	EnvelopeFunction reduce;
+};
+
+template<unsigned int U> struct Word;
+template<> struct Word<1> { typedef uint8_t type; };
+template<> struct Word<2> { typedef uint16_t type; };
+template<> struct Word<4> { typedef uint32_t type; };
+template<> struct Word<8> { typedef uint64_t type; };
+
+//----- Scalar kernels -----//
+
+void transitions_generic(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		memset(dest, 0, unit_size);
+		for (unsigned int i = 0; i < BlockLength; i++) {
+			for (unsigned int j = 0; j < unit_size; j++)
+				dest[j] |= src[j] ^ (src - unit_size)[j];
+			src += unit_size;
+		}
+		dest += unit_size;
+	}
+}
+
+void reduce_generic(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		memset(dest, 0, unit_size);
+		for (unsigned int i = 0; i < BlockLength; i++) {
+			for (unsigned int j = 0; j < unit_size; j++)
+				dest[j] |= src[j];
+			src += unit_size;
+		}
+		dest += unit_size;
+	}
+}
+
+void any_low_generic(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		memset(dest, 0, unit_size);
+		for (unsigned int i = 0; i < BlockLength; i++) {
+			for (unsigned int j = 0; j < unit_size; j++)
+				dest[j] |= ~src[j];
+			src += unit_size;
+		}
+		dest += unit_size;
+	}
+}
+
+template<unsigned int U>
+void transitions_scalar(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int)
+{
+	typedef typename Word<U>::type T;
+
+	T prev;
+	memcpy(&prev, src - U, U);
+
+	for (uint64_t b = 0; b < block_count; b++) {
+		T accumulator = 0;
+		for (unsigned int i = 0; i < BlockLength; i++) {
+			T sample;
+			memcpy(&sample, src, U);
+			accumulator |= prev ^ sample;
+			prev = sample;
+			src += U;
+		}
+
+		memcpy(dest, &accumulator, U);
+		dest += U;
+	}
+}
+
+template<unsigned int U>
+void reduce_scalar(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int)
+{
+	typedef typename Word<U>::type T;
+
+	for (uint64_t b = 0; b < block_count; b++) {
+		T accumulator = 0;
+		for (unsigned int i = 0; i < BlockLength; i++) {
+			T sample;
+			memcpy(&sample, src, U);
+			accumulator |= sample;
+			src += U;
+		}
+
+		memcpy(dest, &accumulator, U);
+		dest += U;
+	}
+}
+
+template<unsigned int U>
+void any_low_scalar(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int)
+{
+	typedef typename Word<U>::type T;
+
+	for (uint64_t b = 0; b < block_count; b++) {
+		T accumulator = 0;
+		for (unsigned int i = 0; i < BlockLength; i++) {
+			T sample;
+			memcpy(&sample, src, U);
+			accumulator |= (T)~sample;
+			src += U;
+		}
+
+		memcpy(dest, &accumulator, U);
+		dest += U;
+	}
+}
+
+#ifdef HAVE_SSE2_KERNELS
+
+//----- SSE2 kernels -----//
+
+// A block of 16 samples of U bytes occupies exactly U 128-bit words.
+// The words of a block are OR'ed together, and the resulting word is then
+// folded onto itself until only one sample of U bytes remains.
+
+template<unsigned int U>
+inline void store_folded(uint8_t *dest, __m128i v)
+{
+	v = _mm_or_si128(v, _mm_srli_si128(v, 8));
+	if (U < 8)
+		v = _mm_or_si128(v, _mm_srli_si128(v, 4));
+	if (U < 4)
+		v = _mm_or_si128(v, _mm_srli_si128(v, 2));
+	if (U < 2)
+		v = _mm_or_si128(v, _mm_srli_si128(v, 1));
+
+	uint64_t word;
+	_mm_storel_epi64((__m128i*)&word, v);
+	memcpy(dest, &word, U);
+}
+
+template<unsigned int U>
+void transitions_sse2(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		__m128i accumulator = _mm_setzero_si128();
+		for (unsigned int i = 0; i < U; i++) {
+			const __m128i sample = _mm_loadu_si128(
+				(const __m128i*)(src + i * 16));
+			const __m128i prev = _mm_loadu_si128(
+				(const __m128i*)(src + i * 16 - U));
+			accumulator = _mm_or_si128(accumulator,
+				_mm_xor_si128(sample, prev));
+		}
+
+		store_folded<U>(dest, accumulator);
+		src += BlockLength * U;
+		dest += U;
+	}
+}
+
+template<unsigned int U>
+void reduce_sse2(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		__m128i accumulator = _mm_setzero_si128();
+		for (unsigned int i = 0; i < U; i++)
+			accumulator = _mm_or_si128(accumulator,
+				_mm_loadu_si128((const __m128i*)(src + i * 16)));
+
+		store_folded<U>(dest, accumulator);
+		src += BlockLength * U;
+		dest += U;
+	}
+}
+
+template<unsigned int U>
+void any_low_sse2(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int)
+{
+	const __m128i ones = _mm_set1_epi32(-1);
+
+	for (uint64_t b = 0; b < block_count; b++) {
+		__m128i accumulator = _mm_setzero_si128();
+		for (unsigned int i = 0; i < U; i++)
+			accumulator = _mm_or_si128(accumulator, _mm_xor_si128(
+				_mm_loadu_si128((const __m128i*)(src + i * 16)),
+				ones));
+
+		store_folded<U>(dest, accumulator);
+		src += BlockLength * U;
+		dest += U;
+	}
+}
+
+#endif // HAVE_SSE2_KERNELS
+
+#ifdef HAVE_AVX2_KERNELS
+
+//----- AVX2 kernels -----//
+
+// For one-byte samples a 256-bit word holds two blocks, one per 128-bit
+// lane. The lanes are folded separately, which yields two output samples.
+// For wider samples a block spans U/2 256-bit words, whose lanes are
+// OR'ed together and folded like in the SSE2 kernels.
+
+__attribute__((target("avx2")))
+inline void store_folded_lanes(uint8_t *dest, __m256i v)
+{
+	v = _mm256_or_si256(v, _mm256_srli_si256(v, 8));
+	v = _mm256_or_si256(v, _mm256_srli_si256(v, 4));
+	v = _mm256_or_si256(v, _mm256_srli_si256(v, 2));
+	v = _mm256_or_si256(v, _mm256_srli_si256(v, 1));
+
+	dest[0] = _mm_cvtsi128_si32(_mm256_castsi256_si128(v));
+	dest[1] = _mm_cvtsi128_si32(_mm256_extracti128_si256(v, 1));
+}
+
+template<unsigned int U>
+__attribute__((target("avx2")))
+void transitions_avx2(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size)
+{
+	if (U == 1) {
+		for (; block_count >= 2; block_count -= 2) {
+			const __m256i sample = _mm256_loadu_si256(
+				(const __m256i*)src);
+			const __m256i prev = _mm256_loadu_si256(
+				(const __m256i*)(src - 1));
+			store_folded_lanes(dest, _mm256_xor_si256(sample, prev));
+			src += 2 * BlockLength;
+			dest += 2;
+		}
+
+		transitions_sse2<U>(src, dest, block_count, unit_size);
+		return;
+	}
+
+	for (uint64_t b = 0; b < block_count; b++) {
+		__m256i accumulator = _mm256_setzero_si256();
+		for (unsigned int i = 0; i < U / 2; i++) {
+			const __m256i sample = _mm256_loadu_si256(
+				(const __m256i*)(src + i * 32));
+			const __m256i prev = _mm256_loadu_si256(
+				(const __m256i*)(src + i * 32 - U));
+			accumulator = _mm256_or_si256(accumulator,
+				_mm256_xor_si256(sample, prev));
+		}
+
+		store_folded<U>(dest, _mm_or_si128(
+			_mm256_castsi256_si128(accumulator),
+			_mm256_extracti128_si256(accumulator, 1)));
+		src += BlockLength * U;
+		dest += U;
+	}
+}
+
+template<unsigned int U>
+__attribute__((target("avx2")))
+void reduce_avx2(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size)
+{
+	if (U == 1) {
+		for (; block_count >= 2; block_count -= 2) {
+			store_folded_lanes(dest,
+				_mm256_loadu_si256((const __m256i*)src));
+			src += 2 * BlockLength;
+			dest += 2;
+		}
+
+		reduce_sse2<U>(src, dest, block_count, unit_size);
+		return;
+	}
+
+	for (uint64_t b = 0; b < block_count; b++) {
+		__m256i accumulator = _mm256_setzero_si256();
+		for (unsigned int i = 0; i < U / 2; i++)
+			accumulator = _mm256_or_si256(accumulator,
+				_mm256_loadu_si256((const __m256i*)(src + i * 32)));
+
+		store_folded<U>(dest, _mm_or_si128(
+			_mm256_castsi256_si128(accumulator),
+			_mm256_extracti128_si256(accumulator, 1)));
+		src += BlockLength * U;
+		dest += U;
+	}
+}
+
+template<unsigned int U>
+__attribute__((target("avx2")))
+void any_low_avx2(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size)
+{
+	const __m256i ones = _mm256_set1_epi32(-1);
+
+	if (U == 1) {
+		for (; block_count >= 2; block_count -= 2) {
+			store_folded_lanes(dest, _mm256_xor_si256(
+				_mm256_loadu_si256((const __m256i*)src), ones));
+			src += 2 * BlockLength;
+			dest += 2;
+		}
+
+		any_low_sse2<U>(src, dest, block_count, unit_size);
+		return;
+	}
+
+	for (uint64_t b = 0; b < block_count; b++) {
+		__m256i accumulator = _mm256_setzero_si256();
+		for (unsigned int i = 0; i < U / 2; i++)
+			accumulator = _mm256_or_si256(accumulator,
+				_mm256_xor_si256(_mm256_loadu_si256(
+					(const __m256i*)(src + i * 32)), ones));
+
+		store_folded<U>(dest, _mm_or_si128(
+			_mm256_castsi256_si128(accumulator),
+			_mm256_extracti128_si256(accumulator, 1)));
+		src += BlockLength * U;
+		dest += U;
+	}
+}
+
+#endif // HAVE_AVX2_KERNELS
+
+//----- Scalar analog kernels -----//
+
+void envelope_minmax_generic(const float *src, float *dest,
+	uint64_t block_count)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		float lo = src[0], hi = src[0];
+		for (unsigned int i = 1; i < BlockLength; i++) {
+			lo = (src[i] < lo) ? src[i] : lo;
+			hi = (src[i] > hi) ? src[i] : hi;
+		}
+
+		dest[0] = lo;
+		dest[1] = hi;
+		src += BlockLength;
+		dest += 2;
+	}
+}
+
+#ifndef HAVE_SSE2_KERNELS
+// The SSE kernels need no scalar tail for the higher levels
+void envelope_reduce_generic(const float *src, float *dest,
+	uint64_t block_count)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		float lo = src[0], hi = src[1];
+		for (unsigned int i = 1; i < BlockLength; i++) {
+			lo = (src[2 * i] < lo) ? src[2 * i] : lo;
+			hi = (src[2 * i + 1] > hi) ? src[2 * i + 1] : hi;
+		}
+
+		dest[0] = lo;
+		dest[1] = hi;
+		src += 2 * BlockLength;
+		dest += 2;
+	}
+}
+#endif
+
+#ifdef HAVE_SSE2_KERNELS
+
+//----- SSE analog kernels -----//
+
+// Level 0 works on four blocks at a time. Each block is first reduced to
+// one vector of minima and one of maxima. Transposing the four vectors
+// lines up the lanes of every block, so that a vertical min and max yield
+// the results of all four blocks at once.
+
+inline void store_envelopes(float *dest, __m128 lo[4], __m128 hi[4])
+{
+	_MM_TRANSPOSE4_PS(lo[0], lo[1], lo[2], lo[3]);
+	_MM_TRANSPOSE4_PS(hi[0], hi[1], hi[2], hi[3]);
+
+	const __m128 mn = _mm_min_ps(_mm_min_ps(lo[0], lo[1]),
+		_mm_min_ps(lo[2], lo[3]));
+	const __m128 mx = _mm_max_ps(_mm_max_ps(hi[0], hi[1]),
+		_mm_max_ps(hi[2], hi[3]));
+
+	_mm_storeu_ps(dest, _mm_unpacklo_ps(mn, mx));
+	_mm_storeu_ps(dest + 4, _mm_unpackhi_ps(mn, mx));
+}
+
+// Envelope pairs are stored as (min, max), so the even lanes of the
+// minima and the odd lanes of the maxima hold the results.
+
+inline void store_envelope(float *dest, __m128 lo, __m128 hi)
+{
+	lo = _mm_min_ps(lo, _mm_movehl_ps(lo, lo));
+	hi = _mm_max_ps(hi, _mm_movehl_ps(hi, hi));
+	_mm_storel_pi((__m64*)dest, _mm_move_ss(hi, lo));
+}
+
+void envelope_minmax_sse(const float *src, float *dest,
+	uint64_t block_count)
+{
+	for (; block_count >= 4; block_count -= 4) {
+		__m128 lo[4], hi[4];
+		for (unsigned int j = 0; j < 4; j++) {
+			const float *const s = src + j * BlockLength;
+			const __m128 v0 = _mm_loadu_ps(s);
+			const __m128 v1 = _mm_loadu_ps(s + 4);
+			const __m128 v2 = _mm_loadu_ps(s + 8);
+			const __m128 v3 = _mm_loadu_ps(s + 12);
+			lo[j] = _mm_min_ps(_mm_min_ps(v0, v1), _mm_min_ps(v2, v3));
+			hi[j] = _mm_max_ps(_mm_max_ps(v0, v1), _mm_max_ps(v2, v3));
+		}
+
+		store_envelopes(dest, lo, hi);
+		src += 4 * BlockLength;
+		dest += 8;
+	}
+
+	envelope_minmax_generic(src, dest, block_count);
+}
+
+void envelope_reduce_sse(const float *src, float *dest,
+	uint64_t block_count)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		__m128 lo = _mm_loadu_ps(src);
+		__m128 hi = lo;
+		for (unsigned int i = 4; i < 2 * BlockLength; i += 4) {
+			const __m128 v = _mm_loadu_ps(src + i);
+			lo = _mm_min_ps(lo, v);
+			hi = _mm_max_ps(hi, v);
+		}
+
+		store_envelope(dest, lo, hi);
+		src += 2 * BlockLength;
+		dest += 2;
+	}
+}
+
+#endif // HAVE_SSE2_KERNELS
+
+#ifdef HAVE_AVX_KERNELS
+
+//----- AVX analog kernels -----//
+
+// The 256-bit minima and maxima of a block are folded to 128 bits and
+// then finished like in the SSE kernels.
+
+__attribute__((target("avx")))
+void envelope_minmax_avx(const float *src, float *dest,
+	uint64_t block_count)
+{
+	for (; block_count >= 4; block_count -= 4) {
+		__m128 lo[4], hi[4];
+		for (unsigned int j = 0; j < 4; j++) {
+			const float *const s = src + j * BlockLength;
+			const __m256 v0 = _mm256_loadu_ps(s);
+			const __m256 v1 = _mm256_loadu_ps(s + 8);
+			const __m256 l = _mm256_min_ps(v0, v1);
+			const __m256 h = _mm256_max_ps(v0, v1);
+			lo[j] = _mm_min_ps(_mm256_castps256_ps128(l),
+				_mm256_extractf128_ps(l, 1));
+			hi[j] = _mm_max_ps(_mm256_castps256_ps128(h),
+				_mm256_extractf128_ps(h, 1));
+		}
+
+		store_envelopes(dest, lo, hi);
+		src += 4 * BlockLength;
+		dest += 8;
+	}
+
+	envelope_minmax_generic(src, dest, block_count);
+}
+
+__attribute__((target("avx")))
+void envelope_reduce_avx(const float *src, float *dest,
+	uint64_t block_count)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		__m256 l = _mm256_loadu_ps(src);
+		__m256 h = l;
+		for (unsigned int i = 8; i < 2 * BlockLength; i += 8) {
+			const __m256 v = _mm256_loadu_ps(src + i);
+			l = _mm256_min_ps(l, v);
+			h = _mm256_max_ps(h, v);
+		}
+
+		store_envelope(dest,
+			_mm_min_ps(_mm256_castps256_ps128(l),
+				_mm256_extractf128_ps(l, 1)),
+			_mm_max_ps(_mm256_castps256_ps128(h),
+				_mm256_extractf128_ps(h, 1)));
+		src += 2 * BlockLength;
+		dest += 2;
+	}
+}
+
+#endif // HAVE_AVX_KERNELS
+
+//----- Running sums -----//
+
+#ifdef HAVE_SSE2_KERNELS
+
+// The samples are widened to doubles two at a time. The sums and the sums
+// of squares are accumulated in separate vectors, which are added
+// horizontally at the end of each block.
+
+void block_sums(const float *src, double *dest, uint64_t block_count)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		__m128d sum = _mm_setzero_pd(), sum_sq = _mm_setzero_pd();
+		for (unsigned int i = 0; i < BlockLength; i += 4) {
+			const __m128 v = _mm_loadu_ps(src + i);
+			const __m128d lo = _mm_cvtps_pd(v);
+			const __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+			sum = _mm_add_pd(sum, _mm_add_pd(lo, hi));
+			sum_sq = _mm_add_pd(sum_sq, _mm_add_pd(
+				_mm_mul_pd(lo, lo), _mm_mul_pd(hi, hi)));
+		}
+
+		_mm_storeu_pd(dest, _mm_add_pd(_mm_unpacklo_pd(sum, sum_sq),
+			_mm_unpackhi_pd(sum, sum_sq)));
+		src += BlockLength;
+		dest += 2;
+	}
+}
+
+#else
+
+void block_sums(const float *src, double *dest, uint64_t block_count)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		double sum = 0, sum_sq = 0;
+		for (unsigned int i = 0; i < BlockLength; i++) {
+			sum += src[i];
+			sum_sq += (double)src[i] * src[i];
+		}
+
+		dest[0] = sum;
+		dest[1] = sum_sq;
+		src += BlockLength;
+		dest += 2;
+	}
+}
+
+#endif // HAVE_SSE2_KERNELS
+
+//----- De-interleaving -----//
+
+/**
+ * The number of samples per channel that are de-interleaved at a time.
+ * A tile of 16 channels fits into 16KiB.
+ */
+const uint64_t DeinterleaveTileLength = 256;
+
+void deinterleave_generic(const float *src, float *const *dest,
+	unsigned int channel_count, uint64_t offset, uint64_t sample_count)
+{
+	for (unsigned int c = 0; c < channel_count; c++) {
+		const float *s = src + c;
+		float *d = dest[c] + offset;
+		for (uint64_t i = 0; i < sample_count; i++) {
+			d[i] = *s;
+			s += channel_count;
+		}
+	}
+}
+
+#ifdef HAVE_SSE2_KERNELS
+
+// Two channels are split by shuffling the even and the odd lanes of two
+// vectors apart. Multiples of four channels are transposed in 4x4 tiles.
+
+uint64_t deinterleave_sse(const float *src, float *const *dest,
+	unsigned int channel_count, uint64_t offset, uint64_t sample_count)
+{
+	uint64_t i = 0;
+
+	if (channel_count == 2) {
+		float *const d0 = dest[0] + offset;
+		float *const d1 = dest[1] + offset;
+		for (; i + 4 <= sample_count; i += 4) {
+			const __m128 v0 = _mm_loadu_ps(src + i * 2);
+			const __m128 v1 = _mm_loadu_ps(src + i * 2 + 4);
+			_mm_storeu_ps(d0 + i,
+				_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(d1 + i,
+				_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+	} else if (channel_count % 4 == 0) {
+		for (; i + 4 <= sample_count; i += 4)
+			for (unsigned int c = 0; c < channel_count; c += 4) {
+				const float *const s = src + i * channel_count + c;
+				__m128 v0 = _mm_loadu_ps(s);
+				__m128 v1 = _mm_loadu_ps(s + channel_count);
+				__m128 v2 = _mm_loadu_ps(s + channel_count * 2);
+				__m128 v3 = _mm_loadu_ps(s + channel_count * 3);
+				_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+				_mm_storeu_ps(dest[c] + offset + i, v0);
+				_mm_storeu_ps(dest[c + 1] + offset + i, v1);
+				_mm_storeu_ps(dest[c + 2] + offset + i, v2);
+				_mm_storeu_ps(dest[c + 3] + offset + i, v3);
+			}
+	}
+
+	return i;
+}
+
+#endif // HAVE_SSE2_KERNELS
+
+//----- Dispatch -----//
+
+template<unsigned int U>
+LogicKernels select_kernels()
+{
+#ifdef HAVE_AVX2_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return LogicKernels{transitions_avx2<U>, reduce_avx2<U>,
+			any_low_avx2<U>};
+#endif
+#ifdef HAVE_SSE2_KERNELS
+	return LogicKernels{transitions_sse2<U>, reduce_sse2<U>,
+		any_low_sse2<U>};
+#else
+	return LogicKernels{transitions_scalar<U>, reduce_scalar<U>,
+		any_low_scalar<U>};
+#endif
+}
+
+const LogicKernels& logic_kernels(unsigned int unit_size)
+{
+	static const LogicKernels generic = {
+		transitions_generic, reduce_generic, any_low_generic};
+	static const LogicKernels kernels[] = {
+		generic,
+		select_kernels<1>(),
+		select_kernels<2>(),
+		generic,
+		select_kernels<4>(),
+		generic,
+		generic,
+		generic,
+		select_kernels<8>()
+	};
+
+	return (unit_size < sizeof(kernels) / sizeof(kernels[0])) ?
+		kernels[unit_size] : generic;
+}
+
+AnalogKernels select_analog_kernels()
+{
+#ifdef HAVE_AVX_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx"))
+		return AnalogKernels{envelope_minmax_avx, envelope_reduce_avx};
+#endif
+#ifdef HAVE_SSE2_KERNELS
+	return AnalogKernels{envelope_minmax_sse, envelope_reduce_sse};
+#else
+	return AnalogKernels{envelope_minmax_generic, envelope_reduce_generic};
+#endif
+}
+
+const AnalogKernels& analog_kernels()
+{
+	static const AnalogKernels kernels = select_analog_kernels();
+	return kernels;
+}
+
+} // anonymous namespace
+
+void logic_mipmap_transitions(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size,
+	const uint8_t *prev_sample)
+{
+	assert(unit_size > 0);
+
+	if (block_count == 0)
+		return;
+
+	// The first sample is compared with prev_sample, which need not be
+	// stored in front of src. The kernels read the preceding sample
+	// straight from memory for all further samples.
+	for (unsigned int j = 0; j < unit_size; j++)
+		dest[j] = src[j] ^ prev_sample[j];
+	for (unsigned int i = 1; i < BlockLength; i++)
+		for (unsigned int j = 0; j < unit_size; j++)
+			dest[j] |= src[i * unit_size + j] ^
+				src[(i - 1) * unit_size + j];
+
+	logic_kernels(unit_size).transitions(src + BlockLength * unit_size,
+		dest + unit_size, block_count - 1, unit_size);
+}
+
+void logic_mipmap_reduce(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size)
+{
+	assert(unit_size > 0);
+
+	logic_kernels(unit_size).reduce(src, dest, block_count, unit_size);
+}
+
+void logic_mipmap_any_low(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size)
+{
+	assert(unit_size > 0);
+
+	logic_kernels(unit_size).any_low(src, dest, block_count, unit_size);
+}
+
+void logic_edge_counts_reduce(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int channel_count)
+{
+	assert(channel_count > 0);
+
+	for (uint64_t b = 0; b < block_count; b++) {
+		for (unsigned int c = 0; c < channel_count; c++) {
+			unsigned int count = 0;
+			for (unsigned int i = 0; i < BlockLength; i++)
+				count += src[i * channel_count + c];
+			dest[c] = min(count, 255U);
+		}
+
+		src += BlockLength * channel_count;
+		dest += channel_count;
+	}
+}
+
+void analog_envelope_minmax(const float *src, float *dest,
+	uint64_t block_count)
+{
+	analog_kernels().minmax(src, dest, block_count);
+}
+
+void analog_envelope_reduce(const float *src, float *dest,
+	uint64_t block_count)
+{
+	analog_kernels().reduce(src, dest, block_count);
+}
+
+void analog_block_sums(const float *src, double *dest,
+	uint64_t block_count)
+{
+	block_sums(src, dest, block_count);
+}
+
+void analog_sums_reduce(const double *src, double *dest,
+	uint64_t block_count)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		double sum = 0, sum_sq = 0;
+		for (unsigned int i = 0; i < BlockLength; i++) {
+			sum += src[2 * i];
+			sum_sq += src[2 * i + 1];
+		}
+
+		dest[0] = sum;
+		dest[1] = sum_sq;
+		src += 2 * BlockLength;
+		dest += 2;
+	}
+}
+
+void analog_deinterleave(const float *src, float *const *dest,
+	unsigned int channel_count, uint64_t sample_count)
+{
+	assert(channel_count > 0);
+
+	for (uint64_t offset = 0; offset < sample_count;) {
+		const uint64_t n = min(sample_count - offset,
+			DeinterleaveTileLength);
+		const float *const tile = src + offset * channel_count;
+		uint64_t done = 0;
+
+#ifdef HAVE_SSE2_KERNELS
+		done = deinterleave_sse(tile, dest, channel_count, offset, n);
+#endif
+		deinterleave_generic(tile + done * channel_count, dest,
+			channel_count, offset + done, n - done);
+
+		offset += n;
+	}
+}
+
+void analog_float_to_int16(const float *src, int16_t *dest,
+	uint64_t sample_count, float scale, float offset)
+{
+	assert(scale != 0);
+
+	const float inv_scale = 1.0f / scale;
+	uint64_t i = 0;
+
+#ifdef HAVE_SSE2_KERNELS
+	// The values are clamped before the conversion, which would turn
+	// large values into INT32_MIN
+	const __m128 lo = _mm_set1_ps(INT16_MIN);
+	const __m128 hi = _mm_set1_ps(INT16_MAX);
+	const __m128 o = _mm_set1_ps(offset);
+	const __m128 s = _mm_set1_ps(inv_scale);
+	for (; i + 8 <= sample_count; i += 8) {
+		const __m128 v0 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(
+			_mm_sub_ps(_mm_loadu_ps(src + i), o), s), lo), hi);
+		const __m128 v1 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(
+			_mm_sub_ps(_mm_loadu_ps(src + i + 4), o), s), lo), hi);
+		_mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(
+			_mm_cvtps_epi32(v0), _mm_cvtps_epi32(v1)));
+	}
+#endif
+
+	for (; i < sample_count; i++) {
+		float v = (src[i] - offset) * inv_scale;
+		v = (v > INT16_MIN) ? v : INT16_MIN;
+		v = (v < INT16_MAX) ? v : INT16_MAX;
+		dest[i] = (int16_t)nearbyintf(v);
+	}
+}
+
+void analog_int16_to_float(const int16_t *src, float *dest,
+	uint64_t sample_count, float scale, float offset)
+{
+	uint64_t i = 0;
+
+#ifdef HAVE_SSE2_KERNELS
+	const __m128 o = _mm_set1_ps(offset);
+	const __m128 s = _mm_set1_ps(scale);
+	for (; i + 8 <= sample_count; i += 8) {
+		const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+
+		// Sign-extend the samples to 32 bits
+		const __m128i v0 = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		const __m128i v1 = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		_mm_storeu_ps(dest + i,
+			_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(v0), s), o));
+		_mm_storeu_ps(dest + i + 4,
+			_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(v1), s), o));
+	}
+#endif
+
+	for (; i < sample_count; i++)
+		dest[i] = src[i] * scale + offset;
+}
+
+} // namespace kernels
+} // namespace data
+} // namespace pv
@@ -0,0 +1,181 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_KERNELS_HPP
+#define PULSEVIEW_PV_DATA_KERNELS_HPP
+
+#include <cstdint>
+
+namespace pv {
+namespace data {
+namespace kernels {
+
+/**
+ * The number of input samples that are summarized into one output sample
+ * by the mip-map kernels.
+ */
+static const unsigned int BlockLength = 16;
+
+/**
+ * Builds level 0 of a logic mip-map. Each output sample is the OR of the
+ * XORs of every input sample in its block with the sample preceding it,
+ * i.e. it has a bit set for every channel that changed within the block.
+ *
+ * SSE2 and AVX2 implementations are used for unit sizes of 1, 2, 4 and 8
+ * bytes when the CPU supports them. Other unit sizes use a scalar loop.
+ *
+ * @param[in] src The first sample of the input blocks. The input must be
+ * 	stored contiguously.
+ * @param[out] dest The output samples, one per block.
+ * @param[in] block_count The number of blocks to summarize.
+ * @param[in] unit_size The size of one sample in bytes.
+ * @param[in] prev_sample The sample that precedes the first input sample.
+ */
+void logic_mipmap_transitions(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size,
+	const uint8_t *prev_sample);
+
+/**
+ * Builds a higher level of a logic mip-map. Each output sample is the OR
+ * of all the samples in its block of the level below.
+ *
+ * Applied to the raw samples, this yields level 0 of the "any high" mip-map,
+ * which has a bit set for every channel that is high anywhere in the block.
+ *
+ * @param[in] src The first sample of the input blocks.
+ * @param[out] dest The output samples, one per block.
+ * @param[in] block_count The number of blocks to summarize.
+ * @param[in] unit_size The size of one sample in bytes.
+ */
+void logic_mipmap_reduce(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size);
+
+/**
+ * Builds level 0 of the "any low" mip-map of a logic signal. Each output
+ * sample is the OR of the complements of the input samples in its block,
+ * i.e. it has a bit set for every channel that is low anywhere in the
+ * block. Higher levels are built with @c logic_mipmap_reduce().
+ *
+ * @param[in] src The first sample of the input blocks. The input must be
+ * 	stored contiguously.
+ * @param[out] dest The output samples, one per block.
+ * @param[in] block_count The number of blocks to summarize.
+ * @param[in] unit_size The size of one sample in bytes.
+ */
+void logic_mipmap_any_low(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size);
+
+/**
+ * Builds a higher level of the edge counts of a logic mip-map. Each output
+ * sample holds one count per channel, the sum of the counts of the channel
+ * in its block of the level below. The counts saturate at 255.
+ *
+ * @param[in] src The first sample of the input blocks.
+ * @param[out] dest The output samples, one per block.
+ * @param[in] block_count The number of blocks to summarize.
+ * @param[in] channel_count The number of counts in one sample.
+ */
+void logic_edge_counts_reduce(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int channel_count);
+
+/**
+ * Builds level 0 of an analog envelope. Each output sample is the pair of
+ * the minimum and the maximum of the input samples in its block, which
+ * are found in a single pass over the input.
+ *
+ * SSE and AVX implementations are used when the CPU supports them.
+ *
+ * @param[in] src The first sample of the input blocks. The input must be
+ * 	stored contiguously.
+ * @param[out] dest The output samples, one (min, max) pair per block.
+ * @param[in] block_count The number of blocks to summarize.
+ */
+void analog_envelope_minmax(const float *src, float *dest,
+	uint64_t block_count);
+
+/**
+ * Builds a higher level of an analog envelope. Each output sample is the
+ * pair of the smallest minimum and the largest maximum of the
+ * (min, max) pairs in its block of the level below.
+ *
+ * @param[in] src The first (min, max) pair of the input blocks.
+ * @param[out] dest The output samples, one (min, max) pair per block.
+ * @param[in] block_count The number of blocks to summarize.
+ */
+void analog_envelope_reduce(const float *src, float *dest,
+	uint64_t block_count);
+
+/**
+ * Builds level 0 of the running sums of an analog signal. Each output
+ * sample is the pair of the sum and the sum of squares of the input
+ * samples in its block, accumulated in double precision.
+ *
+ * @param[in] src The first sample of the input blocks. The input must be
+ * 	stored contiguously.
+ * @param[out] dest The output samples, one (sum, sum of squares) pair
+ * 	per block.
+ * @param[in] block_count The number of blocks to summarize.
+ */
+void analog_block_sums(const float *src, double *dest,
+	uint64_t block_count);
+
+/**
+ * Builds a higher level of the running sums. Each output sample is the
+ * pairwise sum of the (sum, sum of squares) pairs in its block of the
+ * level below.
+ */
+void analog_sums_reduce(const double *src, double *dest,
+	uint64_t block_count);
+
+/**
+ * Splits a packet of interleaved analog samples into one contiguous run
+ * of samples per channel. The packet is read once, in tiles that stay in
+ * the cache while they are written out.
+ *
+ * SSE implementations are used for two channels and for multiples of
+ * four channels. Other channel counts use a scalar loop.
+ *
+ * @param[in] src The first sample of the packet.
+ * @param[out] dest The destination of the samples of every channel.
+ * @param[in] channel_count The number of interleaved channels.
+ * @param[in] sample_count The number of samples per channel.
+ */
+void analog_deinterleave(const float *src, float *const *dest,
+	unsigned int channel_count, uint64_t sample_count);
+
+/**
+ * Converts analog samples to 16-bit integers, so that
+ * <tt>sample = dest * scale + offset</tt>. The results are rounded to the
+ * nearest integer and saturate at the limits of the integer range.
+ */
+void analog_float_to_int16(const float *src, int16_t *dest,
+	uint64_t sample_count, float scale, float offset);
+
+/**
+ * Converts 16-bit integers back to analog samples, as
+ * <tt>dest = src * scale + offset</tt>.
+ */
+void analog_int16_to_float(const int16_t *src, float *dest,
+	uint64_t sample_count, float scale, float offset);
+
+} // namespace kernels
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_KERNELS_HPP
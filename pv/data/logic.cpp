@@ -22,8 +22,9 @@
 #include "logic.hpp"
 #include "logicsegment.hpp"
 
-using std::deque;
+using std::lock_guard;
 using std::max;
+using std::mutex;
 using std::shared_ptr;
 using std::vector;
 
@@ -32,7 +33,8 @@ namespace data {
 
 Logic::Logic(unsigned int num_channels) :
 	SignalData(),
-	num_channels_(num_channels)
+	num_channels_(num_channels),
+	first_frame_(0)
 {
 	assert(num_channels_ > 0);
 }
@@ -42,35 +44,68 @@ unsigned int Logic::num_channels() const
 	return num_channels_;
 }
 
-void Logic::push_segment(
-	shared_ptr<LogicSegment> &segment)
+void Logic::push_segment(shared_ptr<LogicSegment> &segment, uint64_t frame)
 {
-	segments_.push_front(segment);
+	lock_guard<mutex> lock(mutex_);
+
+	if (segments_.empty())
+		first_frame_ = frame;
+
+	assert(frame >= first_frame_ + segments_.size());
+	segments_.resize(frame - first_frame_);
+	segments_.push_back(segment);
 }
 
-const deque< shared_ptr<LogicSegment> >& Logic::logic_segments() const
+shared_ptr<LogicSegment> Logic::logic_segment(uint64_t frame) const
 {
-	return segments_;
+	lock_guard<mutex> lock(mutex_);
+
+	if (frame < first_frame_ || frame - first_frame_ >= segments_.size())
+		return nullptr;
+
+	return segments_[frame - first_frame_];
 }
 
 vector< shared_ptr<Segment> > Logic::segments() const
 {
-	return vector< shared_ptr<Segment> >(
-		segments_.begin(), segments_.end());
+	lock_guard<mutex> lock(mutex_);
+
+	vector< shared_ptr<Segment> > segments;
+	for (const shared_ptr<LogicSegment> &s : segments_)
+		if (s)
+			segments.push_back(s);
+	return segments;
+}
+
+shared_ptr<Segment> Logic::frame_segment(uint64_t frame) const
+{
+	return logic_segment(frame);
+}
+
+void Logic::drop_frames_before(uint64_t frame)
+{
+	lock_guard<mutex> lock(mutex_);
+
+	for (; first_frame_ < frame && !segments_.empty(); first_frame_++)
+		segments_.pop_front();
 }
 
 void Logic::clear()
 {
+	lock_guard<mutex> lock(mutex_);
+
 	segments_.clear();
+	first_frame_ = 0;
 }
 
 uint64_t Logic::max_sample_count() const
 {
+	lock_guard<mutex> lock(mutex_);
+
 	uint64_t l = 0;
-	for (std::shared_ptr<LogicSegment> s : segments_) {
-		assert(s);
-		l = max(l, s->get_sample_count());
-	}
+	for (const shared_ptr<LogicSegment> &s : segments_)
+		if (s)
+			l = max(l, s->get_sample_count());
 	return l;
 }
 
@@ -23,6 +23,7 @@
 #include "signaldata.hpp"
 
 #include <deque>
+#include <mutex>
 
 namespace pv {
 namespace data {
@@ -36,21 +37,35 @@ public:
 
 	unsigned int num_channels() const;
 
+	/**
+	 * Adds the segment of a frame, which must be newer than the frames
+	 * already held. Frames without samples of the signal are skipped.
+	 */
 	void push_segment(
-		std::shared_ptr<LogicSegment> &segment);
+		std::shared_ptr<LogicSegment> &segment, uint64_t frame);
 
-	const std::deque< std::shared_ptr<LogicSegment> >&
-		logic_segments() const;
+	/**
+	 * Returns the segment of a frame, or nullptr if there is none.
+	 */
+	std::shared_ptr<LogicSegment> logic_segment(uint64_t frame) const;
 
 	std::vector< std::shared_ptr<Segment> > segments() const;
 
+	std::shared_ptr<Segment> frame_segment(uint64_t frame) const;
+
+	void drop_frames_before(uint64_t frame);
+
 	void clear();
 
 	uint64_t max_sample_count() const;
 
 private:
 	const unsigned int num_channels_;
+	mutable std::mutex mutex_;
+
+	/// The segments by frame, starting with the frame first_frame_
 	std::deque< std::shared_ptr<LogicSegment> > segments_;
+	uint64_t first_frame_;
 };
 
 } // namespace data
@@ -22,18 +22,25 @@
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <cmath>
 
+#include "channelpacker.hpp"
+#include "kernels.hpp"
 #include "logicsegment.hpp"
 
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
-using std::lock_guard;
-using std::recursive_mutex;
+using boost::shared_lock;
+using boost::shared_mutex;
+using boost::unique_lock;
+
+using std::default_delete;
 using std::max;
 using std::min;
 using std::pair;
 using std::shared_ptr;
+using std::vector;
 
 using sigrok::Logic;
 
@@ -43,116 +50,131 @@ namespace data {
 const int LogicSegment::MipMapScalePower = 4;
 const int LogicSegment::MipMapScaleFactor = 1 << MipMapScalePower;
 const float LogicSegment::LogMipMapScaleFactor = logf(MipMapScaleFactor);
-const uint64_t LogicSegment::MipMapDataUnit = 64*1024;	// bytes
+const unsigned int LogicSegment::EdgeCountMax = 255;
 
 LogicSegment::LogicSegment(shared_ptr<Logic> logic, uint64_t samplerate,
-				const uint64_t expected_num_samples) :
-	Segment(samplerate, logic->unit_size()),
-	last_append_sample_(0)
+				const uint64_t expected_num_samples,
+				StorageMode storage_mode,
+				shared_ptr<ChunkAllocator> allocator,
+				shared_ptr<const ChannelPacker> packer,
+				bool edge_counts) :
+	Segment(samplerate, packer ? packer->unit_size() : logic->unit_size(),
+		allocator),
+	storage_mode_(storage_mode),
+	packer_(packer),
+	edge_counts_(edge_counts && storage_mode == RawStorage),
+	edge_count_channels_(min(unit_size_ * 8, 64U)),
+	subsampled_edges_((storage_mode == TransitionStorage) ?
+		&LogicSegment::get_subsampled_edges_transitions :
+		unit_functions(unit_size_).subsampled_edges),
+	batched_edges_((storage_mode == TransitionStorage) ?
+		&LogicSegment::get_subsampled_edges_batch_transitions :
+		unit_functions(unit_size_).batched_edges),
+	subsampled_levels_((storage_mode == TransitionStorage) ?
+		&LogicSegment::get_subsampled_levels_transitions :
+		unit_functions(unit_size_).subsampled_levels),
+	append_transitions_(unit_functions(unit_size_).append_transitions),
+	next_edge_((storage_mode == TransitionStorage) ?
+		&LogicSegment::find_next_edge_transitions :
+		unit_functions(unit_size_).next_edge),
+	previous_edge_((storage_mode == TransitionStorage) ?
+		&LogicSegment::find_previous_edge_transitions :
+		unit_functions(unit_size_).previous_edge),
+	transition_indices_(sizeof(uint64_t)),
+	transition_samples_(unit_size_),
+	transition_count_(0)
 {
-	set_capacity(expected_num_samples);
+	if (storage_mode_ == RawStorage)
+		set_capacity(expected_num_samples);
+
+	for (unsigned int level = 0; level < ScaleStepCount; level++) {
+		transition_changes_[level] = PagedArray(sizeof(uint64_t));
+		pending_changes_[level] = 0;
+	}
+
+	for (MipMapLevel &m : mip_map_) {
+		m.length = 0;
+		m.data = PagedArray(unit_size_);
+		m.any_high = PagedArray(unit_size_);
+		m.any_low = PagedArray(unit_size_);
+		m.edge_counts = PagedArray(edge_count_channels_);
+	}
 
-	lock_guard<recursive_mutex> lock(mutex_);
-	memset(mip_map_, 0, sizeof(mip_map_));
 	append_payload(logic);
 }
 
 LogicSegment::~LogicSegment()
 {
-	lock_guard<recursive_mutex> lock(mutex_);
-	for (MipMapLevel &l : mip_map_)
-		free(l.data);
+	unique_lock<shared_mutex> lock(mutex_);
 }
 
-uint64_t LogicSegment::unpack_sample(const uint8_t *ptr) const
+template<unsigned int U>
+uint64_t LogicSegment::unpack_sample(const uint8_t *ptr)
 {
-#ifdef HAVE_UNALIGNED_LITTLE_ENDIAN_ACCESS
-	return *(uint64_t*)ptr;
-#else
+	// Samples are little-endian. Compilers merge these byte loads into
+	// a single load on little-endian targets.
 	uint64_t value = 0;
-	switch (unit_size_) {
-	default:
-		value |= ((uint64_t)ptr[7]) << 56;
-		/* FALLTHRU */
-	case 7:
-		value |= ((uint64_t)ptr[6]) << 48;
-		/* FALLTHRU */
-	case 6:
-		value |= ((uint64_t)ptr[5]) << 40;
-		/* FALLTHRU */
-	case 5:
-		value |= ((uint64_t)ptr[4]) << 32;
-		/* FALLTHRU */
-	case 4:
-		value |= ((uint32_t)ptr[3]) << 24;
-		/* FALLTHRU */
-	case 3:
-		value |= ((uint32_t)ptr[2]) << 16;
-		/* FALLTHRU */
-	case 2:
-		value |= ptr[1] << 8;
-		/* FALLTHRU */
-	case 1:
-		value |= ptr[0];
-		/* FALLTHRU */
-	case 0:
-		break;
-	}
+	for (unsigned int i = 0; i < U; i++)
+		value |= ((uint64_t)ptr[i]) << (8 * i);
 	return value;
-#endif
-}
-
-void LogicSegment::pack_sample(uint8_t *ptr, uint64_t value)
-{
-#ifdef HAVE_UNALIGNED_LITTLE_ENDIAN_ACCESS
-	*(uint64_t*)ptr = value;
-#else
-	switch (unit_size_) {
-	default:
-		ptr[7] = value >> 56;
-		/* FALLTHRU */
-	case 7:
-		ptr[6] = value >> 48;
-		/* FALLTHRU */
-	case 6:
-		ptr[5] = value >> 40;
-		/* FALLTHRU */
-	case 5:
-		ptr[4] = value >> 32;
-		/* FALLTHRU */
-	case 4:
-		ptr[3] = value >> 24;
-		/* FALLTHRU */
-	case 3:
-		ptr[2] = value >> 16;
-		/* FALLTHRU */
-	case 2:
-		ptr[1] = value >> 8;
-		/* FALLTHRU */
-	case 1:
-		ptr[0] = value;
-		/* FALLTHRU */
-	case 0:
-		break;
-	}
-#endif
 }
 
 void LogicSegment::append_payload(shared_ptr<Logic> logic)
 {
-	assert(unit_size_ == logic->unit_size());
-	assert((logic->data_length() % unit_size_) == 0);
+	const unsigned int source_unit_size =
+		packer_ ? packer_->source_unit_size() : unit_size_;
+	assert(source_unit_size == logic->unit_size());
+	assert((logic->data_length() % source_unit_size) == 0);
+
+	const uint64_t samples = logic->data_length() / source_unit_size;
+	uint8_t *data = (uint8_t*)logic->data_pointer();
+
+	// Keep only the channels in use, before anything else is done with
+	// the samples
+	if (packer_) {
+		packed_payload_.resize(samples * unit_size_);
+		packer_->pack(data, samples, packed_payload_.data());
+		data = packed_payload_.data();
+	}
+
+	if (storage_mode_ == TransitionStorage) {
+		unique_lock<shared_mutex> lock(mutex_);
+		(this->*append_transitions_)(data, samples);
+		return;
+	}
+
+	// The mip-map is built later on by summarize(), off the data feed
+	// thread
+	append_data(data, samples);
+}
+
+void LogicSegment::summarize(uint64_t end)
+{
+	// The transitions are all there is to summarize
+	if (storage_mode_ == TransitionStorage)
+		return;
 
-	lock_guard<recursive_mutex> lock(mutex_);
+	append_payload_to_mipmap(end);
+}
 
-	append_data(logic->data_pointer(),
-		logic->data_length() / unit_size_);
+void LogicSegment::drop_summaries(uint64_t start)
+{
+	// Only raw storage keeps its samples in chunks
+	assert(storage_mode_ == RawStorage);
 
-	// Generate the first mip-map from the data
-	append_payload_to_mipmap();
+	// The blocks that hold the first sample are kept
+	for (unsigned int level = 0; level < ScaleStepCount; level++) {
+		MipMapLevel &m = mip_map_[level];
+		const uint64_t offset =
+			start >> ((level + 1) * MipMapScalePower);
+		m.data.drop_before(offset);
+		m.any_high.drop_before(offset);
+		m.any_low.drop_before(offset);
+		m.edge_counts.drop_before(offset);
+	}
 }
 
-const uint8_t* LogicSegment::get_samples(int64_t start_sample,
+SegmentDataView LogicSegment::get_samples(int64_t start_sample,
 	int64_t end_sample) const
 {
 	assert(start_sample >= 0);
@@ -161,66 +183,538 @@ const uint8_t* LogicSegment::get_samples(int64_t start_sample,
 	assert(end_sample <= (int64_t)sample_count_);
 	assert(start_sample <= end_sample);
 
-	lock_guard<recursive_mutex> lock(mutex_);
+	if (storage_mode_ == TransitionStorage)
+		return get_transition_samples(start_sample,
+			end_sample - start_sample);
+
+	return get_raw_samples_view(start_sample, end_sample - start_sample);
+}
+
+LogicSegment::StorageMode LogicSegment::storage_mode() const
+{
+	return storage_mode_;
+}
+
+shared_ptr<const ChannelPacker> LogicSegment::channel_packer() const
+{
+	return packer_;
+}
+
+int LogicSegment::channel_bit(unsigned int channel) const
+{
+	if (packer_)
+		return packer_->packed_index(channel);
 
-	uint8_t* data = new uint8_t[end_sample - start_sample];
-	const size_t size = (end_sample - start_sample) * unit_size_;
-	memcpy(data, (uint8_t*)data_.data() + start_sample * unit_size_, size);
-	return data;
+	return (channel < unit_size_ * 8) ? (int)channel : -1;
+}
+
+uint64_t LogicSegment::get_transition_count() const
+{
+	shared_lock<shared_mutex> lock(mutex_);
+	return transition_count_;
+}
+
+uint64_t LogicSegment::transition_index(uint64_t transition) const
+{
+	assert(transition < transition_count_);
+
+	uint64_t index;
+	memcpy(&index, transition_indices_.entry(transition), sizeof(index));
+	return index;
+}
+
+const uint8_t* LogicSegment::transition_sample(uint64_t transition) const
+{
+	assert(transition < transition_count_);
+	return transition_samples_.entry(transition);
 }
 
-void LogicSegment::reallocate_mipmap_level(MipMapLevel &m)
+void LogicSegment::push_transition(uint64_t index, const uint8_t *sample)
 {
-	const uint64_t new_data_length = ((m.length + MipMapDataUnit - 1) /
-		MipMapDataUnit) * MipMapDataUnit;
-	if (new_data_length > m.data_length) {
-		m.data_length = new_data_length;
+	// The pages are never moved, unlike the storage of a vector that
+	// grows
+	transition_indices_.reserve(transition_count_ + 1);
+	transition_samples_.reserve(transition_count_ + 1);
+
+	memcpy(transition_indices_.entry(transition_count_), &index,
+		sizeof(index));
+	memcpy(transition_samples_.entry(transition_count_), sample,
+		unit_size_);
+	transition_count_++;
+
+	// Fold the change into the blocks of transitions it belongs to, and
+	// store the blocks it completes
+	if (transition_count_ < 2)
+		return;
+
+	uint64_t changes = get_transition_state(transition_count_ - 1) ^
+		get_transition_state(transition_count_ - 2);
+	for (unsigned int level = 0; level < ScaleStepCount; level++) {
+		const unsigned int power = (level + 1) * MipMapScalePower;
+		pending_changes_[level] |= changes;
+		if ((transition_count_ & ((1ULL << power) - 1)) != 0)
+			break;
 
-		// Padding is added to allow for the uint64_t write word
-		m.data = realloc(m.data, new_data_length * unit_size_ +
+		PagedArray &a = transition_changes_[level];
+		const uint64_t block = (transition_count_ >> power) - 1;
+		a.reserve(block + 1);
+		memcpy(a.entry(block), &pending_changes_[level],
 			sizeof(uint64_t));
+		changes = pending_changes_[level];
+		pending_changes_[level] = 0;
+	}
+}
+
+uint64_t LogicSegment::get_transition_changes(int level,
+	uint64_t offset) const
+{
+	if (level < 0)
+		return (offset == 0) ? 0 : (get_transition_state(offset) ^
+			get_transition_state(offset - 1));
+
+	uint64_t changes;
+	memcpy(&changes, transition_changes_[level].entry(offset),
+		sizeof(changes));
+	return changes;
+}
+
+uint64_t LogicSegment::find_next_changed_transition(uint64_t begin,
+	uint64_t end, uint64_t mask) const
+{
+	for (uint64_t t = begin; t < end;) {
+		// Skip the largest block that begins at t, if none of the
+		// signals change within it
+		bool skipped = false;
+		for (int level = ScaleStepCount - 1; level >= 0; level--) {
+			const unsigned int power = (level + 1) * MipMapScalePower;
+			const uint64_t block = (uint64_t)1 << power;
+
+			if ((t & (block - 1)) != 0 ||
+				t + block > (transition_count_ & ~(block - 1)) ||
+				(get_transition_changes(level, t >> power) & mask))
+				continue;
+
+			t += block;
+			skipped = true;
+			break;
+		}
+
+		if (skipped)
+			continue;
+
+		if (get_transition_changes(-1, t) & mask)
+			return t;
+		t++;
+	}
+
+	return end;
+}
+
+uint64_t LogicSegment::find_previous_changed_transition(uint64_t begin,
+	uint64_t end, uint64_t mask) const
+{
+	// The transitions before t remain to be searched
+	for (uint64_t t = end; t > begin;) {
+		// Skip the largest block that ends at t, if none of the signals
+		// change within it
+		bool skipped = false;
+		for (int level = ScaleStepCount - 1; level >= 0; level--) {
+			const unsigned int power = (level + 1) * MipMapScalePower;
+			const uint64_t block = (uint64_t)1 << power;
+
+			if ((t & (block - 1)) != 0 || t - begin < block ||
+				(get_transition_changes(level, (t >> power) - 1) &
+					mask))
+				continue;
+
+			t -= block;
+			skipped = true;
+			break;
+		}
+
+		if (skipped)
+			continue;
+
+		t--;
+		if (get_transition_changes(-1, t) & mask)
+			return t;
+	}
+
+	return end;
+}
+
+template<unsigned int U>
+void LogicSegment::append_transitions(const uint8_t *data, uint64_t samples)
+{
+	// With U known at compile time the comparisons become plain loads
+	const unsigned int stride = U ? U : unit_size_;
+	const uint8_t *const end = data + samples * stride;
+
+	if (samples == 0)
+		return;
+
+	// Compare the first sample with the last stored transition
+	if (transition_count_ == 0) {
+		push_transition(sample_count_, data);
+	} else {
+		const uint8_t *const last =
+			transition_sample(transition_count_ - 1);
+		if (memcmp(data, last, stride) != 0)
+			push_transition(sample_count_, data);
+	}
+
+	uint64_t index = sample_count_ + 1;
+	for (const uint8_t *ptr = data + stride; ptr < end;
+			ptr += stride, index++) {
+		if (memcmp(ptr, ptr - stride, stride) != 0)
+			push_transition(index, ptr);
+	}
+
+	sample_count_ += samples;
+}
+
+bool LogicSegment::find_next_edge(int sig_index, uint64_t sample,
+	uint64_t &edge) const
+{
+	assert(sig_index >= 0);
+
+	// Only the first 64 channels are searched
+	if ((unsigned int)sig_index >= min(unit_size_ * 8, 64U))
+		return false;
+
+	shared_lock<shared_mutex> lock(mutex_);
+	return (this->*next_edge_)(sig_index, sample, edge);
+}
+
+bool LogicSegment::find_previous_edge(int sig_index, uint64_t sample,
+	uint64_t &edge) const
+{
+	assert(sig_index >= 0);
+
+	if ((unsigned int)sig_index >= min(unit_size_ * 8, 64U))
+		return false;
+
+	shared_lock<shared_mutex> lock(mutex_);
+	return (this->*previous_edge_)(sig_index, sample, edge);
+}
+
+template<unsigned int U>
+bool LogicSegment::find_next_edge_unit(int sig_index, uint64_t sample,
+	uint64_t &edge) const
+{
+	// The first sample held is not an edge, as its predecessor has been
+	// dropped
+	const uint64_t end = sample_count_;
+	const uint64_t begin = max(sample, (uint64_t)first_sample_) + 1;
+	if (begin >= end)
+		return false;
+
+	edge = find_next_change<U>(begin, end, 1ULL << sig_index);
+	return edge < end;
+}
+
+template<unsigned int U>
+bool LogicSegment::find_previous_edge_unit(int sig_index, uint64_t sample,
+	uint64_t &edge) const
+{
+	const uint64_t begin = first_sample_ + 1;
+	const uint64_t end = min(sample, (uint64_t)sample_count_);
+	if (begin >= end)
+		return false;
+
+	edge = find_previous_change<U>(begin, end, 1ULL << sig_index);
+	return edge < end;
+}
+
+bool LogicSegment::find_next_edge_transitions(int sig_index,
+	uint64_t sample, uint64_t &edge) const
+{
+	if (transition_count_ == 0)
+		return false;
+
+	const uint64_t t = find_next_changed_transition(
+		find_transition(sample) + 1, transition_count_, 1ULL << sig_index);
+	if (t == transition_count_)
+		return false;
+
+	edge = transition_index(t);
+	return true;
+}
+
+bool LogicSegment::find_previous_edge_transitions(int sig_index,
+	uint64_t sample, uint64_t &edge) const
+{
+	if (transition_count_ == 0 || sample == 0)
+		return false;
+
+	// The first transition holds the first sample, which is not an edge
+	const uint64_t end = find_transition(sample - 1) + 1;
+	const uint64_t t = find_previous_changed_transition(1, end,
+		1ULL << sig_index);
+	if (t == end)
+		return false;
+
+	edge = transition_index(t);
+	return true;
+}
+
+uint64_t LogicSegment::count_edges(int sig_index, uint64_t start,
+	uint64_t end, bool exact) const
+{
+	if ((unsigned int)sig_index >= min(unit_size_ * 8, 64U) || start >= end)
+		return 0;
+
+	if (edge_counts_)
+		return count_edges_mipmap(sig_index, start, end, exact);
+
+	// Edges are found after a sample, so the search starts one before
+	uint64_t count = 0, edge;
+	for (uint64_t sample = start ? start - 1 : 0;
+			(this->*next_edge_)(sig_index, sample, edge) && edge < end;
+			sample = edge)
+		count++;
+
+	return count;
+}
+
+uint64_t LogicSegment::count_edges_mipmap(int sig_index, uint64_t start,
+	uint64_t end, bool exact) const
+{
+	const uint64_t sig_mask = 1ULL << sig_index;
+
+	// The first sample held has no sample to compare with, as the ones
+	// before it have been dropped. The samples that are not summarized
+	// yet are compared one by one.
+	start = max(start, (uint64_t)first_sample_ + 1);
+	end = min(end, (uint64_t)sample_count_);
+
+	ChunkCursor cursor;
+	uint64_t count = 0, prev = 0;
+	bool have_prev = false;
+
+	for (uint64_t index = start; index < end;) {
+		// Find the largest block that starts here, fits the range, and
+		// has not saturated. The counts of larger blocks are never
+		// below those of the blocks within them.
+		unsigned int level = 0;
+		uint64_t block_count = 0;
+		for (unsigned int l = 1; l < ScaleStepCount; l++) {
+			const unsigned int power = (l + 1) * MipMapScalePower;
+			const uint64_t offset = index >> power;
+			if ((index & ((1ULL << power) - 1)) != 0 ||
+				index + (1ULL << power) > end ||
+				offset >= mip_map_[l].length)
+				break;
+
+			const unsigned int c =
+				mip_map_[l].edge_counts.entry(offset)[sig_index];
+			if (c >= EdgeCountMax) {
+				// Only the blocks of level 1 saturate with few
+				// enough samples to be busy throughout
+				if (!exact && l == 1) {
+					level = l;
+					block_count = 1ULL << power;
+				}
+				break;
+			}
+
+			level = l;
+			block_count = c;
+		}
+
+		if (level > 0) {
+			count += block_count;
+			index += 1ULL << ((level + 1) * MipMapScalePower);
+			have_prev = false;
+			continue;
+		}
+
+		// Skip the blocks of level 0 in which the signal does not change
+		if ((index & (MipMapScaleFactor - 1)) == 0 &&
+			index + MipMapScaleFactor <= end &&
+			(index >> MipMapScalePower) < mip_map_[0].length &&
+			!(get_subsample(0, index >> MipMapScalePower) & sig_mask)) {
+			index += MipMapScaleFactor;
+			have_prev = false;
+			continue;
+		}
+
+		if (!have_prev)
+			prev = get_sample(index - 1, cursor);
+
+		const uint64_t sample = get_sample(index, cursor);
+		if ((sample ^ prev) & sig_mask)
+			count++;
+		prev = sample;
+		have_prev = true;
+		index++;
+	}
+
+	return count;
+}
+
+uint64_t LogicSegment::get_edge_count(int sig_index, uint64_t start,
+	uint64_t end) const
+{
+	assert(sig_index >= 0);
+	assert(start <= end);
+
+	shared_lock<shared_mutex> lock(mutex_);
+	return count_edges(sig_index, start, end);
+}
+
+bool LogicSegment::has_edge_counts() const
+{
+	return edge_counts_;
+}
+
+void LogicSegment::get_edge_counts(
+	std::vector< std::vector<uint64_t> > &counts,
+	uint64_t start, uint64_t end,
+	float min_length, const std::vector<int> &sig_indices) const
+{
+	assert(start <= end);
+	assert(min_length > 0);
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	const double block_length = max(min_length, 1.0f);
+	const size_t sig_count = sig_indices.size();
+	counts.resize(sig_count);
+
+	uint64_t index = start;
+	for (uint64_t i = 1; index < end; i++) {
+		const uint64_t final_index = min(end,
+			start + (uint64_t)(i * block_length));
+		for (size_t j = 0; j < sig_count; j++) {
+			assert(sig_indices[j] >= 0);
+			counts[j].push_back(count_edges(sig_indices[j], index,
+				final_index, false));
+		}
+		index = final_index;
+	}
+}
+
+MemoryUsage LogicSegment::memory_usage() const
+{
+	MemoryUsage usage = Segment::memory_usage();
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	usage.samples += transition_indices_.memory_usage() +
+		transition_samples_.memory_usage();
+	for (const PagedArray &a : transition_changes_)
+		usage.summaries += a.memory_usage();
+
+	for (const MipMapLevel &m : mip_map_)
+		usage.summaries += m.data.memory_usage() +
+			m.any_high.memory_usage() + m.any_low.memory_usage() +
+			m.edge_counts.memory_usage();
+
+	return usage;
+}
+
+uint64_t LogicSegment::find_transition(uint64_t index) const
+{
+	assert(transition_count_ > 0);
+
+	// Find the first transition after index. The first sample is always
+	// stored, so this never underflows.
+	uint64_t first = 0, count = transition_count_;
+	while (count > 0) {
+		const uint64_t step = count / 2;
+		if (transition_index(first + step) <= index) {
+			first += step + 1;
+			count -= step + 1;
+		} else
+			count = step;
 	}
+
+	return first - 1;
 }
 
-void LogicSegment::append_payload_to_mipmap()
+SegmentDataView LogicSegment::get_transition_samples(uint64_t start,
+	uint64_t count) const
+{
+	shared_lock<shared_mutex> lock(mutex_);
+
+	// Expand no more than a chunk worth of samples at a time, like the
+	// views onto raw storage
+	count = min(count, chunk_samples_);
+	if (count == 0)
+		return SegmentDataView();
+
+	shared_ptr<uint8_t> buffer(new uint8_t[count * unit_size_],
+		default_delete<uint8_t[]>());
+	uint8_t *dest = buffer.get();
+
+	const uint64_t end = start + count;
+	for (uint64_t t = find_transition(start), index = start; index < end;
+			t++) {
+		const uint64_t run_end = (t + 1 < transition_count_) ?
+			min(transition_index(t + 1), end) : end;
+		const uint8_t *const sample = transition_sample(t);
+
+		for (; index < run_end; index++, dest += unit_size_)
+			memcpy(dest, sample, unit_size_);
+	}
+
+	return SegmentDataView(buffer, buffer.get(), count, unit_size_);
+}
+
+void LogicSegment::reserve_mipmap_level(MipMapLevel &m)
+{
+	m.data.reserve(m.length);
+	m.any_high.reserve(m.length);
+	m.any_low.reserve(m.length);
+}
+
+void LogicSegment::append_payload_to_mipmap(uint64_t end)
 {
 	MipMapLevel &m0 = mip_map_[0];
 	uint64_t prev_length;
-	const uint8_t *src_ptr;
-	uint8_t *dest_ptr;
-	uint64_t accumulator;
-	unsigned int diff_counter;
+	uint64_t prev_lengths[ScaleStepCount];
+	vector<uint8_t> prev_sample(unit_size_, 0);
+
+	for (unsigned int level = 0; level < ScaleStepCount; level++)
+		prev_lengths[level] = mip_map_[level].length;
 
 	// Expand the data buffer to fit the new samples
 	prev_length = m0.length;
-	m0.length = sample_count_ / MipMapScaleFactor;
+	m0.length = end / MipMapScaleFactor;
 
 	// Break off if there are no new samples to compute
 	if (m0.length == prev_length)
 		return;
 
-	reallocate_mipmap_level(m0);
-
-	dest_ptr = (uint8_t*)m0.data + prev_length * unit_size_;
-
-	// Iterate through the samples to populate the first level mipmap
-	const uint8_t *const end_src_ptr = (uint8_t*)data_.data() +
-		m0.length * unit_size_ * MipMapScaleFactor;
-	for (src_ptr = (uint8_t*)data_.data() +
-			prev_length * unit_size_ * MipMapScaleFactor;
-			src_ptr < end_src_ptr;) {
-		// Accumulate transitions which have occurred in this sample
-		accumulator = 0;
-		diff_counter = MipMapScaleFactor;
-		while (diff_counter-- > 0) {
-			const uint64_t sample = unpack_sample(src_ptr);
-			accumulator |= last_append_sample_ ^ sample;
-			last_append_sample_ = sample;
-			src_ptr += unit_size_;
-		}
-
-		pack_sample(dest_ptr, accumulator);
-		dest_ptr += unit_size_;
+	reserve_mipmap_level(m0);
+
+	// The first sample of the segment is compared with zero
+	if (prev_length > 0)
+		memcpy(prev_sample.data(), raw_sample(
+			prev_length * MipMapScaleFactor - 1), unit_size_);
+
+	// Populate the first level mipmap one contiguous run of samples at a
+	// time. The chunk size is a multiple of the scale factor, so the
+	// samples of one block are always stored contiguously. The planes
+	// share their page layout.
+	for (uint64_t block = prev_length; block < m0.length;) {
+		const uint64_t index = block * MipMapScaleFactor;
+		const uint64_t count = min(min(m0.length - block,
+			contiguous_samples(index) / MipMapScaleFactor),
+			m0.data.contiguous_entries(block));
+		const uint8_t *const src_ptr = raw_sample(index);
+
+		kernels::logic_mipmap_transitions(src_ptr, m0.data.entry(block),
+			count, unit_size_, prev_sample.data());
+		kernels::logic_mipmap_reduce(src_ptr, m0.any_high.entry(block),
+			count, unit_size_);
+		kernels::logic_mipmap_any_low(src_ptr, m0.any_low.entry(block),
+			count, unit_size_);
+
+		memcpy(prev_sample.data(), src_ptr +
+			(count * MipMapScaleFactor - 1) * unit_size_, unit_size_);
+		block += count;
 	}
 
 	// Compute higher level mipmaps
@@ -236,34 +730,118 @@ void LogicSegment::append_payload_to_mipmap()
 		if (m.length == prev_length)
 			break;
 
-		reallocate_mipmap_level(m);
-
-		// Subsample the level lower level
-		src_ptr = (uint8_t*)ml.data +
-			unit_size_ * prev_length * MipMapScaleFactor;
-		const uint8_t *const end_dest_ptr =
-			(uint8_t*)m.data + unit_size_ * m.length;
-		for (dest_ptr = (uint8_t*)m.data +
-				unit_size_ * prev_length;
-				dest_ptr < end_dest_ptr;
-				dest_ptr += unit_size_) {
-			accumulator = 0;
-			diff_counter = MipMapScaleFactor;
-			while (diff_counter-- > 0) {
-				accumulator |= unpack_sample(src_ptr);
-				src_ptr += unit_size_;
+		reserve_mipmap_level(m);
+
+		// Subsample the level lower level, one run of pages at a time
+		for (uint64_t offset = prev_length; offset < m.length;) {
+			const uint64_t src_offset = offset * MipMapScaleFactor;
+			const uint64_t count = min(min(m.length - offset,
+				m.data.contiguous_entries(offset)),
+				ml.data.contiguous_entries(src_offset) /
+					MipMapScaleFactor);
+			assert(count > 0);
+
+			kernels::logic_mipmap_reduce(ml.data.entry(src_offset),
+				m.data.entry(offset), count, unit_size_);
+			kernels::logic_mipmap_reduce(
+				ml.any_high.entry(src_offset),
+				m.any_high.entry(offset), count, unit_size_);
+			kernels::logic_mipmap_reduce(
+				ml.any_low.entry(src_offset),
+				m.any_low.entry(offset), count, unit_size_);
+
+			offset += count;
+		}
+	}
+
+	if (edge_counts_)
+		append_edge_counts(prev_lengths);
+}
+
+void LogicSegment::append_edge_counts(const uint64_t *prev_lengths)
+{
+	MipMapLevel &m1 = mip_map_[1];
+	m1.edge_counts.reserve(m1.length);
+
+	// Count the edges of level 1 from the samples. The blocks of level 0
+	// without changes hold copies of the sample before them, so they are
+	// skipped.
+	const unsigned int power = 2 * MipMapScalePower;
+	ChunkCursor cursor;
+	for (uint64_t block = prev_lengths[1]; block < m1.length; block++) {
+		uint8_t *const counts = m1.edge_counts.entry(block);
+		memset(counts, 0, edge_count_channels_);
+
+		// The first sample of the segment is not an edge
+		const uint64_t index = block << power;
+		uint64_t prev = get_sample(
+			(index > first_sample_) ? index - 1 : index, cursor);
+
+		for (uint64_t b = index >> MipMapScalePower;
+				b < (block + 1) << MipMapScalePower; b++) {
+			if (get_subsample(0, b) == 0)
+				continue;
+
+			for (uint64_t i = b << MipMapScalePower;
+					i < (b + 1) << MipMapScalePower; i++) {
+				const uint64_t sample = get_sample(i, cursor);
+				for (uint64_t diff = sample ^ prev; diff;
+						diff &= diff - 1) {
+					uint8_t &c = counts[__builtin_ctzll(diff)];
+					if (c < EdgeCountMax)
+						c++;
+				}
+				prev = sample;
 			}
+		}
+	}
+
+	// Sum up the higher levels, one run of pages at a time
+	for (unsigned int level = 2; level < ScaleStepCount; level++) {
+		MipMapLevel &m = mip_map_[level];
+		const MipMapLevel &ml = mip_map_[level-1];
+
+		if (m.length == prev_lengths[level])
+			break;
+
+		m.edge_counts.reserve(m.length);
 
-			pack_sample(dest_ptr, accumulator);
+		for (uint64_t offset = prev_lengths[level]; offset < m.length;) {
+			const uint64_t src_offset = offset * MipMapScaleFactor;
+			const uint64_t count = min(min(m.length - offset,
+				m.edge_counts.contiguous_entries(offset)),
+				ml.edge_counts.contiguous_entries(src_offset) /
+					MipMapScaleFactor);
+			assert(count > 0);
+
+			kernels::logic_edge_counts_reduce(
+				ml.edge_counts.entry(src_offset),
+				m.edge_counts.entry(offset), count,
+				edge_count_channels_);
+
+			offset += count;
 		}
 	}
 }
 
-uint64_t LogicSegment::get_sample(uint64_t index) const
+template<unsigned int U>
+uint64_t LogicSegment::get_sample(uint64_t index, ChunkCursor &cursor) const
 {
 	assert(index < sample_count_);
 
-	return unpack_sample((uint8_t*)data_.data() + index * unit_size_);
+	// Samples wider than 8 bytes are truncated to the first 64 channels
+	return unpack_sample<U ? U : 8>(sample_ptr(index, cursor));
+}
+
+uint64_t LogicSegment::get_sample(uint64_t index, ChunkCursor &cursor) const
+{
+	assert(index < sample_count_);
+
+	uint64_t value = 0;
+	const uint8_t *const ptr = sample_ptr(index, cursor);
+	for (unsigned int i = 0; i < min(unit_size_, 8U); i++)
+		value |= ((uint64_t)ptr[i]) << (8 * i);
+	return value;
 }
 
 void LogicSegment::get_subsampled_edges(
@@ -271,7 +849,15 @@ void LogicSegment::get_subsampled_edges(
 	uint64_t start, uint64_t end,
 	float min_length, int sig_index)
 {
-	uint64_t index = start;
+	(this->*subsampled_edges_)(edges, start, end, min_length, sig_index);
+}
+
+template<unsigned int U>
+void LogicSegment::get_subsampled_edges_unit(
+	std::vector<EdgePair> &edges,
+	uint64_t start, uint64_t end,
+	float min_length, int sig_index)
+{
 	unsigned int level;
 	bool last_sample;
 	bool fast_forward;
@@ -282,24 +868,31 @@ void LogicSegment::get_subsampled_edges(
 	assert(sig_index >= 0);
 	assert(sig_index < 64);
 
-	lock_guard<recursive_mutex> lock(mutex_);
+	shared_lock<shared_mutex> lock(mutex_);
+
+	// The samples before the first one held have been dropped
+	start = max(start, (uint64_t)first_sample_);
+	end = max(end, start);
+
+	uint64_t index = start;
 
 	const uint64_t block_length = (uint64_t)max(min_length, 1.0f);
 	const unsigned int min_level = max((int)floorf(logf(min_length) /
 		LogMipMapScaleFactor) - 1, 0);
 	const uint64_t sig_mask = 1ULL << sig_index;
+	ChunkCursor cursor;
 
 	// Store the initial state
-	last_sample = (get_sample(start) & sig_mask) != 0;
+	last_sample = (get_sample<U>(start, cursor) & sig_mask) != 0;
 	edges.push_back(pair<int64_t, bool>(index++, last_sample));
 
 	while (index + block_length <= end) {
 		//----- Continue to search -----//
 		level = min_level;
 
-		// We cannot fast-forward if there is no mip-map data at
-		// at the minimum level.
-		fast_forward = (mip_map_[level].data != nullptr);
+		// Blocks beyond the end of the mip-map are searched sample
+		// by sample below
+		fast_forward = true;
 
 		if (min_length < MipMapScaleFactor) {
 			// Search individual samples up to the beginning of
@@ -311,7 +904,7 @@ void LogicSegment::get_subsampled_edges(
 					(index & ~((uint64_t)(~0) << MipMapScalePower)) != 0;
 					index++) {
 				const bool sample =
-					(get_sample(index) & sig_mask) != 0;
+					(get_sample<U>(index, cursor) & sig_mask) != 0;
 
 				// If there was a change we cannot fast forward
 				if (sample != last_sample) {
@@ -331,7 +924,7 @@ void LogicSegment::get_subsampled_edges(
 
 			// We can fast forward only if there was no change
 			const bool sample =
-				(get_sample(index) & sig_mask) != 0;
+				(get_sample<U>(index, cursor) & sig_mask) != 0;
 			if (last_sample != sample)
 				fast_forward = false;
 		}
@@ -354,7 +947,7 @@ void LogicSegment::get_subsampled_edges(
 				// Check if we reached the last block at this
 				// level, or if there was a change in this block
 				if (offset >= mip_map_[level].length ||
-					(get_subsample(level, offset) &
+					(get_subsample<U>(level, offset) &
 						sig_mask))
 					break;
 
@@ -363,7 +956,7 @@ void LogicSegment::get_subsampled_edges(
 					// higher level mip-map block ascend one
 					// level
 					if (level + 1 >= ScaleStepCount ||
-						!mip_map_[level + 1].data)
+						mip_map_[level + 1].length == 0)
 						break;
 
 					level++;
@@ -378,8 +971,6 @@ void LogicSegment::get_subsampled_edges(
 			// Zoom in, and slide right until we encounter a change,
 			// and repeat until we reach min_level
 			while (1) {
-				assert(mip_map_[level].data);
-
 				const int level_scale_power =
 					(level + 1) * MipMapScalePower;
 				const uint64_t offset =
@@ -388,7 +979,7 @@ void LogicSegment::get_subsampled_edges(
 				// Check if we reached the last block at this
 				// level, or if there was a change in this block
 				if (offset >= mip_map_[level].length ||
-						(get_subsample(level, offset) &
+						(get_subsample<U>(level, offset) &
 						sig_mask)) {
 					// Zoom in unless we reached the minimum
 					// zoom
@@ -405,12 +996,15 @@ void LogicSegment::get_subsampled_edges(
 			}
 
 			// If individual samples within the limit of resolution,
-			// do a linear search for the next transition within the
-			// block
-			if (min_length < MipMapScaleFactor) {
+			// or the mip-map does not cover the samples yet, do a
+			// linear search for the next transition
+			if (min_length < MipMapScaleFactor ||
+				(index >> ((min_level + 1) * MipMapScalePower)) >=
+					mip_map_[min_level].length) {
 				for (; index < end; index++) {
-					const bool sample = (get_sample(index) &
-						sig_mask) != 0;
+					const bool sample =
+						(get_sample<U>(index, cursor) &
+							sig_mask) != 0;
 					if (sample != last_sample)
 						break;
 				}
@@ -426,7 +1020,7 @@ void LogicSegment::get_subsampled_edges(
 
 		// Store the final state
 		const bool final_sample =
-			(get_sample(final_index - 1) & sig_mask) != 0;
+			(get_sample<U>(final_index - 1, cursor) & sig_mask) != 0;
 		edges.push_back(pair<int64_t, bool>(index, final_sample));
 
 		index = final_index;
@@ -434,18 +1028,587 @@ void LogicSegment::get_subsampled_edges(
 	}
 
 	// Add the final state
-	const bool end_sample = get_sample(end) & sig_mask;
+	const bool end_sample = get_sample<U>(end, cursor) & sig_mask;
 	if (last_sample != end_sample)
 		edges.push_back(pair<int64_t, bool>(end, end_sample));
 	edges.push_back(pair<int64_t, bool>(end + 1, end_sample));
 }
 
+void LogicSegment::get_subsampled_edges(
+	std::vector< std::vector<EdgePair> > &edges,
+	uint64_t start, uint64_t end,
+	float min_length, const std::vector<int> &sig_indices)
+{
+	(this->*batched_edges_)(edges, start, end, min_length, sig_indices);
+}
+
+template<unsigned int U>
+uint64_t LogicSegment::find_next_change(uint64_t index, uint64_t end,
+	uint64_t mask) const
+{
+	ChunkCursor cursor;
+
+	assert(index > 0);
+
+	while (index < end) {
+		// Skip the largest mip-map block that begins at index, if none
+		// of the signals change within it
+		bool skipped = false;
+		for (int level = ScaleStepCount - 1; level >= 0; level--) {
+			const unsigned int power = (level + 1) * MipMapScalePower;
+			const uint64_t block = (uint64_t)1 << power;
+			const uint64_t offset = index >> power;
+
+			if ((index & (block - 1)) != 0 ||
+				offset >= mip_map_[level].length)
+				continue;
+
+			if (get_subsample<U>(level, offset) & mask)
+				continue;
+
+			index += block;
+			skipped = true;
+			break;
+		}
+
+		if (skipped)
+			continue;
+
+		if ((get_sample<U>(index, cursor) ^
+			get_sample<U>(index - 1, cursor)) & mask)
+			return index;
+
+		index++;
+	}
+
+	return end;
+}
+
+template<unsigned int U>
+uint64_t LogicSegment::find_previous_change(uint64_t begin, uint64_t end,
+	uint64_t mask) const
+{
+	ChunkCursor cursor;
+
+	assert(begin > 0);
+
+	// The samples before index remain to be searched
+	for (uint64_t index = end; index > begin;) {
+		// Skip the largest mip-map block that ends at index, if none of
+		// the signals change within it
+		bool skipped = false;
+		for (int level = ScaleStepCount - 1; level >= 0; level--) {
+			const unsigned int power = (level + 1) * MipMapScalePower;
+			const uint64_t block = (uint64_t)1 << power;
+			const uint64_t offset = (index >> power) - 1;
+
+			if ((index & (block - 1)) != 0 || index - begin < block ||
+				offset >= mip_map_[level].length)
+				continue;
+
+			if (get_subsample<U>(level, offset) & mask)
+				continue;
+
+			index -= block;
+			skipped = true;
+			break;
+		}
+
+		if (skipped)
+			continue;
+
+		index--;
+		if ((get_sample<U>(index, cursor) ^
+			get_sample<U>(index - 1, cursor)) & mask)
+			return index;
+	}
+
+	return end;
+}
+
+template<unsigned int U>
+uint64_t LogicSegment::get_changes(uint64_t start, uint64_t end) const
+{
+	uint64_t changes = 0;
+	ChunkCursor cursor;
+
+	assert(start > 0);
+
+	while (start < end) {
+		// Take the largest mip-map block that fits, or else one sample
+		bool summarized = false;
+		for (int level = ScaleStepCount - 1; level >= 0; level--) {
+			const unsigned int power = (level + 1) * MipMapScalePower;
+			const uint64_t block = (uint64_t)1 << power;
+			const uint64_t offset = start >> power;
+
+			if ((start & (block - 1)) != 0 || start + block > end ||
+				offset >= mip_map_[level].length)
+				continue;
+
+			changes |= get_subsample<U>(level, offset);
+			start += block;
+			summarized = true;
+			break;
+		}
+
+		if (!summarized) {
+			changes |= get_sample<U>(start, cursor) ^
+				get_sample<U>(start - 1, cursor);
+			start++;
+		}
+	}
+
+	return changes;
+}
+
+template<unsigned int U>
+void LogicSegment::get_levels(uint64_t start, uint64_t end,
+	uint64_t &any_high, uint64_t &any_low) const
+{
+	ChunkCursor cursor;
+
+	any_high = any_low = 0;
+
+	while (start < end) {
+		// Take the largest mip-map block that fits, or else one sample
+		bool summarized = false;
+		for (int level = ScaleStepCount - 1; level >= 0; level--) {
+			const MipMapLevel &m = mip_map_[level];
+			const unsigned int power = (level + 1) * MipMapScalePower;
+			const uint64_t block = (uint64_t)1 << power;
+			const uint64_t offset = start >> power;
+
+			if ((start & (block - 1)) != 0 || start + block > end ||
+				offset >= m.length)
+				continue;
+
+			any_high |= get_subsample<U>(m.any_high, offset);
+			any_low |= get_subsample<U>(m.any_low, offset);
+			start += block;
+			summarized = true;
+			break;
+		}
+
+		if (!summarized) {
+			const uint64_t sample = get_sample<U>(start, cursor);
+			any_high |= sample;
+			any_low |= ~sample;
+			start++;
+		}
+	}
+}
+
+void LogicSegment::get_subsampled_levels(std::vector<uint8_t> &levels,
+	uint64_t start, uint64_t end,
+	float min_length, int sig_index)
+{
+	vector< vector<uint8_t> > signal_levels;
+	(this->*subsampled_levels_)(signal_levels, start, end, min_length,
+		vector<int>(1, sig_index));
+	levels.insert(levels.end(), signal_levels[0].begin(),
+		signal_levels[0].end());
+}
+
+void LogicSegment::get_subsampled_levels(
+	std::vector< std::vector<uint8_t> > &levels,
+	uint64_t start, uint64_t end,
+	float min_length, const std::vector<int> &sig_indices)
+{
+	(this->*subsampled_levels_)(levels, start, end, min_length,
+		sig_indices);
+}
+
+template<unsigned int U>
+void LogicSegment::get_subsampled_levels_unit(
+	std::vector< std::vector<uint8_t> > &levels,
+	uint64_t start, uint64_t end,
+	float min_length, const std::vector<int> &sig_indices)
+{
+	assert(end <= get_sample_count());
+	assert(start <= end);
+	assert(min_length > 0);
+
+	for (int sig_index : sig_indices) {
+		assert(sig_index >= 0);
+		assert(sig_index < 64);
+		(void)sig_index;
+	}
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	const double block_length = max(min_length, 1.0f);
+	const size_t sig_count = sig_indices.size();
+	levels.resize(sig_count);
+
+	// The blocks are at least one sample long, so each one ends after
+	// it begins. The samples before the first one held have been
+	// dropped, and have no level.
+	uint64_t index = start;
+	for (uint64_t i = 1; index < end; i++) {
+		const uint64_t final_index = min(end,
+			start + (uint64_t)(i * block_length));
+
+		uint64_t any_high = 0, any_low = 0;
+		if (final_index > first_sample_)
+			get_levels<U>(max(index, (uint64_t)first_sample_),
+				final_index, any_high, any_low);
+		for (size_t j = 0; j < sig_count; j++)
+			levels[j].push_back(
+				(((any_low >> sig_indices[j]) & 1) ? LevelLow : 0) |
+				(((any_high >> sig_indices[j]) & 1) ? LevelHigh : 0));
+
+		index = final_index;
+	}
+}
+
+void LogicSegment::get_subsampled_levels_transitions(
+	std::vector< std::vector<uint8_t> > &levels,
+	uint64_t start, uint64_t end,
+	float min_length, const std::vector<int> &sig_indices)
+{
+	assert(end <= get_sample_count());
+	assert(start <= end);
+	assert(min_length > 0);
+
+	for (int sig_index : sig_indices) {
+		assert(sig_index >= 0);
+		assert(sig_index < 64);
+		(void)sig_index;
+	}
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	const size_t sig_count = sig_indices.size();
+	levels.resize(sig_count);
+
+	if (start == end)
+		return;
+
+	const double block_length = max(min_length, 1.0f);
+	const uint64_t count = transition_count_;
+
+	// t is always the transition in effect at sample index - 1, or at
+	// the start sample
+	uint64_t t = find_transition(start);
+	uint64_t index = start;
+	for (uint64_t i = 1; index < end; i++) {
+		const uint64_t final_index = min(end,
+			start + (uint64_t)(i * block_length));
+
+		if (t + 1 < count && transition_index(t + 1) <= index)
+			t++;
+
+		uint64_t any_high = 0, any_low = 0;
+		while (true) {
+			const uint64_t state = get_transition_state(t);
+			any_high |= state;
+			any_low |= ~state;
+			if (t + 1 == count ||
+				transition_index(t + 1) >= final_index)
+				break;
+			t++;
+		}
+		for (size_t j = 0; j < sig_count; j++)
+			levels[j].push_back(
+				(((any_low >> sig_indices[j]) & 1) ? LevelLow : 0) |
+				(((any_high >> sig_indices[j]) & 1) ? LevelHigh : 0));
+
+		index = final_index;
+	}
+}
+
+template<unsigned int U>
+void LogicSegment::get_subsampled_edges_batch_unit(
+	std::vector< std::vector<EdgePair> > &edges,
+	uint64_t start, uint64_t end,
+	float min_length, const std::vector<int> &sig_indices)
+{
+	uint64_t sig_mask = 0;
+
+	assert(end <= get_sample_count());
+	assert(start <= end);
+	assert(min_length > 0);
+
+	for (int sig_index : sig_indices) {
+		assert(sig_index >= 0);
+		assert(sig_index < 64);
+		sig_mask |= 1ULL << sig_index;
+	}
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	// The samples before the first one held have been dropped
+	start = max(start, (uint64_t)first_sample_);
+	end = max(end, start);
+
+	const uint64_t block_length = (uint64_t)max(min_length, 1.0f);
+	const size_t sig_count = sig_indices.size();
+	edges.resize(sig_count);
+	ChunkCursor cursor;
+
+	// Store the initial states
+	uint64_t last_sample = get_sample<U>(start, cursor);
+	for (size_t i = 0; i < sig_count; i++)
+		edges[i].push_back(pair<int64_t, bool>(start,
+			(last_sample >> sig_indices[i]) & 1));
+
+	uint64_t index = start + 1;
+	while (index + block_length <= end) {
+		index = find_next_change<U>(index, end, sig_mask);
+
+		// Take the last sample of the quantization block
+		const uint64_t final_index = index + block_length;
+		if (final_index > end)
+			break;
+
+		// Every signal that changes within the block gets an edge
+		const uint64_t changes =
+			get_changes<U>(index, final_index) & sig_mask;
+		const uint64_t final_sample =
+			get_sample<U>(final_index - 1, cursor);
+
+		for (size_t i = 0; i < sig_count; i++)
+			if ((changes >> sig_indices[i]) & 1)
+				edges[i].push_back(pair<int64_t, bool>(index,
+					(final_sample >> sig_indices[i]) & 1));
+
+		index = final_index;
+		last_sample = final_sample;
+	}
+
+	// Add the final states
+	const uint64_t end_sample = get_sample<U>(end, cursor);
+	for (size_t i = 0; i < sig_count; i++) {
+		const bool last_state = (last_sample >> sig_indices[i]) & 1;
+		const bool end_state = (end_sample >> sig_indices[i]) & 1;
+		if (last_state != end_state)
+			edges[i].push_back(pair<int64_t, bool>(end, end_state));
+		edges[i].push_back(pair<int64_t, bool>(end + 1, end_state));
+	}
+}
+
+void LogicSegment::get_subsampled_edges_batch_transitions(
+	std::vector< std::vector<EdgePair> > &edges,
+	uint64_t start, uint64_t end,
+	float min_length, const std::vector<int> &sig_indices)
+{
+	uint64_t sig_mask = 0;
+
+	assert(end <= get_sample_count());
+	assert(start <= end);
+	assert(min_length > 0);
+
+	for (int sig_index : sig_indices) {
+		assert(sig_index >= 0);
+		assert(sig_index < 64);
+		sig_mask |= 1ULL << sig_index;
+	}
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	const uint64_t block_length = (uint64_t)max(min_length, 1.0f);
+	const uint64_t count = transition_count_;
+	const size_t sig_count = sig_indices.size();
+	edges.resize(sig_count);
+
+	// t is always the transition in effect at sample index - 1
+	uint64_t t = find_transition(start);
+	uint64_t last_sample = get_transition_state(t);
+	for (size_t i = 0; i < sig_count; i++)
+		edges[i].push_back(pair<int64_t, bool>(start,
+			(last_sample >> sig_indices[i]) & 1));
+
+	uint64_t index = start + 1;
+	while (index + block_length <= end) {
+		// Find the next transition that changes any of the signals
+		uint64_t next = t + 1;
+		while (next < count && transition_index(next) < end &&
+				((get_transition_state(next) ^ last_sample) &
+				sig_mask) == 0)
+			next++;
+
+		if (next == count || transition_index(next) >= end)
+			break;
+
+		index = transition_index(next);
+
+		// Take the last sample of the quantization block
+		const uint64_t final_index = index + block_length;
+		if (final_index > end)
+			break;
+
+		// Every signal that changes within the block gets an edge
+		uint64_t changes = 0;
+		uint64_t state = last_sample;
+		for (t = next; t < count && transition_index(t) < final_index;
+				t++) {
+			const uint64_t new_state = get_transition_state(t);
+			changes |= state ^ new_state;
+			state = new_state;
+		}
+		t--;
+
+		for (size_t i = 0; i < sig_count; i++)
+			if (((changes & sig_mask) >> sig_indices[i]) & 1)
+				edges[i].push_back(pair<int64_t, bool>(index,
+					(state >> sig_indices[i]) & 1));
+
+		index = final_index;
+		last_sample = state;
+	}
+
+	// Add the final states
+	while (t + 1 < count && transition_index(t + 1) <= end)
+		t++;
+
+	const uint64_t end_sample = get_transition_state(t);
+	for (size_t i = 0; i < sig_count; i++) {
+		const bool last_state = (last_sample >> sig_indices[i]) & 1;
+		const bool end_state = (end_sample >> sig_indices[i]) & 1;
+		if (last_state != end_state)
+			edges[i].push_back(pair<int64_t, bool>(end, end_state));
+		edges[i].push_back(pair<int64_t, bool>(end + 1, end_state));
+	}
+}
+
+void LogicSegment::get_subsampled_edges_transitions(
+	std::vector<EdgePair> &edges,
+	uint64_t start, uint64_t end,
+	float min_length, int sig_index)
+{
+	assert(end <= get_sample_count());
+	assert(start <= end);
+	assert(min_length > 0);
+	assert(sig_index >= 0);
+	assert(sig_index < 64);
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	const uint64_t block_length = (uint64_t)max(min_length, 1.0f);
+	const uint64_t count = transition_count_;
+	const unsigned int sig_byte = sig_index / 8;
+	const uint8_t sig_mask = 1 << (sig_index % 8);
+
+	const auto transition_state = [&](uint64_t t) {
+		return (transition_sample(t)[sig_byte] &
+			sig_mask) != 0;
+	};
+
+	// t is always the transition in effect at sample index - 1, so the
+	// cost of the search grows with the number of transitions rather
+	// than with the number of samples
+	uint64_t t = find_transition(start);
+	uint64_t index = start;
+	bool last_sample = transition_state(t);
+	edges.push_back(pair<int64_t, bool>(index++, last_sample));
+
+	while (index + block_length <= end) {
+		// Find the next transition that changes this signal
+		uint64_t next = t + 1;
+		while (next < count && transition_index(next) < end &&
+				transition_state(next) == last_sample)
+			next++;
+
+		if (next == count || transition_index(next) >= end)
+			break;
+
+		index = transition_index(next);
+
+		// Take the last sample of the quantization block
+		const uint64_t final_index = index + block_length;
+		if (final_index > end)
+			break;
+
+		t = next;
+		while (t + 1 < count && transition_index(t + 1) < final_index)
+			t++;
+
+		const bool final_sample = transition_state(t);
+		edges.push_back(pair<int64_t, bool>(index, final_sample));
+
+		index = final_index;
+		last_sample = final_sample;
+	}
+
+	// Add the final state
+	while (t + 1 < count && transition_index(t + 1) <= end)
+		t++;
+
+	const bool end_sample = transition_state(t);
+	if (last_sample != end_sample)
+		edges.push_back(pair<int64_t, bool>(end, end_sample));
+	edges.push_back(pair<int64_t, bool>(end + 1, end_sample));
+}
+
+template<unsigned int U>
 uint64_t LogicSegment::get_subsample(int level, uint64_t offset) const
 {
 	assert(level >= 0);
-	assert(mip_map_[level].data);
-	return unpack_sample((uint8_t*)mip_map_[level].data +
-		unit_size_ * offset);
+
+	return get_subsample<U>(mip_map_[level].data, offset);
+}
+
+template<unsigned int U>
+uint64_t LogicSegment::get_subsample(const PagedArray &plane,
+	uint64_t offset) const
+{
+	return unpack_sample<U ? U : 8>(plane.entry(offset));
+}
+
+uint64_t LogicSegment::get_subsample(int level, uint64_t offset) const
+{
+	assert(level >= 0);
+
+	uint64_t value = 0;
+	const uint8_t *const ptr = mip_map_[level].data.entry(offset);
+	for (unsigned int i = 0; i < min(unit_size_, 8U); i++)
+		value |= ((uint64_t)ptr[i]) << (8 * i);
+	return value;
+}
+
+uint64_t LogicSegment::get_transition_state(uint64_t transition) const
+{
+	uint64_t value = 0;
+	const uint8_t *const ptr = transition_sample(transition);
+	for (unsigned int i = 0; i < min(unit_size_, 8U); i++)
+		value |= ((uint64_t)ptr[i]) << (8 * i);
+	return value;
+}
+
+template<unsigned int U>
+LogicSegment::UnitFunctions LogicSegment::make_unit_functions()
+{
+	const UnitFunctions functions = {
+		&LogicSegment::get_subsampled_edges_unit<U>,
+		&LogicSegment::get_subsampled_edges_batch_unit<U>,
+		&LogicSegment::get_subsampled_levels_unit<U>,
+		&LogicSegment::append_transitions<U>,
+		&LogicSegment::find_next_edge_unit<U>,
+		&LogicSegment::find_previous_edge_unit<U>
+	};
+	return functions;
+}
+
+const LogicSegment::UnitFunctions& LogicSegment::unit_functions(
+	unsigned int unit_size)
+{
+	static const UnitFunctions functions[] = {
+		make_unit_functions<0>(),
+		make_unit_functions<1>(),
+		make_unit_functions<2>(),
+		make_unit_functions<3>(),
+		make_unit_functions<4>(),
+		make_unit_functions<5>(),
+		make_unit_functions<6>(),
+		make_unit_functions<7>(),
+		make_unit_functions<8>()
+	};
+
+	assert(unit_size > 0);
+
+	// Wider samples use the generic implementation
+	return functions[(unit_size <= 8) ? unit_size : 0];
 }
 
 uint64_t LogicSegment::pow2_ceil(uint64_t x, unsigned int power)
@@ -20,6 +20,7 @@
 #ifndef PULSEVIEW_PV_DATA_LOGICSEGMENT_HPP
 #define PULSEVIEW_PV_DATA_LOGICSEGMENT_HPP
 
+#include "pagedarray.hpp"
 #include "segment.hpp"
 
 #include <utility>
@@ -40,14 +41,22 @@ struct LongPulses;
 namespace pv {
 namespace data {
 
+class ChannelPacker;
+
 class LogicSegment : public Segment
 {
 private:
 	struct MipMapLevel
 	{
 		uint64_t length;
-		uint64_t data_length;
-		void *data;
+		/// The bits that change within each block
+		PagedArray data;
+		/// The bits that are high or low somewhere within each block
+		PagedArray any_high;
+		PagedArray any_low;
+		/// The number of edges of each signal within each block, up to
+		/// EdgeCountMax. Only kept from level 1 on, and only if asked for.
+		PagedArray edge_counts;
 	};
 
 private:
@@ -55,30 +64,280 @@ private:
 	static const int MipMapScalePower;
 	static const int MipMapScaleFactor;
 	static const float LogMipMapScaleFactor;
-	static const uint64_t MipMapDataUnit;
+	static const unsigned int EdgeCountMax;
 
 public:
 	typedef std::pair<int64_t, bool> EdgePair;
 
+	/// The states a signal takes within a block of samples
+	enum LevelFlags {
+		LevelLow = 1 << 0,
+		LevelHigh = 1 << 1
+	};
+
+	enum StorageMode {
+		/// Every sample is stored, and a mip-map is built over them
+		RawStorage,
+		/// Only the samples that differ from their predecessor are
+		/// stored, together with their index. Best for sparse signals.
+		TransitionStorage
+	};
+
+private:
+	typedef void (LogicSegment::*SubsampledEdgesFunction)(
+		std::vector<EdgePair> &edges, uint64_t start, uint64_t end,
+		float min_length, int sig_index);
+
+	typedef void (LogicSegment::*BatchedEdgesFunction)(
+		std::vector< std::vector<EdgePair> > &edges,
+		uint64_t start, uint64_t end, float min_length,
+		const std::vector<int> &sig_indices);
+
+	typedef void (LogicSegment::*SubsampledLevelsFunction)(
+		std::vector< std::vector<uint8_t> > &levels,
+		uint64_t start, uint64_t end, float min_length,
+		const std::vector<int> &sig_indices);
+
+	typedef void (LogicSegment::*AppendTransitionsFunction)(
+		const uint8_t *data, uint64_t samples);
+
+	typedef bool (LogicSegment::*FindEdgeFunction)(int sig_index,
+		uint64_t sample, uint64_t &edge) const;
+
+	/// The implementations specialized for one unit size
+	struct UnitFunctions
+	{
+		SubsampledEdgesFunction subsampled_edges;
+		BatchedEdgesFunction batched_edges;
+		SubsampledLevelsFunction subsampled_levels;
+		AppendTransitionsFunction append_transitions;
+		FindEdgeFunction next_edge;
+		FindEdgeFunction previous_edge;
+	};
+
 public:
+	/**
+	 * @param[in] packer Repacks the samples to the channels that are
+	 * 	kept, or nullptr to store the samples as they are.
+	 * @param[in] edge_counts Keeps the number of edges of each signal in
+	 * 	the mip-map, so that the edges of long ranges are counted
+	 * 	without searching for them. Only used in raw storage mode.
+	 */
 	LogicSegment(std::shared_ptr<sigrok::Logic> logic,
-		uint64_t samplerate, uint64_t expected_num_samples = 0);
+		uint64_t samplerate, uint64_t expected_num_samples = 0,
+		StorageMode storage_mode = RawStorage,
+		std::shared_ptr<ChunkAllocator> allocator =
+			std::shared_ptr<ChunkAllocator>(),
+		std::shared_ptr<const ChannelPacker> packer =
+			std::shared_ptr<const ChannelPacker>(),
+		bool edge_counts = false);
+
+	StorageMode storage_mode() const;
+
+	/**
+	 * Returns the packer the samples were repacked with, or nullptr if
+	 * they are stored as they came from the device.
+	 */
+	std::shared_ptr<const ChannelPacker> channel_packer() const;
+
+	/**
+	 * Returns the bit of a channel of the device in the samples of this
+	 * segment, or -1 if the channel was not captured. Segments whose
+	 * samples were repacked keep the channels in other bits.
+	 */
+	int channel_bit(unsigned int channel) const;
 
 	virtual ~LogicSegment();
 
 	void append_payload(std::shared_ptr<sigrok::Logic> logic);
 
-	const uint8_t* get_samples(int64_t start_sample, int64_t end_sample) const;
+	/**
+	 * Returns a zero-copy view onto the samples from @c start_sample up to
+	 * @c end_sample. The view may end early at a storage chunk boundary.
+	 * In transition storage mode the samples are expanded into a new
+	 * buffer of at most one chunk instead.
+	 * @see Segment::get_raw_samples_view()
+	 */
+	SegmentDataView get_samples(int64_t start_sample,
+		int64_t end_sample) const;
+
+	/**
+	 * Returns the number of stored transitions in transition storage
+	 * mode, including the first sample.
+	 */
+	uint64_t get_transition_count() const;
+
+	/**
+	 * Finds the first edge of a signal after a sample. The mip-map is
+	 * searched from the top down, so the cost grows with the logarithm
+	 * of the distance to the edge rather than with the distance itself.
+	 * @param[in] sig_index The index of the signal.
+	 * @param[in] sample The sample to search from.
+	 * @param[out] edge The index of the first sample after the edge.
+	 * @return false if there is no such edge.
+	 */
+	bool find_next_edge(int sig_index, uint64_t sample,
+		uint64_t &edge) const;
+
+	/**
+	 * Finds the last edge of a signal before a sample.
+	 * @see find_next_edge()
+	 */
+	bool find_previous_edge(int sig_index, uint64_t sample,
+		uint64_t &edge) const;
+
+	/**
+	 * Returns the number of edges of a signal at the samples from
+	 * @c start up to but not including @c end.
+	 */
+	uint64_t get_edge_count(int sig_index, uint64_t start,
+		uint64_t end) const;
+
+	/**
+	 * Returns true if the mip-map keeps the edge counts of the signals,
+	 * so that @c get_edge_counts() is cheap.
+	 */
+	bool has_edge_counts() const;
+
+	/**
+	 * Counts the edges of several signals in blocks of @c min_length
+	 * samples, e.g. for an activity heatmap. The blocks are the same as
+	 * those of @c get_subsampled_levels(). The counts are estimates:
+	 * the blocks of the mip-map whose counts have saturated are taken
+	 * to have an edge at every sample. Without @c has_edge_counts() the
+	 * edges are searched for one at a time.
+	 * @param[out] counts The vectors to append the count of each block
+	 * 	to, one for each entry of @c sig_indices.
+	 */
+	void get_edge_counts(std::vector< std::vector<uint64_t> > &counts,
+		uint64_t start, uint64_t end, float min_length,
+		const std::vector<int> &sig_indices) const;
+
+	MemoryUsage memory_usage() const;
+
+protected:
+	void summarize(uint64_t end);
+
+	void drop_summaries(uint64_t start);
 
 private:
-	uint64_t unpack_sample(const uint8_t *ptr) const;
-	void pack_sample(uint8_t *ptr, uint64_t value);
-	
-	void reallocate_mipmap_level(MipMapLevel &m);
+	/**
+	 * Unpacks a sample of @c U bytes. With @c U known at compile time
+	 * this compiles to a plain load.
+	 */
+	template<unsigned int U>
+	static uint64_t unpack_sample(const uint8_t *ptr);
+
+	void reserve_mipmap_level(MipMapLevel &m);
+
+	/**
+	 * Extends the mip-map over the samples up to @c end.
+	 */
+	void append_payload_to_mipmap(uint64_t end);
+
+	/**
+	 * Extends the edge counts over the blocks added to the mip-map.
+	 * Level 1 is counted from the samples, the levels above sum it up.
+	 * @param prev_lengths The lengths of the levels before they were
+	 * 	extended.
+	 */
+	void append_edge_counts(const uint64_t *prev_lengths);
+
+	/**
+	 * Returns the sample at @c index, which must be held. The chunk of
+	 * the sample is looked up through @c cursor, so that runs of samples
+	 * from the same chunk only look it up once.
+	 */
+	template<unsigned int U>
+	uint64_t get_sample(uint64_t index, ChunkCursor &cursor) const;
+
+	uint64_t get_sample(uint64_t index, ChunkCursor &cursor) const;
+
+	/**
+	 * Appends the samples that differ from their predecessor to the
+	 * transition list. @see TransitionStorage
+	 */
+	template<unsigned int U>
+	void append_transitions(const uint8_t *data, uint64_t samples);
+
+	template<unsigned int U>
+	bool find_next_edge_unit(int sig_index, uint64_t sample,
+		uint64_t &edge) const;
+
+	template<unsigned int U>
+	bool find_previous_edge_unit(int sig_index, uint64_t sample,
+		uint64_t &edge) const;
 
-	void append_payload_to_mipmap();
+	bool find_next_edge_transitions(int sig_index, uint64_t sample,
+		uint64_t &edge) const;
 
-	uint64_t get_sample(uint64_t index) const;
+	bool find_previous_edge_transitions(int sig_index, uint64_t sample,
+		uint64_t &edge) const;
+
+	/**
+	 * Counts the edges of a signal from @c start up to but not including
+	 * @c end, from the edge counts of the mip-map if they are kept, or
+	 * else one edge search at a time. Must be called with the lock held.
+	 * @param[in] exact false to take the saturated blocks of the mip-map
+	 * 	to have an edge at every sample, instead of comparing their
+	 * 	samples.
+	 */
+	uint64_t count_edges(int sig_index, uint64_t start, uint64_t end,
+		bool exact = true) const;
+
+	/**
+	 * Counts the edges of a signal from the largest blocks of the
+	 * mip-map that fit the range and hold an exact count, or unless
+	 * @c exact from the saturated blocks of level 1 too. The samples in
+	 * between are compared one by one.
+	 * @see count_edges()
+	 */
+	uint64_t count_edges_mipmap(int sig_index, uint64_t start,
+		uint64_t end, bool exact) const;
+
+	/**
+	 * Returns the position in the transition list of the transition
+	 * that is in effect at sample @c index.
+	 */
+	uint64_t find_transition(uint64_t index) const;
+
+	/**
+	 * Returns the index of the first sample of a transition.
+	 */
+	uint64_t transition_index(uint64_t transition) const;
+
+	/**
+	 * Returns the new sample of a transition, of unit_size_ bytes.
+	 */
+	const uint8_t* transition_sample(uint64_t transition) const;
+
+	void push_transition(uint64_t index, const uint8_t *sample);
+
+	/**
+	 * Returns the signals that change at a transition, or within a block
+	 * of @c level if @c level is not negative.
+	 */
+	uint64_t get_transition_changes(int level, uint64_t offset) const;
+
+	/**
+	 * Returns the first transition from @c begin up to @c end at which
+	 * any of the signals in @c mask changes, skipping the blocks of
+	 * transitions in which none of them does. Returns @c end if there
+	 * is none.
+	 */
+	uint64_t find_next_changed_transition(uint64_t begin, uint64_t end,
+		uint64_t mask) const;
+
+	/**
+	 * Returns the last transition from @c begin up to @c end at which
+	 * any of the signals in @c mask changes. Returns @c end if there is
+	 * none. @see find_next_changed_transition()
+	 */
+	uint64_t find_previous_changed_transition(uint64_t begin, uint64_t end,
+		uint64_t mask) const;
+
+	SegmentDataView get_transition_samples(uint64_t start,
+		uint64_t count) const;
 
 public:
 	/**
@@ -95,14 +354,184 @@ public:
 		uint64_t start, uint64_t end,
 		float min_length, int sig_index);
 
+	/**
+	 * Generates the lists of transitions of several signals in one pass
+	 * over the data. The mip-map words and samples that are read hold
+	 * the states of all signals, so the cost of the query grows with the
+	 * amount of data touched rather than with the number of signals.
+	 *
+	 * Unlike with @c get_subsampled_edges() the edges of all signals are
+	 * quantized to common blocks of @c min_length samples, which start
+	 * at the first change of any of the signals.
+	 * @param[out] edges The vectors to place the edges into, one for
+	 * 	each entry of @c sig_indices.
+	 * @param[in] start The start sample index.
+	 * @param[in] end The end sample index.
+	 * @param[in] min_length The minimum number of samples that
+	 * can be resolved at this level of detail.
+	 * @param[in] sig_indices The indices of the signals.
+	 */
+	void get_subsampled_edges(std::vector< std::vector<EdgePair> > &edges,
+		uint64_t start, uint64_t end,
+		float min_length, const std::vector<int> &sig_indices);
+
+	/**
+	 * Summarizes a signal in blocks of @c min_length samples, without
+	 * descending to the individual edges. Busy blocks can be drawn as
+	 * solid bars however many transitions they hold.
+	 * @param[out] levels The vector to append the @c LevelFlags of each
+	 * 	block to.
+	 * @param[in] start The start sample index.
+	 * @param[in] end The end sample index, exclusive.
+	 * @param[in] min_length The number of samples in each block.
+	 * @param[in] sig_index The index of the signal.
+	 */
+	void get_subsampled_levels(std::vector<uint8_t> &levels,
+		uint64_t start, uint64_t end,
+		float min_length, int sig_index);
+
+	/**
+	 * Summarizes several signals in blocks of @c min_length samples in
+	 * one pass. The blocks are summarized for all signals at once, so
+	 * the cost hardly grows with the number of signals.
+	 * @param[out] levels The vectors to append the @c LevelFlags of each
+	 * 	block to, one for each entry of @c sig_indices.
+	 * @see get_subsampled_levels()
+	 */
+	void get_subsampled_levels(std::vector< std::vector<uint8_t> > &levels,
+		uint64_t start, uint64_t end, float min_length,
+		const std::vector<int> &sig_indices);
+
 private:
+	/**
+	 * The implementation of @c get_subsampled_edges() for samples of
+	 * @c U bytes, or of any size wider than 8 bytes if @c U is 0.
+	 */
+	template<unsigned int U>
+	void get_subsampled_edges_unit(std::vector<EdgePair> &edges,
+		uint64_t start, uint64_t end,
+		float min_length, int sig_index);
+
+	template<unsigned int U>
+	void get_subsampled_edges_batch_unit(
+		std::vector< std::vector<EdgePair> > &edges,
+		uint64_t start, uint64_t end, float min_length,
+		const std::vector<int> &sig_indices);
+
+	void get_subsampled_edges_transitions(std::vector<EdgePair> &edges,
+		uint64_t start, uint64_t end,
+		float min_length, int sig_index);
+
+	void get_subsampled_edges_batch_transitions(
+		std::vector< std::vector<EdgePair> > &edges,
+		uint64_t start, uint64_t end, float min_length,
+		const std::vector<int> &sig_indices);
+
+	template<unsigned int U>
+	void get_subsampled_levels_unit(
+		std::vector< std::vector<uint8_t> > &levels,
+		uint64_t start, uint64_t end, float min_length,
+		const std::vector<int> &sig_indices);
+
+	void get_subsampled_levels_transitions(
+		std::vector< std::vector<uint8_t> > &levels,
+		uint64_t start, uint64_t end, float min_length,
+		const std::vector<int> &sig_indices);
+
+	/**
+	 * Returns the index of the first sample from @c index onwards, but
+	 * before @c end, that differs from its predecessor in any of the
+	 * bits of @c mask, or @c end if there is none.
+	 */
+	template<unsigned int U>
+	uint64_t find_next_change(uint64_t index, uint64_t end,
+		uint64_t mask) const;
+
+	/**
+	 * Returns the index of the last sample from @c begin onwards, but
+	 * before @c end, that differs from its predecessor in any of the
+	 * bits of @c mask, or @c end if there is none.
+	 */
+	template<unsigned int U>
+	uint64_t find_previous_change(uint64_t begin, uint64_t end,
+		uint64_t mask) const;
+
+	/**
+	 * Returns the bits that change in any sample from @c start up to
+	 * but not including @c end.
+	 */
+	template<unsigned int U>
+	uint64_t get_changes(uint64_t start, uint64_t end) const;
+
+	/**
+	 * Finds the bits that are high and the bits that are low in any
+	 * sample from @c start up to but not including @c end.
+	 */
+	template<unsigned int U>
+	void get_levels(uint64_t start, uint64_t end,
+		uint64_t &any_high, uint64_t &any_low) const;
+
+	template<unsigned int U>
 	uint64_t get_subsample(int level, uint64_t offset) const;
 
+	template<unsigned int U>
+	uint64_t get_subsample(const PagedArray &plane, uint64_t offset) const;
+
+	uint64_t get_subsample(int level, uint64_t offset) const;
+
+	uint64_t get_transition_state(uint64_t transition) const;
+
+	template<unsigned int U>
+	static UnitFunctions make_unit_functions();
+
+	static const UnitFunctions& unit_functions(unsigned int unit_size);
+
 	static uint64_t pow2_ceil(uint64_t x, unsigned int power);
 
 private:
+	const StorageMode storage_mode_;
+
+	const std::shared_ptr<const ChannelPacker> packer_;
+
+	/// True if the mip-map keeps the edge counts of the signals
+	const bool edge_counts_;
+
+	/// The number of signals the edges are counted of
+	const unsigned int edge_count_channels_;
+
+	/// The repacked samples of the payload being appended
+	std::vector<uint8_t> packed_payload_;
+
 	struct MipMapLevel mip_map_[ScaleStepCount];
-	uint64_t last_append_sample_;
+
+	/// The specializations of @c get_subsampled_edges() for this segment
+	SubsampledEdgesFunction subsampled_edges_;
+	BatchedEdgesFunction batched_edges_;
+	SubsampledLevelsFunction subsampled_levels_;
+
+	/// The specializations of the ingestion functions for this unit size
+	AppendTransitionsFunction append_transitions_;
+
+	/// The specializations of the edge searches for this segment
+	FindEdgeFunction next_edge_;
+	FindEdgeFunction previous_edge_;
+
+	/// The sample index of every transition, in transition storage mode
+	PagedArray transition_indices_;
+
+	/// The new sample of every transition, unit_size_ bytes each
+	PagedArray transition_samples_;
+
+	uint64_t transition_count_;
+
+	/// The signals that change within every complete block of
+	/// 16^(level+1) transitions, so that the edge searches skip the
+	/// blocks in which a signal stays the same
+	PagedArray transition_changes_[ScaleStepCount];
+
+	/// The signals that change within the blocks that are not complete
+	/// yet
+	uint64_t pending_changes_[ScaleStepCount];
 
 	friend struct LogicSegmentTest::Pow2;
 	friend struct LogicSegmentTest::Basic;
@@ -0,0 +1,208 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+
+#include <algorithm>
+
+#include "measurementworker.hpp"
+
+using std::atomic;
+using std::function;
+using std::lock_guard;
+using std::max;
+using std::min;
+using std::mutex;
+using std::unique_lock;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+MeasurementWorker::MeasurementWorker(function<void ()> updated) :
+	updated_(updated),
+	has_pending_(false),
+	restart_(false),
+	interrupt_(false)
+{
+	measure_thread_ = std::thread(&MeasurementWorker::measure_proc, this);
+}
+
+MeasurementWorker::~MeasurementWorker()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		interrupt_ = true;
+		restart_ = true;
+	}
+	cond_.notify_one();
+	measure_thread_.join();
+}
+
+void MeasurementWorker::measure(const vector<AnalogMeasurements> &ranges)
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		pending_ = ranges;
+		has_pending_ = true;
+		restart_ = true;
+	}
+	cond_.notify_one();
+}
+
+vector<AnalogMeasurements> MeasurementWorker::results() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return results_;
+}
+
+bool MeasurementWorker::measure_range(AnalogMeasurements &m,
+	const atomic<bool> &interrupt)
+{
+	assert(m.segment);
+	const AnalogSegment &segment = *m.segment;
+
+	m.statistics = segment.get_statistics(m.start, m.end);
+	m.rising_edges = m.falling_edges = 0;
+	m.rise_time = m.fall_time = m.frequency = 0.0;
+
+	const AnalogSegment::Statistics &st = m.statistics;
+	if (!(st.max > st.min))
+		return true;
+
+	const float low = st.min + 0.1 * st.peak_to_peak();
+	const float mid = st.min + 0.5 * st.peak_to_peak();
+	const float high = st.min + 0.9 * st.peak_to_peak();
+
+	// Start from wherever the samples first settle below or above
+	const uint64_t first_low = segment.find_level(
+		m.start, m.end, low, false);
+	const uint64_t first_high = segment.find_level(
+		m.start, m.end, high, true);
+	bool is_high = first_high < first_low;
+
+	double rise_total = 0.0, fall_total = 0.0;
+	double first_mid = 0.0, last_mid = 0.0;
+
+	for (uint64_t index = min(first_low, first_high); index < m.end;) {
+		if (interrupt)
+			return false;
+
+		// The edge ends at the first sample past the far threshold,
+		// and begins after the last sample at the near one
+		const float from = is_high ? high : low;
+		const float to = is_high ? low : high;
+
+		const uint64_t edge_end = segment.find_level(
+			index, m.end, to, !is_high);
+		if (edge_end == m.end)
+			break;
+
+		const uint64_t edge_start = segment.find_level(
+			index, edge_end, from, is_high, true);
+		const uint64_t mid_start = segment.find_level(
+			edge_start, edge_end, mid, is_high, true);
+		assert(edge_start < edge_end);
+		assert(mid_start < edge_end);
+
+		const double duration =
+			find_crossing(segment, edge_end - 1, to) -
+			find_crossing(segment, edge_start, from);
+
+		if (is_high) {
+			fall_total += duration;
+			m.falling_edges++;
+		} else {
+			const double t = find_crossing(segment, mid_start, mid);
+			if (m.rising_edges == 0)
+				first_mid = t;
+			last_mid = t;
+
+			rise_total += duration;
+			m.rising_edges++;
+		}
+
+		index = edge_end;
+		is_high = !is_high;
+	}
+
+	const double samplerate = max(1.0, segment.samplerate());
+	if (m.rising_edges > 0)
+		m.rise_time = rise_total / m.rising_edges / samplerate;
+	if (m.falling_edges > 0)
+		m.fall_time = fall_total / m.falling_edges / samplerate;
+	if (m.rising_edges > 1)
+		m.frequency = (m.rising_edges - 1) * samplerate /
+			(last_mid - first_mid);
+
+	return true;
+}
+
+double MeasurementWorker::find_crossing(const AnalogSegment &segment,
+	uint64_t index, float level)
+{
+	const float a = *(const float*)segment.get_samples(
+		index, index + 1).data();
+	const float b = *(const float*)segment.get_samples(
+		index + 1, index + 2).data();
+
+	return index + min(max((level - a) / (b - a), 0.0f), 1.0f);
+}
+
+void MeasurementWorker::measure_proc()
+{
+	vector<AnalogMeasurements> ranges;
+
+	while (true) {
+		{
+			unique_lock<mutex> lock(mutex_);
+			while (!interrupt_ && !has_pending_)
+				cond_.wait(lock);
+
+			if (interrupt_)
+				return;
+
+			ranges.swap(pending_);
+			pending_.clear();
+			has_pending_ = false;
+			restart_ = false;
+		}
+
+		bool complete = true;
+		for (AnalogMeasurements &m : ranges) {
+			complete = measure_range(m, restart_);
+			if (!complete)
+				break;
+		}
+
+		if (!complete)
+			continue;
+
+		{
+			lock_guard<mutex> lock(mutex_);
+			results_.swap(ranges);
+		}
+
+		if (updated_)
+			updated_();
+	}
+}
+
+} // namespace data
+} // namespace pv
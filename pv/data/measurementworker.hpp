@@ -0,0 +1,124 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_MEASUREMENTWORKER_HPP
+#define PULSEVIEW_PV_DATA_MEASUREMENTWORKER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "analogsegment.hpp"
+
+namespace pv {
+namespace data {
+
+/**
+ * The measurements of the samples of an analog segment from @c start up
+ * to @c end. The edges are the swings from 10% to 90% of the
+ * peak-to-peak range and back. The rise and fall times are averaged
+ * over them, in seconds, and are 0 without any edges. The frequency is
+ * taken from the rising edges at 50%, in hertz, and is 0 without at
+ * least two of them.
+ */
+struct AnalogMeasurements
+{
+	std::shared_ptr<AnalogSegment> segment;
+	uint64_t start;
+	uint64_t end;
+
+	AnalogSegment::Statistics statistics;
+
+	unsigned int rising_edges;
+	unsigned int falling_edges;
+	double rise_time;
+	double fall_time;
+	double frequency;
+};
+
+/**
+ * Takes the measurements of ranges of analog segments on a thread of its
+ * own. The extremes and sums come from the envelope levels, and the
+ * edges are found by skipping the envelope blocks that cannot hold them,
+ * so only the ragged ends and the edges themselves are read sample by
+ * sample.
+ */
+class MeasurementWorker
+{
+public:
+	/**
+	 * @param[in] updated Called from the worker thread whenever the
+	 * 	measurements of the latest ranges are ready.
+	 */
+	MeasurementWorker(std::function<void ()> updated);
+
+	~MeasurementWorker();
+
+	/**
+	 * Schedules the measurement of @c ranges, of which @c segment,
+	 * @c start and @c end are set. Measurements that are pending or in
+	 * progress are abandoned.
+	 */
+	void measure(const std::vector<AnalogMeasurements> &ranges);
+
+	/**
+	 * Returns the measurements of the ranges that were last completed.
+	 */
+	std::vector<AnalogMeasurements> results() const;
+
+	/**
+	 * Measures the range set in @c m. Returns false if it was
+	 * abandoned because @c interrupt was set.
+	 */
+	static bool measure_range(AnalogMeasurements &m,
+		const std::atomic<bool> &interrupt);
+
+private:
+	/**
+	 * Returns the fractional index, from @c index, where the samples at
+	 * @c index and @c index + 1 cross @c level.
+	 */
+	static double find_crossing(const AnalogSegment &segment,
+		uint64_t index, float level);
+
+	void measure_proc();
+
+private:
+	const std::function<void ()> updated_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable cond_;
+	std::vector<AnalogMeasurements> pending_;
+	bool has_pending_;
+	std::vector<AnalogMeasurements> results_;
+
+	/// Set to abandon the measurements in progress
+	std::atomic<bool> restart_;
+	std::atomic<bool> interrupt_;
+	std::thread measure_thread_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_MEASUREMENTWORKER_HPP
@@ -0,0 +1,50 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memoryusage.hpp"
+
+namespace pv {
+namespace data {
+
+MemoryUsage::MemoryUsage() :
+	samples(0),
+	compressed(0),
+	spilled(0),
+	summaries(0),
+	annotations(0)
+{
+}
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage &other)
+{
+	samples += other.samples;
+	compressed += other.compressed;
+	spilled += other.spilled;
+	summaries += other.summaries;
+	annotations += other.annotations;
+	return *this;
+}
+
+uint64_t MemoryUsage::total() const
+{
+	return samples + compressed + summaries + annotations;
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_MEMORYUSAGE_HPP
+#define PULSEVIEW_PV_DATA_MEMORYUSAGE_HPP
+
+#include <cstdint>
+
+namespace pv {
+namespace data {
+
+/**
+ * The memory held by acquired data, in bytes by category.
+ */
+struct MemoryUsage
+{
+	MemoryUsage();
+
+	MemoryUsage& operator+=(const MemoryUsage &other);
+
+	/**
+	 * Returns the number of bytes held in memory, i.e. everything but the
+	 * spilled samples.
+	 */
+	uint64_t total() const;
+
+	/// Uncompressed samples in memory, including decompressed copies
+	uint64_t samples;
+
+	/// Compressed samples
+	uint64_t compressed;
+
+	/// Samples in the scratch file of the chunk allocator
+	uint64_t spilled;
+
+	/// Mip-maps and envelopes
+	uint64_t summaries;
+
+	/// Decoder annotations
+	uint64_t annotations;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_MEMORYUSAGE_HPP
@@ -0,0 +1,109 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+
+#include "pagedarray.hpp"
+
+using std::default_delete;
+using std::shared_ptr;
+
+namespace pv {
+namespace data {
+
+const uint64_t PagedArray::MaxPageSize = 64 * 1024;	// bytes
+
+PagedArray::PagedArray(unsigned int entry_size) :
+	entry_size_(entry_size),
+	page_power_(0),
+	first_page_(0)
+{
+	assert(entry_size_ > 0);
+
+	// Use the largest power-of-two number of entries that fits a page
+	while (((uint64_t)2 << page_power_) * entry_size_ <= MaxPageSize)
+		page_power_++;
+}
+
+unsigned int PagedArray::entry_size() const
+{
+	return entry_size_;
+}
+
+uint64_t PagedArray::capacity() const
+{
+	return (first_page_ + pages_.size()) << page_power_;
+}
+
+uint64_t PagedArray::first() const
+{
+	return first_page_ << page_power_;
+}
+
+void PagedArray::reserve(uint64_t length)
+{
+	while (capacity() < length)
+		pages_.emplace_back(new uint8_t[page_size()],
+			default_delete<uint8_t[]>());
+}
+
+void PagedArray::drop_before(uint64_t index)
+{
+	const uint64_t page = index >> page_power_;
+	while (first_page_ < page && !pages_.empty()) {
+		pages_.pop_front();
+		first_page_++;
+	}
+}
+
+uint8_t* PagedArray::entry(uint64_t index) const
+{
+	assert(index >= first());
+	assert(index < capacity());
+
+	return pages_[(index >> page_power_) - first_page_].get() +
+		(index & ((1ULL << page_power_) - 1)) * entry_size_;
+}
+
+shared_ptr<const uint8_t> PagedArray::page(uint64_t index) const
+{
+	assert(index >= first());
+	assert(index < capacity());
+
+	return pages_[(index >> page_power_) - first_page_];
+}
+
+uint64_t PagedArray::contiguous_entries(uint64_t index) const
+{
+	return (1ULL << page_power_) - (index & ((1ULL << page_power_) - 1));
+}
+
+uint64_t PagedArray::memory_usage() const
+{
+	return pages_.size() * page_size();
+}
+
+uint64_t PagedArray::page_size() const
+{
+	// Padding is added to allow for the uint64_t read word
+	return (entry_size_ << page_power_) + sizeof(uint64_t);
+}
+
+} // namespace data
+} // namespace pv
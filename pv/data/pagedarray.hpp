@@ -0,0 +1,109 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_PAGEDARRAY_HPP
+#define PULSEVIEW_PV_DATA_PAGEDARRAY_HPP
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+namespace pv {
+namespace data {
+
+/**
+ * An array of fixed-size entries, stored in pages like the samples of a
+ * segment. The array grows at the end and may drop its oldest pages from
+ * the front, so the entries it holds are never moved or copied. Entries
+ * keep their index when the pages before them are dropped.
+ *
+ * Used for the summaries of the segments, e.g. the levels of a mip-map.
+ */
+class PagedArray
+{
+private:
+	/// The largest size of a page in bytes
+	static const uint64_t MaxPageSize;
+
+public:
+	PagedArray(unsigned int entry_size = 1);
+
+	unsigned int entry_size() const;
+
+	/**
+	 * Returns the number of entries that can be stored without allocating
+	 * another page, including the dropped ones.
+	 */
+	uint64_t capacity() const;
+
+	/**
+	 * Returns the index of the first entry that is still held.
+	 */
+	uint64_t first() const;
+
+	/**
+	 * Allocates pages until at least @c length entries can be stored.
+	 */
+	void reserve(uint64_t length);
+
+	/**
+	 * Frees the pages that only hold entries before @c index.
+	 */
+	void drop_before(uint64_t index);
+
+	/**
+	 * Returns a pointer to an entry, which must be held by the array.
+	 * The entries up to the end of the page follow it contiguously.
+	 */
+	uint8_t* entry(uint64_t index) const;
+
+	/**
+	 * Returns the page that holds the entry at @c index. Holding on to the
+	 * page keeps its entries valid after it has been dropped.
+	 */
+	std::shared_ptr<const uint8_t> page(uint64_t index) const;
+
+	/**
+	 * Returns the number of entries stored contiguously after and
+	 * including the entry at @c index, i.e. up to the end of its page.
+	 */
+	uint64_t contiguous_entries(uint64_t index) const;
+
+	/**
+	 * Returns the number of bytes allocated for the pages.
+	 */
+	uint64_t memory_usage() const;
+
+private:
+	uint64_t page_size() const;
+
+private:
+	unsigned int entry_size_;
+	unsigned int page_power_;
+
+	/// The index of the page at the front of pages_
+	uint64_t first_page_;
+
+	std::deque< std::shared_ptr<uint8_t> > pages_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_PAGEDARRAY_HPP
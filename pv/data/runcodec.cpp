@@ -0,0 +1,97 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "runcodec.hpp"
+
+using std::min;
+using std::vector;
+
+namespace pv {
+namespace data {
+namespace runcodec {
+
+bool encode(const uint8_t *src, uint64_t sample_count,
+	unsigned int unit_size, vector<uint8_t> &dest, uint64_t max_size)
+{
+	const uint8_t *const end = src + sample_count * unit_size;
+
+	dest.clear();
+
+	while (src < end) {
+		// Find the end of the run
+		const uint8_t *run_end = src + unit_size;
+		while (run_end < end && memcmp(run_end, src, unit_size) == 0)
+			run_end += unit_size;
+
+		// The longest encoded run length has 10 bytes
+		if (dest.size() + 10 + unit_size > max_size)
+			return false;
+
+		for (uint64_t length = (run_end - src) / unit_size; ;
+				length >>= 7) {
+			if (length < 0x80) {
+				dest.push_back(length);
+				break;
+			}
+			dest.push_back((length & 0x7F) | 0x80);
+		}
+
+		dest.insert(dest.end(), src, src + unit_size);
+		src = run_end;
+	}
+
+	return true;
+}
+
+void decode(const uint8_t *src, uint64_t size, uint8_t *dest,
+	unsigned int unit_size)
+{
+	const uint8_t *const end = src + size;
+
+	while (src < end) {
+		uint64_t length = 0;
+		for (unsigned int shift = 0; ; shift += 7) {
+			length |= (uint64_t)(*src & 0x7F) << shift;
+			if (!(*src++ & 0x80))
+				break;
+		}
+
+		assert(length > 0);
+		assert(src + unit_size <= end);
+
+		// Fill the run by doubling the part that is already filled
+		memcpy(dest, src, unit_size);
+		const uint64_t run_size = length * unit_size;
+		for (uint64_t filled = unit_size; filled < run_size;
+				filled += min(filled, run_size - filled))
+			memcpy(dest + filled, dest, min(filled, run_size - filled));
+
+		src += unit_size;
+		dest += run_size;
+	}
+}
+
+} // namespace runcodec
+} // namespace data
+} // namespace pv
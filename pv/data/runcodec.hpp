@@ -0,0 +1,61 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_RUNCODEC_HPP
+#define PULSEVIEW_PV_DATA_RUNCODEC_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace pv {
+namespace data {
+namespace runcodec {
+
+/**
+ * Encodes samples as runs of identical samples. Each run is stored as its
+ * length in LEB128 followed by the sample. Idle buses and slow signals
+ * shrink by orders of magnitude, and decoding runs at memory speed.
+ *
+ * @param[in] src The samples to encode.
+ * @param[in] sample_count The number of samples.
+ * @param[in] unit_size The size of one sample in bytes.
+ * @param[out] dest The encoded samples.
+ * @param[in] max_size The largest encoded size that is worth keeping.
+ * @return false if the samples do not fit into @c max_size bytes. Encoding
+ * 	stops as soon as that is known.
+ */
+bool encode(const uint8_t *src, uint64_t sample_count,
+	unsigned int unit_size, std::vector<uint8_t> &dest, uint64_t max_size);
+
+/**
+ * Decodes samples encoded by @c encode().
+ *
+ * @param[in] src The encoded samples.
+ * @param[in] size The size of the encoded samples in bytes.
+ * @param[out] dest The decoded samples.
+ * @param[in] unit_size The size of one sample in bytes.
+ */
+void decode(const uint8_t *src, uint64_t size, uint8_t *dest,
+	unsigned int unit_size);
+
+} // namespace runcodec
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_RUNCODEC_HPP
@@ -17,40 +17,128 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "chunkallocator.hpp"
+#include "runcodec.hpp"
 #include "segment.hpp"
 
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+
+using boost::shared_lock;
+using boost::shared_mutex;
+using boost::unique_lock;
+
+using std::default_delete;
 using std::lock_guard;
-using std::recursive_mutex;
+using std::make_pair;
+using std::make_shared;
+using std::max;
+using std::min;
+using std::mutex;
+using std::pair;
+using std::shared_ptr;
+using std::vector;
 
 namespace pv {
 namespace data {
 
-Segment::Segment(uint64_t samplerate, unsigned int unit_size) :
+const uint64_t Segment::MaxChunkSize = 1024 * 1024;	// bytes
+const uint64_t Segment::HotChunkCount = 2;
+const unsigned int Segment::ChunkCacheSize = 8;
+
+SegmentDataView::SegmentDataView() :
+	data_(nullptr),
+	sample_count_(0),
+	unit_size_(0)
+{
+}
+
+SegmentDataView::SegmentDataView(shared_ptr<const uint8_t> chunk,
+	const uint8_t *data, uint64_t sample_count, unsigned int unit_size) :
+	chunk_(chunk),
+	data_(data),
+	sample_count_(sample_count),
+	unit_size_(unit_size)
+{
+}
+
+const uint8_t* SegmentDataView::data() const
+{
+	return data_;
+}
+
+uint64_t SegmentDataView::sample_count() const
+{
+	return sample_count_;
+}
+
+uint64_t SegmentDataView::size() const
+{
+	return sample_count_ * unit_size_;
+}
+
+bool SegmentDataView::empty() const
+{
+	return sample_count_ == 0;
+}
+
+Segment::Segment(uint64_t samplerate, unsigned int unit_size,
+	shared_ptr<ChunkAllocator> allocator) :
+	chunk_offset_(0),
 	sample_count_(0),
+	first_sample_(0),
+	summarized_sample_count_(0),
 	start_time_(0),
 	samplerate_(samplerate),
 	capacity_(0),
-	unit_size_(unit_size)
+	unit_size_(unit_size),
+	chunk_samples_(1),
+	chunk_sample_power_(0),
+	allocator_(allocator),
+	retention_(0),
+	resident_size_(0),
+	spilled_size_(0),
+	next_spill_chunk_(0),
+	next_compressed_chunk_(0),
+	compressed_size_(0)
 {
-	lock_guard<recursive_mutex> lock(mutex_);
 	assert(unit_size_ > 0);
+
+	// Use the largest power-of-two number of samples that fits a chunk
+	while ((chunk_samples_ << 1) * unit_size_ <= MaxChunkSize) {
+		chunk_samples_ <<= 1;
+		chunk_sample_power_++;
+	}
 }
 
 Segment::~Segment()
 {
-	lock_guard<recursive_mutex> lock(mutex_);
+	unique_lock<shared_mutex> lock(mutex_);
 }
 
 uint64_t Segment::get_sample_count() const
 {
-	lock_guard<recursive_mutex> lock(mutex_);
 	return sample_count_;
 }
 
+uint64_t Segment::get_first_sample() const
+{
+	return first_sample_;
+}
+
+uint64_t Segment::retention() const
+{
+	return retention_;
+}
+
+void Segment::set_retention(uint64_t samples)
+{
+	retention_ = samples;
+}
+
 const pv::util::Timestamp& Segment::start_time() const
 {
 	return start_time_;
@@ -61,6 +149,16 @@ double Segment::samplerate() const
 	return samplerate_;
 }
 
+uint64_t Segment::time_to_sample(const pv::util::Timestamp &time) const
+{
+	const pv::util::Timestamp sample =
+		ceil(max(samplerate_, 1.0) * (time - start_time_));
+	if (sample <= 0)
+		return 0;
+
+	return min(sample.convert_to<uint64_t>(), get_sample_count());
+}
+
 void Segment::set_samplerate(double samplerate)
 {
 	samplerate_ = samplerate;
@@ -73,36 +171,506 @@ unsigned int Segment::unit_size() const
 
 void Segment::set_capacity(const uint64_t new_capacity)
 {
-	lock_guard<recursive_mutex> lock(mutex_);
+	// Only the writer grows the segment, so the capacity may be checked
+	// without the lock. The chunk being filled may have been released.
+	assert(capacity_ >= (sample_count_ & ~(chunk_samples_ - 1)));
+	if (capacity_ >= new_capacity)
+		return;
 
-	assert(capacity_ >= sample_count_);
-	if (new_capacity > capacity_) {
-		// If we're out of memory, this will throw std::bad_alloc
-		data_.resize((new_capacity * unit_size_) + sizeof(uint64_t));
-		capacity_ = new_capacity;
+	// Allocate the chunks before taking the lock, so that readers are
+	// only held up while the chunk list is extended
+	vector< shared_ptr<uint8_t> > chunks;
+	uint64_t capacity = capacity_, resident_size = 0, spilled_size = 0;
+	while (capacity < new_capacity) {
+		const uint64_t chunk_num = capacity >> chunk_sample_power_;
+		chunks.push_back(allocate_chunk(chunk_num));
+		if (ChunkAllocator::is_spilled(chunks.back()))
+			spilled_size += chunk_size(chunk_num);
+		else
+			resident_size += chunk_size(chunk_num);
+		capacity += chunk_samples_;
 	}
+
+	unique_lock<shared_mutex> lock(mutex_);
+
+	// Release the entries of the dropped chunks. Only the writer does
+	// this, so that it can keep reading the chunk list without the lock.
+	for (; chunk_offset_ < (first_sample_ >> chunk_sample_power_);
+			chunk_offset_++) {
+		data_chunks_.pop_front();
+		compressed_chunks_.pop_front();
+	}
+
+	data_chunks_.insert(data_chunks_.end(), chunks.begin(), chunks.end());
+	resident_size_ += resident_size;
+	spilled_size_ += spilled_size;
+	compressed_chunks_.resize(data_chunks_.size());
+	capacity_ = capacity;
 }
 
 uint64_t Segment::capacity() const
 {
-	lock_guard<recursive_mutex> lock(mutex_);
-	return data_.size();
+	shared_lock<shared_mutex> lock(mutex_);
+	return capacity_;
 }
 
-void Segment::append_data(void *data, uint64_t samples)
+void Segment::get_raw_samples(uint64_t start, uint64_t count,
+	uint8_t *dest) const
+{
+	assert(start + count <= sample_count_);
+	assert(dest);
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	if (start < first_sample_) {
+		const uint64_t n = min(count, first_sample_ - start);
+		memset(dest, 0, n * unit_size_);
+		dest += n * unit_size_;
+		start += n;
+		count -= n;
+	}
+
+	while (count > 0) {
+		const uint64_t n = min(count, contiguous_samples(start));
+		const shared_ptr<uint8_t> chunk =
+			chunk_data(start >> chunk_sample_power_);
+		memcpy(dest, chunk.get() +
+			(start & (chunk_samples_ - 1)) * unit_size_, n * unit_size_);
+		dest += n * unit_size_;
+		start += n;
+		count -= n;
+	}
+}
+
+SegmentDataView Segment::get_raw_samples_view(uint64_t start,
+	uint64_t count) const
+{
+	assert(start + count <= sample_count_);
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	if (count == 0)
+		return SegmentDataView();
+
+	if (start < first_sample_) {
+		const uint64_t n = min(min(count, first_sample_ - start),
+			contiguous_samples(start));
+		const shared_ptr<uint8_t> zeros(new uint8_t[n * unit_size_](),
+			default_delete<uint8_t[]>());
+		return SegmentDataView(zeros, zeros.get(), n, unit_size_);
+	}
+
+	const shared_ptr<uint8_t> chunk = chunk_data(start >> chunk_sample_power_);
+	return SegmentDataView(chunk,
+		chunk.get() + (start & (chunk_samples_ - 1)) * unit_size_,
+		min(count, contiguous_samples(start)), unit_size_);
+}
+
+shared_ptr<SegmentPin> Segment::pin_samples(uint64_t start,
+	uint64_t end) const
+{
+	const shared_ptr<SegmentPin> pin = make_shared<SegmentPin>();
+
+	shared_lock<shared_mutex> lock(mutex_);
+
+	// Segments that do not keep their samples in chunks have none
+	start = max(start, (uint64_t)first_sample_);
+	end = min(end, min((uint64_t)sample_count_,
+		(chunk_offset_ + data_chunks_.size()) << chunk_sample_power_));
+	if (start >= end)
+		return pin;
+
+	const uint64_t first_chunk = start >> chunk_sample_power_;
+	const uint64_t end_chunk = ((end - 1) >> chunk_sample_power_) + 1;
+	if (end_chunk - first_chunk > ChunkCacheSize)
+		return pin;
+
+	for (uint64_t c = first_chunk; c < end_chunk; c++)
+		pin->chunks_.push_back(chunk_data(c));
+
+	lock_guard<mutex> cache_lock(cache_mutex_);
+
+	// Forget the chunks of the pins that have been released
+	for (auto i = pinned_chunks_.begin(); i != pinned_chunks_.end();)
+		if ((*i).second.expired())
+			i = pinned_chunks_.erase(i);
+		else
+			i++;
+
+	for (uint64_t c = first_chunk; c < end_chunk; c++)
+		pinned_chunks_[c] = pin->chunks_[c - first_chunk];
+
+	return pin;
+}
+
+bool Segment::update_summaries()
 {
-	lock_guard<recursive_mutex> lock(mutex_);
+	{
+		unique_lock<shared_mutex> lock(mutex_);
+
+		const uint64_t sample_count = sample_count_;
+		if (summarized_sample_count_ == sample_count)
+			return false;
+
+		const uint64_t end = min(sample_count, summarized_sample_count_ +
+			contiguous_samples(summarized_sample_count_));
+		summarize(end);
+		summarized_sample_count_ = end;
+	}
 
-	assert(capacity_ >= sample_count_);
+	drop_old_chunks();
+	compress_cold_chunks();
 
+	return true;
+}
+
+uint64_t Segment::get_summarized_sample_count() const
+{
+	return summarized_sample_count_;
+}
+
+MemoryUsage Segment::memory_usage() const
+{
+	MemoryUsage usage;
+
+	shared_lock<shared_mutex> lock(mutex_);
+	usage.samples = resident_size_;
+	usage.spilled = spilled_size_;
+	usage.compressed = compressed_size_;
+
+	lock_guard<mutex> cache_lock(cache_mutex_);
+	for (const pair< uint64_t, shared_ptr<uint8_t> > &entry : chunk_cache_)
+		usage.samples += chunk_size(entry.first);
+
+	return usage;
+}
+
+void Segment::append_data(void *data, uint64_t samples)
+{
 	// Ensure there's enough capacity to copy.
-	const uint64_t free_space = capacity_ - sample_count_;
-	if (free_space < samples)
-		set_capacity(sample_count_ + samples);
+	set_capacity(sample_count_ + samples);
+
+	// Only the writer changes the chunk list, so it may be read here
+	// without the lock. Readers see the samples once the count is
+	// updated.
+	const uint8_t *src = (const uint8_t*)data;
+	uint64_t sample_count = sample_count_;
+	while (samples > 0) {
+		const uint64_t n = min(samples, contiguous_samples(sample_count));
+		memcpy(raw_sample(sample_count), src, n * unit_size_);
+		src += n * unit_size_;
+		sample_count += n;
+		samples -= n;
+	}
+
+	sample_count_ = sample_count;
+}
 
-	memcpy((uint8_t*)data_.data() + sample_count_ * unit_size_,
-		data, samples * unit_size_);
-	sample_count_ += samples;
+uint64_t Segment::chunk_size(uint64_t chunk_num) const
+{
+	// Padding is added to allow for the uint64_t read word
+	return chunk_samples_ * chunk_unit_size(chunk_num) + sizeof(uint64_t);
+}
+
+shared_ptr<uint8_t> Segment::allocate_chunk(uint64_t chunk_num)
+{
+	const uint64_t size = chunk_size(chunk_num);
+
+	// If we're out of memory, this will throw std::bad_alloc
+	if (!allocator_)
+		return shared_ptr<uint8_t>(new uint8_t[size],
+			default_delete<uint8_t[]>());
+
+	// Make room within the RAM budget by spilling the oldest chunks of the
+	// segment. Once there are none left, the new chunk is spilled itself.
+	shared_ptr<uint8_t> chunk;
+	while (!(chunk = allocator_->allocate_resident(size)))
+		if (!spill_chunk())
+			return allocator_->allocate_spilled(size);
+
+	return chunk;
+}
+
+bool Segment::spill_chunk()
+{
+	const uint64_t full_chunks = sample_count_ >> chunk_sample_power_;
+
+	next_spill_chunk_ = max(next_spill_chunk_,
+		(uint64_t)(first_sample_ >> chunk_sample_power_));
+
+	for (; next_spill_chunk_ < full_chunks; next_spill_chunk_++) {
+		// The summary worker may compress or drop the chunk meanwhile
+		shared_ptr<uint8_t> resident;
+		{
+			shared_lock<shared_mutex> lock(mutex_);
+			resident = data_chunks_[next_spill_chunk_ - chunk_offset_];
+		}
+
+		if (!resident || ChunkAllocator::is_spilled(resident))
+			continue;
+
+		// Filled chunks never change, so they may be copied without the
+		// lock. Views onto the chunk keep its memory until they are
+		// released.
+		const uint64_t size = chunk_size(next_spill_chunk_);
+		shared_ptr<uint8_t> chunk = allocator_->allocate_spilled(size);
+		memcpy(chunk.get(), resident.get(), size);
+
+		{
+			unique_lock<shared_mutex> lock(mutex_);
+			shared_ptr<uint8_t> &entry =
+				data_chunks_[next_spill_chunk_ - chunk_offset_];
+			if (entry) {
+				entry.swap(chunk);
+				resident_size_ -= size;
+				spilled_size_ += size;
+			}
+			next_spill_chunk_++;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+void Segment::compress_cold_chunks()
+{
+	uint64_t cold_chunks = summarized_sample_count_ >> chunk_sample_power_;
+
+	{
+		// Segments that do not keep their samples in chunks have none
+		shared_lock<shared_mutex> lock(mutex_);
+		cold_chunks = min(cold_chunks,
+			chunk_offset_ + data_chunks_.size());
+	}
+
+	// The dropped chunks are skipped. This runs on the same thread as
+	// drop_old_chunks(), so no more are dropped meanwhile.
+	next_compressed_chunk_ = max(next_compressed_chunk_,
+		(uint64_t)(first_sample_ >> chunk_sample_power_));
+
+	for (; next_compressed_chunk_ + HotChunkCount < cold_chunks;
+			next_compressed_chunk_++) {
+		shared_ptr<uint8_t> chunk;
+		unsigned int unit_size;
+		{
+			shared_lock<shared_mutex> lock(mutex_);
+			chunk = data_chunks_[next_compressed_chunk_ - chunk_offset_];
+			unit_size = chunk_unit_size(next_compressed_chunk_);
+		}
+
+		// Chunks that do not shrink to less than half their size are
+		// left alone, as decompressing them would not pay off
+		vector<uint8_t> compressed;
+		if (!runcodec::encode(chunk.get(), chunk_samples_, unit_size,
+				compressed, chunk_samples_ * unit_size / 2))
+			continue;
+		compressed.shrink_to_fit();
+
+		unique_lock<shared_mutex> lock(mutex_);
+		const uint64_t entry = next_compressed_chunk_ - chunk_offset_;
+		if (ChunkAllocator::is_spilled(data_chunks_[entry]))
+			spilled_size_ -= chunk_size(next_compressed_chunk_);
+		else
+			resident_size_ -= chunk_size(next_compressed_chunk_);
+		compressed_size_ += compressed.size();
+		compressed_chunks_[entry].swap(compressed);
+		data_chunks_[entry].reset();
+	}
+}
+
+void Segment::drop_old_chunks()
+{
+	const uint64_t retention = retention_;
+	const uint64_t summarized = summarized_sample_count_;
+	if (retention == 0 || summarized <= retention)
+		return;
+
+	uint64_t first_chunk = (summarized - retention) >> chunk_sample_power_;
+	if (first_chunk <= (first_sample_ >> chunk_sample_power_))
+		return;
+
+	{
+		unique_lock<shared_mutex> lock(mutex_);
+
+		// Segments that do not keep their samples in chunks have none
+		first_chunk = min(first_chunk,
+			chunk_offset_ + data_chunks_.size());
+		if (first_chunk <= (first_sample_ >> chunk_sample_power_))
+			return;
+
+		// Views onto the chunks keep their memory until they are
+		// released
+		for (uint64_t c = first_sample_ >> chunk_sample_power_;
+				c < first_chunk; c++) {
+			shared_ptr<uint8_t> &chunk = data_chunks_[c - chunk_offset_];
+			vector<uint8_t> &compressed =
+				compressed_chunks_[c - chunk_offset_];
+
+			if (!chunk) {
+				compressed_size_ -= compressed.size();
+				vector<uint8_t>().swap(compressed);
+			} else if (ChunkAllocator::is_spilled(chunk))
+				spilled_size_ -= chunk_size(c);
+			else
+				resident_size_ -= chunk_size(c);
+
+			chunk.reset();
+		}
+
+		first_sample_ = first_chunk << chunk_sample_power_;
+		drop_summaries(first_sample_);
+	}
+
+	lock_guard<mutex> lock(cache_mutex_);
+	chunk_cache_.remove_if(
+		[&](const pair< uint64_t, shared_ptr<uint8_t> > &entry) {
+			return entry.first < first_chunk; });
+	pinned_chunks_.erase(pinned_chunks_.begin(),
+		pinned_chunks_.lower_bound(first_chunk));
+}
+
+void Segment::summarize(uint64_t end)
+{
+	(void)end;
+}
+
+void Segment::drop_summaries(uint64_t start)
+{
+	(void)start;
+}
+
+unsigned int Segment::chunk_unit_size(uint64_t chunk_num) const
+{
+	(void)chunk_num;
+	return unit_size_;
+}
+
+void Segment::release_chunks(uint64_t chunk_num)
+{
+	assert(chunk_num << chunk_sample_power_ <=
+		(sample_count_ & ~(chunk_samples_ - 1)));
+
+	for (uint64_t c = chunk_offset_ + data_chunks_.size(); c > chunk_num;
+			c--) {
+		// The chunks being filled and beyond are neither compressed nor
+		// cached
+		if (ChunkAllocator::is_spilled(data_chunks_.back()))
+			spilled_size_ -= chunk_size(c - 1);
+		else
+			resident_size_ -= chunk_size(c - 1);
+		data_chunks_.pop_back();
+		compressed_chunks_.pop_back();
+	}
+
+	capacity_ = min(capacity_, chunk_num << chunk_sample_power_);
+}
+
+uint8_t* Segment::raw_sample(uint64_t index) const
+{
+	assert(index < capacity_);
+	assert(index >= first_sample_);
+
+	const shared_ptr<uint8_t> &chunk =
+		data_chunks_[(index >> chunk_sample_power_) - chunk_offset_];
+	assert(chunk);
+	return chunk.get() + (index & (chunk_samples_ - 1)) * unit_size_;
+}
+
+shared_ptr<uint8_t> Segment::chunk_data(uint64_t chunk_num) const
+{
+	assert(chunk_num >= (first_sample_ >> chunk_sample_power_));
+
+	const shared_ptr<uint8_t> &chunk = data_chunks_[chunk_num - chunk_offset_];
+	if (chunk)
+		return chunk;
+
+	lock_guard<mutex> lock(cache_mutex_);
+
+	// Pinned chunks are held decompressed, or from before they were
+	// compressed
+	const auto pinned = pinned_chunks_.find(chunk_num);
+	if (pinned != pinned_chunks_.end()) {
+		const shared_ptr<uint8_t> data = (*pinned).second.lock();
+		if (data)
+			return data;
+	}
+
+	for (auto i = chunk_cache_.begin(); i != chunk_cache_.end(); i++)
+		if ((*i).first == chunk_num) {
+			chunk_cache_.splice(chunk_cache_.begin(), chunk_cache_, i);
+			return (*i).second;
+		}
+
+	const shared_ptr<uint8_t> data(new uint8_t[chunk_size(chunk_num)],
+		default_delete<uint8_t[]>());
+	const vector<uint8_t> &compressed =
+		compressed_chunks_[chunk_num - chunk_offset_];
+	runcodec::decode(compressed.data(), compressed.size(), data.get(),
+		chunk_unit_size(chunk_num));
+
+	chunk_cache_.push_front(make_pair(chunk_num, data));
+	if (chunk_cache_.size() > ChunkCacheSize)
+		chunk_cache_.pop_back();
+
+	return data;
+}
+
+Segment::ChunkCursor::ChunkCursor() :
+	chunk_num(~0ULL),
+	data(nullptr)
+{
+}
+
+const uint8_t* Segment::sample_ptr(uint64_t index, ChunkCursor &cursor) const
+{
+	assert(index >= first_sample_);
+
+	const uint64_t chunk_num = index >> chunk_sample_power_;
+	if (chunk_num != cursor.chunk_num) {
+		cursor.chunk_num = chunk_num;
+		cursor.data = data_chunks_[chunk_num - chunk_offset_].get();
+		cursor.chunk.reset();
+
+		// The chunk is compressed
+		if (!cursor.data) {
+			cursor.chunk = chunk_data(chunk_num);
+			cursor.data = cursor.chunk.get();
+		}
+	}
+
+	return cursor.data + (index & (chunk_samples_ - 1)) * unit_size_;
+}
+
+uint64_t Segment::contiguous_samples(uint64_t index) const
+{
+	return chunk_samples_ - (index & (chunk_samples_ - 1));
+}
+
+void Segment::begin_raw_sample_iteration(SegmentRawDataIterator &it,
+	uint64_t start) const
+{
+	it.sample_index = start;
+	it.chunk_num = start >> chunk_sample_power_;
+
+	if (start < capacity_) {
+		it.value = raw_sample(start);
+		it.chunk_end = it.value + contiguous_samples(start) * unit_size_;
+	} else {
+		it.value = it.chunk_end = nullptr;
+	}
+}
+
+void Segment::continue_raw_sample_iteration(SegmentRawDataIterator &it,
+	uint64_t increase) const
+{
+	const uint64_t offset = increase * unit_size_;
+	if (offset < (uint64_t)(it.chunk_end - it.value)) {
+		it.sample_index += increase;
+		it.value += offset;
+	} else
+		begin_raw_sample_iteration(it, it.sample_index + increase);
 }
 
 } // namespace data
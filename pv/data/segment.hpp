@@ -20,36 +20,178 @@
 #ifndef PULSEVIEW_PV_DATA_SEGMENT_HPP
 #define PULSEVIEW_PV_DATA_SEGMENT_HPP
 
+#include "memoryusage.hpp"
 #include "pv/util.hpp"
 
+#include <atomic>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
 #include <thread>
 #include <mutex>
+#include <utility>
 #include <vector>
 
+#ifdef _WIN32
+// Windows: Avoid boost/thread namespace pollution (which includes windows.h).
+#define NOGDI
+#define NORESOURCE
+#endif
+#include <boost/thread/shared_mutex.hpp>
+
 namespace pv {
 namespace data {
 
+class ChunkAllocator;
+
+/**
+ * A cursor into the chunked raw sample storage of a @c Segment.
+ *
+ * @c value always points to the sample at @c sample_index. All samples
+ * between @c value and @c chunk_end are stored contiguously in memory.
+ */
+struct SegmentRawDataIterator
+{
+	uint64_t sample_index;
+	uint64_t chunk_num;
+	uint8_t *value;
+	uint8_t *chunk_end;
+};
+
+/**
+ * A read-only view onto raw samples that are stored contiguously inside a
+ * @c Segment. No samples are copied; the view refers straight into segment
+ * memory and holds a reference on the chunk it points into, keeping the
+ * samples valid for as long as the view exists.
+ */
+class SegmentDataView
+{
+public:
+	SegmentDataView();
+
+	SegmentDataView(std::shared_ptr<const uint8_t> chunk,
+		const uint8_t *data, uint64_t sample_count,
+		unsigned int unit_size);
+
+	/**
+	 * Returns a pointer to the first sample of the view.
+	 */
+	const uint8_t* data() const;
+
+	/**
+	 * Returns the number of samples in the view.
+	 */
+	uint64_t sample_count() const;
+
+	/**
+	 * Returns the size of the view in bytes.
+	 */
+	uint64_t size() const;
+
+	bool empty() const;
+
+private:
+	std::shared_ptr<const uint8_t> chunk_;
+	const uint8_t *data_;
+	uint64_t sample_count_;
+	unsigned int unit_size_;
+};
+
+/**
+ * Keeps the chunks of a range of samples of a @c Segment decompressed for
+ * as long as it exists. @see Segment::pin_samples()
+ */
+class SegmentPin
+{
+	friend class Segment;
+
+private:
+	std::vector< std::shared_ptr<uint8_t> > chunks_;
+};
+
+/**
+ * The samples of one acquisition.
+ *
+ * Samples are appended by a single writer, and published through the
+ * atomically updated sample count: every sample below
+ * @c get_sample_count() is complete and never changes again. Readers take
+ * @c mutex_ shared, so that any number of them can run in parallel with
+ * each other and with the writer copying samples. It is only taken
+ * exclusively to grow the storage and to extend the summaries.
+ *
+ * Chunks that have been summarized and are no longer near the end of the
+ * segment are compressed by the summary worker if they compress well.
+ * Readers decompress them on demand into a small cache of recently used
+ * chunks. The regions that are being viewed or decoded are pinned with
+ * @c pin_samples(), which keeps them decompressed however many other
+ * chunks are read meanwhile.
+ *
+ * With a retention window set, the oldest chunks and their summaries are
+ * dropped as new samples come in. Sample indices are never renumbered:
+ * the samples before @c get_first_sample() just read as zero.
+ */
 class Segment
 {
+private:
+	static const uint64_t MaxChunkSize;
+
+	/// The number of chunks behind the summaries that are never compressed
+	static const uint64_t HotChunkCount;
+
+	/// The number of decompressed chunks that are kept
+	static const unsigned int ChunkCacheSize;
+
 public:
-	Segment(uint64_t samplerate, unsigned int unit_size);
+	/**
+	 * @param[in] allocator The allocator of the storage chunks, or
+	 * 	nullptr to keep all chunks on the heap.
+	 */
+	Segment(uint64_t samplerate, unsigned int unit_size,
+		std::shared_ptr<ChunkAllocator> allocator =
+			std::shared_ptr<ChunkAllocator>());
 
 	virtual ~Segment();
 
 	uint64_t get_sample_count() const;
 
+	/**
+	 * Returns the index of the oldest sample that is still held. It is
+	 * always the first sample of a chunk.
+	 */
+	uint64_t get_first_sample() const;
+
+	/**
+	 * Returns the number of samples that are kept, or 0 if all of them
+	 * are kept.
+	 */
+	uint64_t retention() const;
+
+	/**
+	 * Keeps only about the last @c samples summarized samples, or all
+	 * of them if @c samples is 0. Whole chunks are dropped once the
+	 * summaries have moved past them, so without copying any samples.
+	 */
+	void set_retention(uint64_t samples);
+
 	const pv::util::Timestamp& start_time() const;
 
 	double samplerate() const;
 	void set_samplerate(double samplerate);
 
+	/**
+	 * Returns the index of the first sample at or after @c time, clamped
+	 * to the samples of the segment.
+	 */
+	uint64_t time_to_sample(const pv::util::Timestamp &time) const;
+
 	unsigned int unit_size() const;
 
 	/**
 	 * @brief Increase the capacity of the segment.
 	 *
 	 * Increasing the capacity allows samples to be appended without needing
-	 * to reallocate memory.
+	 * to allocate memory.
 	 *
 	 * For the best efficiency @c set_capacity() should be called once before
 	 * @c append_data() is called to set up the segment with the expected number
@@ -57,6 +199,8 @@ public:
 	 *
 	 * @note The capacity will automatically be increased when @c append_data()
 	 * is called if there is not enough capacity in the buffer to store the samples.
+	 * Samples are stored in fixed-size chunks which are never moved once
+	 * allocated, so growing the segment never copies existing samples.
 	 *
 	 * @param[in] new_capacity The new capacity of the segment. If this value is
 	 * 	smaller or equal than the current capacity then the method has no effect.
@@ -72,17 +216,220 @@ public:
 	 */
 	uint64_t capacity() const;
 
+	/**
+	 * Copies a range of raw samples into a caller-provided buffer. The
+	 * samples that have been dropped are filled with zeros.
+	 * @param[in] start The index of the first sample to copy.
+	 * @param[in] count The number of samples to copy.
+	 * @param[out] dest The buffer to copy into. Must be able to hold
+	 * 	@c count * @c unit_size() bytes.
+	 */
+	void get_raw_samples(uint64_t start, uint64_t count, uint8_t *dest) const;
+
+	/**
+	 * Returns a zero-copy view onto a range of raw samples.
+	 *
+	 * The view ends at the end of the chunk that contains @c start, so it
+	 * may hold fewer samples than requested. Callers that need the whole
+	 * range continue from @c start + @c sample_count() of the view.
+	 * Samples that have been dropped are returned as zeros.
+	 * @param[in] start The index of the first sample of the view.
+	 * @param[in] count The maximum number of samples in the view.
+	 */
+	SegmentDataView get_raw_samples_view(uint64_t start,
+		uint64_t count) const;
+
+	/**
+	 * Keeps the chunks of the samples from @c start up to but not
+	 * including @c end decompressed until the returned pin is released.
+	 * Ranges that span more chunks than the chunk cache holds are not
+	 * pinned, as they are mostly read from the summaries.
+	 */
+	std::shared_ptr<SegmentPin> pin_samples(uint64_t start,
+		uint64_t end) const;
+
+	/**
+	 * Extends the summaries of the segment, e.g. its mip-map, over at most
+	 * one chunk of the samples that are not summarized yet. The lock is
+	 * only held for one chunk at a time, so that appending samples is
+	 * never held up for long.
+	 * @return false if the summaries were already complete.
+	 */
+	bool update_summaries();
+
+	/**
+	 * Returns the number of samples covered by the summaries. Readers fall
+	 * back to the raw samples beyond this point.
+	 */
+	uint64_t get_summarized_sample_count() const;
+
+	/**
+	 * Returns the memory held by the segment. The samples are accounted
+	 * by whole chunks, as that is how they are allocated.
+	 */
+	virtual MemoryUsage memory_usage() const;
+
 protected:
+	/**
+	 * Appends samples. Only the allocation of new chunks takes the lock
+	 * exclusively; the samples are copied without it, and published by
+	 * updating the sample count.
+	 */
 	void append_data(void *data, uint64_t samples);
 
+	/**
+	 * Extends the summaries of the segment up to sample @c end. Called with
+	 * the lock held exclusively.
+	 */
+	virtual void summarize(uint64_t end);
+
+	/**
+	 * Frees the summaries of the samples before @c start, which have been
+	 * dropped. Called with the lock held exclusively.
+	 */
+	virtual void drop_summaries(uint64_t start);
+
+	/**
+	 * Returns the size of the samples stored in chunk @c chunk_num, which
+	 * is @c unit_size() unless a subclass changes how it stores samples
+	 * part way through. Such subclasses cannot use @c raw_sample(),
+	 * @c sample_ptr() or the raw sample accessors.
+	 */
+	virtual unsigned int chunk_unit_size(uint64_t chunk_num) const;
+
+	/**
+	 * Releases the chunks from @c chunk_num onwards, which must not hold
+	 * any samples but those of the chunk being filled, so that they are
+	 * allocated anew as the segment grows. Called by the writer with the
+	 * lock held exclusively.
+	 */
+	void release_chunks(uint64_t chunk_num);
+
+	/**
+	 * Returns a pointer to the raw sample at @c index. The sample must
+	 * lie within the capacity of the segment, in a chunk that is not
+	 * compressed. Callers other than the writer must hold the lock, as
+	 * growing the segment moves the chunk list.
+	 */
+	uint8_t* raw_sample(uint64_t index) const;
+
+	/**
+	 * Returns the samples of a chunk, decompressing them if the chunk is
+	 * compressed. The chunk must not have been dropped. Must be called
+	 * with the lock held.
+	 */
+	std::shared_ptr<uint8_t> chunk_data(uint64_t chunk_num) const;
+
+	/// The chunk last looked up by sample_ptr()
+	struct ChunkCursor
+	{
+		ChunkCursor();
+
+		uint64_t chunk_num;
+		const uint8_t *data;
+
+		/// Holds the chunk if it was decompressed
+		std::shared_ptr<uint8_t> chunk;
+	};
+
+	/**
+	 * Returns a pointer to the sample at @c index, which must be held.
+	 * The chunk is only looked up if it is not the one in @c cursor, so
+	 * that runs of samples cost one lookup. Must be called with the lock
+	 * held.
+	 */
+	const uint8_t* sample_ptr(uint64_t index, ChunkCursor &cursor) const;
+
+	/**
+	 * Returns the number of samples stored contiguously after and
+	 * including the sample at @c index, i.e. up to the end of its chunk.
+	 */
+	uint64_t contiguous_samples(uint64_t index) const;
+
+	void begin_raw_sample_iteration(SegmentRawDataIterator &it,
+		uint64_t start) const;
+
+	void continue_raw_sample_iteration(SegmentRawDataIterator &it,
+		uint64_t increase) const;
+
+private:
+	/**
+	 * Returns the size of the allocation of chunk @c chunk_num, which
+	 * includes padding for the uint64_t read word.
+	 */
+	uint64_t chunk_size(uint64_t chunk_num) const;
+
+	std::shared_ptr<uint8_t> allocate_chunk(uint64_t chunk_num);
+
+	/**
+	 * Moves the oldest completely filled chunk that is still in memory to
+	 * the scratch file of the allocator.
+	 * @return false if there is no such chunk.
+	 */
+	bool spill_chunk();
+
+	/**
+	 * Compresses the chunks that have fallen behind the summaries by more
+	 * than @c HotChunkCount chunks. Called from the summary worker.
+	 */
+	void compress_cold_chunks();
+
+	/**
+	 * Drops the summarized chunks that fall out of the retention window.
+	 * Called from the summary worker.
+	 */
+	void drop_old_chunks();
+
 protected:
-	mutable std::recursive_mutex mutex_;
-	std::vector<uint8_t> data_;
-	uint64_t sample_count_;
+	/// Taken shared to read the chunk list and the summaries, and
+	/// exclusively to change them
+	mutable boost::shared_mutex mutex_;
+
+	/// The chunks from chunk number chunk_offset_ onwards. The entries of
+	/// the dropped chunks are empty until the writer releases them.
+	std::deque< std::shared_ptr<uint8_t> > data_chunks_;
+	uint64_t chunk_offset_;
+
+	std::atomic<uint64_t> sample_count_;
+	std::atomic<uint64_t> first_sample_;
+	std::atomic<uint64_t> summarized_sample_count_;
 	pv::util::Timestamp start_time_;
 	double samplerate_;
 	uint64_t capacity_;
 	unsigned int unit_size_;
+
+	/// The number of samples per chunk. This is always a power of two so
+	/// that the mip-map and envelope blocks never straddle two chunks.
+	uint64_t chunk_samples_;
+	unsigned int chunk_sample_power_;
+
+private:
+	const std::shared_ptr<ChunkAllocator> allocator_;
+
+	std::atomic<uint64_t> retention_;
+
+	/// The sizes of the chunks in memory and in the scratch file
+	uint64_t resident_size_;
+	uint64_t spilled_size_;
+
+	/// All chunks before this one are spilled to the scratch file
+	uint64_t next_spill_chunk_;
+
+	/// The encoded samples of every compressed chunk, whose entry in
+	/// data_chunks_ is empty. @see runcodec
+	std::deque< std::vector<uint8_t> > compressed_chunks_;
+
+	/// All chunks before this one have been considered for compression
+	uint64_t next_compressed_chunk_;
+	uint64_t compressed_size_;
+
+	/// The recently decompressed chunks, most recently used first
+	mutable std::mutex cache_mutex_;
+	mutable std::list< std::pair< uint64_t, std::shared_ptr<uint8_t> > >
+		chunk_cache_;
+
+	/// The chunks held by pins, by chunk number
+	mutable std::map< uint64_t, std::weak_ptr<uint8_t> > pinned_chunks_;
 };
 
 } // namespace data
@@ -76,7 +76,9 @@ public:
 	const sigrok::ChannelType *type() const;
 
 	/**
-	 * Gets the index number of this channel.
+	 * Gets the index number of this channel. The bit of a logic channel
+	 * in the samples of a segment may differ from it.
+	 * @see data::LogicSegment::channel_bit()
 	 */
 	unsigned int index() const;
 
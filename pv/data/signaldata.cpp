@@ -17,10 +17,21 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "segment.hpp"
 #include "signaldata.hpp"
 
+using std::shared_ptr;
+
 namespace pv {
 namespace data {
 
+MemoryUsage SignalData::memory_usage() const
+{
+	MemoryUsage usage;
+	for (const shared_ptr<Segment> &s : segments())
+		usage += s->memory_usage();
+	return usage;
+}
+
 } // namespace data
 } // namespace pv
@@ -24,6 +24,8 @@
 #include <memory>
 #include <vector>
 
+#include "memoryusage.hpp"
+
 namespace pv {
 namespace data {
 
@@ -36,11 +38,30 @@ public:
 	virtual ~SignalData() {}
 
 public:
+	/**
+	 * Returns the segments of all frames that are held, oldest first.
+	 */
 	virtual std::vector< std::shared_ptr<Segment> > segments() const = 0;
 
+	/**
+	 * Returns the segment of a frame, or nullptr if the frame has been
+	 * evicted or holds no samples of this signal.
+	 */
+	virtual std::shared_ptr<Segment> frame_segment(uint64_t frame) const = 0;
+
+	/**
+	 * Frees the segments of the frames before @c frame.
+	 */
+	virtual void drop_frames_before(uint64_t frame) = 0;
+
 	virtual void clear() = 0;
 
 	virtual uint64_t max_sample_count() const = 0;
+
+	/**
+	 * Returns the memory held by all segments.
+	 */
+	MemoryUsage memory_usage() const;
 };
 
 } // namespace data
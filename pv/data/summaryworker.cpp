@@ -0,0 +1,101 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+
+#include <algorithm>
+
+#include "segment.hpp"
+#include "summaryworker.hpp"
+
+using std::find;
+using std::function;
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::unique_lock;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+SummaryWorker::SummaryWorker(function<void ()> updated) :
+	updated_(updated),
+	interrupt_(false)
+{
+	summary_thread_ = std::thread(&SummaryWorker::summary_proc, this);
+}
+
+SummaryWorker::~SummaryWorker()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		interrupt_ = true;
+	}
+	cond_.notify_one();
+	summary_thread_.join();
+}
+
+void SummaryWorker::update(shared_ptr<Segment> segment)
+{
+	assert(segment);
+
+	{
+		lock_guard<mutex> lock(mutex_);
+		if (find(pending_.begin(), pending_.end(), segment) ==
+			pending_.end())
+			pending_.push_back(segment);
+	}
+	cond_.notify_one();
+}
+
+void SummaryWorker::summary_proc()
+{
+	vector< shared_ptr<Segment> > segments;
+
+	while (true) {
+		{
+			unique_lock<mutex> lock(mutex_);
+			while (!interrupt_ && pending_.empty())
+				cond_.wait(lock);
+
+			if (interrupt_)
+				return;
+
+			segments.swap(pending_);
+		}
+
+		// Summarize the segments a chunk at a time in turn, so that
+		// none of them lags far behind the others
+		bool progress = true;
+		while (progress && !interrupt_) {
+			progress = false;
+			for (const shared_ptr<Segment> &s : segments)
+				progress |= s->update_summaries();
+		}
+
+		segments.clear();
+
+		if (!interrupt_ && updated_)
+			updated_();
+	}
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_SUMMARYWORKER_HPP
+#define PULSEVIEW_PV_DATA_SUMMARYWORKER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pv {
+namespace data {
+
+class Segment;
+
+/**
+ * Builds the summaries of segments, i.e. their mip-maps and envelopes, on a
+ * thread of its own. The data feed only stores the raw samples and hands
+ * the segment over, and readers fall back to the raw samples wherever the
+ * summaries lag behind.
+ */
+class SummaryWorker
+{
+public:
+	/**
+	 * @param[in] updated Called from the worker thread whenever it has
+	 * 	caught up with the segments that were handed to it.
+	 */
+	SummaryWorker(std::function<void ()> updated);
+
+	~SummaryWorker();
+
+	/**
+	 * Schedules the summaries of a segment to be brought up to date with
+	 * its samples.
+	 */
+	void update(std::shared_ptr<Segment> segment);
+
+private:
+	void summary_proc();
+
+private:
+	const std::function<void ()> updated_;
+
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	std::vector< std::shared_ptr<Segment> > pending_;
+
+	std::atomic<bool> interrupt_;
+	std::thread summary_thread_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_SUMMARYWORKER_HPP
@@ -37,10 +37,10 @@ StoreProgress::StoreProgress(const QString &file_name,
 	const std::shared_ptr<sigrok::OutputFormat> output_format,
 	const map<string, VariantBase> &options,
 	const std::pair<uint64_t, uint64_t> sample_range,
-	const Session &session, QWidget *parent) :
+	uint64_t frame, const Session &session, QWidget *parent) :
 	QProgressDialog(tr("Saving..."), tr("Cancel"), 0, 0, parent),
 	session_(file_name.toStdString(), output_format, options, sample_range,
-		session)
+		frame, session)
 {
 	connect(&session_, SIGNAL(progress_updated()),
 		this, SLOT(on_progress_updated()));
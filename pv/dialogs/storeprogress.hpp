@@ -42,7 +42,7 @@ public:
 		const std::shared_ptr<sigrok::OutputFormat> output_format,
 		const std::map<std::string, Glib::VariantBase> &options,
 		const std::pair<uint64_t, uint64_t> sample_range,
-		const Session &session,
+		uint64_t frame, const Session &session,
 		QWidget *parent = 0);
 
 	virtual ~StoreProgress();
@@ -43,6 +43,7 @@
 #include "dialogs/about.hpp"
 #include "toolbars/mainbar.hpp"
 #include "view/view.hpp"
+#include "views/trace/measurementspanel.hpp"
 #include "views/trace/standardbar.hpp"
 
 #include <stdint.h>
@@ -184,6 +185,21 @@ shared_ptr<views::ViewBase> MainWindow::add_view(const QString &title,
 		dock_main->setCentralWidget(v.get());
 		dock->setWidget(dock_main);
 
+		// The measurements panel is docked below the traces, hidden
+		QDockWidget *measurements_dock =
+			new QDockWidget(tr("Measurements"), dock_main);
+		measurements_dock->setObjectName(title + " measurements");
+		measurements_dock->setWidget(new views::trace::MeasurementsPanel(
+			session, v.get(), measurements_dock));
+		dock_main->addDockWidget(Qt::BottomDockWidgetArea,
+			measurements_dock);
+		measurements_dock->hide();
+
+		QAction *const action_view_show_measurements =
+			measurements_dock->toggleViewAction();
+		action_view_show_measurements->setText(tr("Show &Measurements"));
+		action_view_show_measurements->setShortcut(QKeySequence(Qt::Key_M));
+
 		dock->setFeatures(QDockWidget::DockWidgetMovable |
 			QDockWidget::DockWidgetFloatable | QDockWidget::DockWidgetClosable);
 
@@ -213,6 +229,7 @@ shared_ptr<views::ViewBase> MainWindow::add_view(const QString &title,
 					this, SLOT(on_new_view(Session*)));
 
 				main_bar->action_view_show_cursors()->setChecked(v->cursors_shown());
+				main_bar->addAction(action_view_show_measurements);
 
 				/* For the main view we need to prevent the dock widget from
 				 * closing itself when its close button is clicked. This is
@@ -226,6 +243,7 @@ shared_ptr<views::ViewBase> MainWindow::add_view(const QString &title,
 				dock_main->addToolBar(standard_bar);
 
 				standard_bar->action_view_show_cursors()->setChecked(v->cursors_shown());
+				standard_bar->addAction(action_view_show_measurements);
 			}
 		}
 
@@ -0,0 +1,134 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "captureoptions.hpp"
+
+#include <QFileDialog>
+
+#include <pv/session.hpp>
+
+namespace pv {
+namespace popups {
+
+CaptureOptions::CaptureOptions(Session &session, QWidget *parent) :
+	Popup(parent),
+	session_(session),
+	layout_(this),
+	spill_directory_layout_(&spill_directory_row_),
+	spill_directory_browse_(tr("Browse..."))
+{
+	setLayout(&layout_);
+
+	sparse_logic_storage_.setToolTip(tr("Store only the logic samples "
+		"that differ from the one before. Saves memory when the "
+		"signals change rarely."));
+	connect(&sparse_logic_storage_, SIGNAL(toggled(bool)),
+		this, SLOT(on_sparse_logic_storage_toggled(bool)));
+	layout_.addRow(tr("Sparse logic storage"), &sparse_logic_storage_);
+
+	logic_edge_counts_.setToolTip(tr("Keep the number of edges of every "
+		"logic channel, so that the activity of long captures is shown "
+		"quickly. Uses some more memory."));
+	connect(&logic_edge_counts_, SIGNAL(toggled(bool)),
+		this, SLOT(on_logic_edge_counts_toggled(bool)));
+	layout_.addRow(tr("Count edges"), &logic_edge_counts_);
+
+#ifdef ENABLE_DECODE_WORKERS
+	decode_worker_processes_.setToolTip(tr("Run every decoder stack in a "
+		"process of its own, so that several stacks decode in "
+		"parallel."));
+	connect(&decode_worker_processes_, SIGNAL(toggled(bool)),
+		this, SLOT(on_decode_worker_processes_toggled(bool)));
+	layout_.addRow(tr("Decode in parallel"), &decode_worker_processes_);
+#endif
+
+	// The budget is set in MiB, the size of a storage chunk
+	ram_budget_.setRange(0, 1024 * 1024);
+	ram_budget_.setSingleStep(256);
+	ram_budget_.setSuffix(tr(" MiB"));
+	ram_budget_.setSpecialValueText(tr("Unlimited"));
+	ram_budget_.setToolTip(tr("Samples beyond this amount of memory are "
+		"moved to a scratch file in the spill directory."));
+	connect(&ram_budget_, SIGNAL(valueChanged(int)),
+		this, SLOT(on_ram_budget_changed(int)));
+	layout_.addRow(tr("RAM budget"), &ram_budget_);
+
+	spill_directory_layout_.setContentsMargins(0, 0, 0, 0);
+	spill_directory_layout_.addWidget(&spill_directory_);
+	spill_directory_layout_.addWidget(&spill_directory_browse_);
+	connect(&spill_directory_, SIGNAL(editingFinished()),
+		this, SLOT(on_spill_directory_edited()));
+	connect(&spill_directory_browse_, SIGNAL(clicked()),
+		this, SLOT(on_spill_directory_browse()));
+	layout_.addRow(tr("Spill directory"), &spill_directory_row_);
+}
+
+void CaptureOptions::showEvent(QShowEvent *event)
+{
+	pv::widgets::Popup::showEvent(event);
+
+	sparse_logic_storage_.setChecked(session_.sparse_logic_storage());
+	logic_edge_counts_.setChecked(session_.logic_edge_counts());
+#ifdef ENABLE_DECODE_WORKERS
+	decode_worker_processes_.setChecked(
+		session_.decode_worker_processes());
+#endif
+	ram_budget_.setValue(session_.ram_budget() >> 20);
+	spill_directory_.setText(session_.spill_directory());
+}
+
+void CaptureOptions::on_sparse_logic_storage_toggled(bool checked)
+{
+	session_.set_sparse_logic_storage(checked);
+}
+
+void CaptureOptions::on_logic_edge_counts_toggled(bool checked)
+{
+	session_.set_logic_edge_counts(checked);
+}
+
+void CaptureOptions::on_decode_worker_processes_toggled(bool checked)
+{
+	session_.set_decode_worker_processes(checked);
+}
+
+void CaptureOptions::on_ram_budget_changed(int mebibytes)
+{
+	session_.set_ram_budget((uint64_t)mebibytes << 20);
+}
+
+void CaptureOptions::on_spill_directory_edited()
+{
+	if (!spill_directory_.text().isEmpty())
+		session_.set_spill_directory(spill_directory_.text());
+}
+
+void CaptureOptions::on_spill_directory_browse()
+{
+	const QString directory = QFileDialog::getExistingDirectory(this,
+		tr("Spill Directory"), session_.spill_directory());
+	if (directory.isEmpty())
+		return;
+
+	spill_directory_.setText(directory);
+	session_.set_spill_directory(directory);
+}
+
+} // namespace popups
+} // namespace pv
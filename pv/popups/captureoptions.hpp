@@ -0,0 +1,89 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_POPUPS_CAPTUREOPTIONS_HPP
+#define PULSEVIEW_PV_POPUPS_CAPTUREOPTIONS_HPP
+
+#include <QCheckBox>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+
+#include <pv/widgets/popup.hpp>
+
+namespace pv {
+
+class Session;
+
+namespace popups {
+
+/**
+ * The options of the session for storing and processing the captured
+ * data, which take effect with the next capture.
+ */
+class CaptureOptions : public pv::widgets::Popup
+{
+	Q_OBJECT
+
+public:
+	CaptureOptions(Session &session, QWidget *parent);
+
+private:
+	void showEvent(QShowEvent *event);
+
+private Q_SLOTS:
+	void on_sparse_logic_storage_toggled(bool checked);
+
+	void on_logic_edge_counts_toggled(bool checked);
+
+	void on_decode_worker_processes_toggled(bool checked);
+
+	void on_ram_budget_changed(int mebibytes);
+
+	void on_spill_directory_edited();
+
+	void on_spill_directory_browse();
+
+private:
+	pv::Session &session_;
+
+	QFormLayout layout_;
+
+	QCheckBox sparse_logic_storage_;
+
+	QCheckBox logic_edge_counts_;
+
+#ifdef ENABLE_DECODE_WORKERS
+	QCheckBox decode_worker_processes_;
+#endif
+
+	QSpinBox ram_budget_;
+
+	QWidget spill_directory_row_;
+	QHBoxLayout spill_directory_layout_;
+	QLineEdit spill_directory_;
+	QPushButton spill_directory_browse_;
+};
+
+} // namespace popups
+} // namespace pv
+
+#endif // PULSEVIEW_PV_POPUPS_CAPTUREOPTIONS_HPP
@@ -27,6 +27,7 @@
 
 #include <QFileInfo>
 
+#include <algorithm>
 #include <cassert>
 #include <mutex>
 #include <stdexcept>
@@ -38,9 +39,12 @@
 
 #include "data/analog.hpp"
 #include "data/analogsegment.hpp"
+#include "data/channelpacker.hpp"
+#include "data/chunkallocator.hpp"
 #include "data/decoderstack.hpp"
 #include "data/logic.hpp"
 #include "data/logicsegment.hpp"
+#include "data/memoryusage.hpp"
 #include "data/signalbase.hpp"
 #include "data/decode/decoder.hpp"
 
@@ -71,16 +75,20 @@ using std::function;
 using std::lock_guard;
 using std::list;
 using std::map;
+using std::max;
+using std::min;
 using std::mutex;
 using std::pair;
 using std::recursive_mutex;
 using std::set;
 using std::shared_ptr;
+using std::sort;
 using std::string;
 using std::unordered_set;
 using std::vector;
 
 using sigrok::Analog;
+using sigrok::Capability;
 using sigrok::Channel;
 using sigrok::ChannelType;
 using sigrok::ConfigKey;
@@ -100,13 +108,32 @@ using Glib::VariantBase;
 using Glib::Variant;
 
 namespace pv {
+const double Session::RollMemoryShare = 0.75;
+const double Session::DefaultRollWindow = 10.0;
+const double Session::MemoryRecheckShare = 1.0 / 16;
+
 Session::Session(DeviceManager &device_manager, QString name) :
 	device_manager_(device_manager),
 	default_name_(name),
 	name_(name),
 	capture_state_(Stopped),
 	cur_samplerate_(0),
-	data_saved_(true)
+	chunk_allocator_(std::make_shared<data::ChunkAllocator>()),
+	sparse_logic_storage_(false),
+	logic_edge_counts_(false),
+	compact_analog_storage_(false),
+	decode_worker_processes_(false),
+	memory_limit_(0),
+	memory_limit_reached_(false),
+	measured_memory_usage_(0),
+	unmeasured_bytes_(0),
+	memory_recheck_level_(0),
+	roll_mode_(false),
+	roll_window_(DefaultRollWindow),
+	first_frame_(0),
+	frame_count_(0),
+	data_saved_(true),
+	summary_worker_([this]() { summaries_updated(); })
 {
 }
 
@@ -184,6 +211,19 @@ void Session::save_settings(QSettings &settings) const
 	list<string> key_list;
 	int stacks = 0, views = 0;
 
+	settings.setValue("sparse_logic_storage", sparse_logic_storage_);
+	settings.setValue("logic_edge_counts", logic_edge_counts_);
+	settings.setValue("compact_analog_storage", compact_analog_storage_);
+	settings.setValue("decode_worker_processes",
+		(bool)decode_worker_processes_);
+	settings.setValue("ram_budget",
+		(qulonglong)chunk_allocator_->ram_budget());
+	settings.setValue("spill_directory",
+		chunk_allocator_->spill_directory());
+	settings.setValue("memory_limit", (qulonglong)memory_limit_);
+	settings.setValue("roll_mode", roll_mode_);
+	settings.setValue("roll_window", roll_window_);
+
 	if (device_) {
 		shared_ptr<devices::HardwareDevice> hw_device =
 			dynamic_pointer_cast< devices::HardwareDevice >(device_);
@@ -268,6 +308,27 @@ void Session::restore_settings(QSettings &settings)
 {
 	shared_ptr<devices::Device> device;
 
+	sparse_logic_storage_ =
+		settings.value("sparse_logic_storage", false).toBool();
+	logic_edge_counts_ =
+		settings.value("logic_edge_counts", false).toBool();
+	compact_analog_storage_ =
+		settings.value("compact_analog_storage", false).toBool();
+	decode_worker_processes_ =
+		settings.value("decode_worker_processes", false).toBool();
+	chunk_allocator_->set_ram_budget(
+		settings.value("ram_budget", 0).toULongLong());
+	if (!settings.value("spill_directory").toString().isEmpty())
+		chunk_allocator_->set_spill_directory(
+			settings.value("spill_directory").toString());
+	memory_limit_ = settings.value("memory_limit", 0).toULongLong();
+	roll_mode_ = settings.value("roll_mode", false).toBool();
+	roll_window_ = settings.value("roll_window",
+		DefaultRollWindow).toDouble();
+
+	if (main_bar_)
+		main_bar_->update_capture_settings();
+
 	QString device_type = settings.value("device_type").toString();
 
 	if (device_type == "hardware") {
@@ -399,6 +460,7 @@ void Session::set_device(shared_ptr<devices::Device> device)
 	all_signal_data_.clear();
 	signalbases_.clear();
 	cur_logic_segment_.reset();
+	first_frame_ = frame_count_ = 0;
 
 	for (auto entry : cur_analog_segments_) {
 		shared_ptr<sigrok::Channel>(entry.first).reset();
@@ -531,6 +593,8 @@ void Session::start_capture(function<void (const QString)> error_handler)
 	// Clear signal data
 	for (const shared_ptr<data::SignalData> d : all_signal_data_)
 		d->clear();
+	first_frame_ = frame_count_ = 0;
+	frames_changed();
 
 	// Revert name back to default name (e.g. "Untitled-1") as the data is gone
 	name_ = default_name_;
@@ -602,6 +666,137 @@ double Session::get_samplerate() const
 	return samplerate;
 }
 
+bool Session::sparse_logic_storage() const
+{
+	return sparse_logic_storage_;
+}
+
+void Session::set_sparse_logic_storage(bool sparse)
+{
+	// Takes effect with the next logic segment
+	lock_guard<recursive_mutex> lock(data_mutex_);
+	sparse_logic_storage_ = sparse;
+}
+
+bool Session::logic_edge_counts() const
+{
+	return logic_edge_counts_;
+}
+
+void Session::set_logic_edge_counts(bool edge_counts)
+{
+	// Takes effect with the next logic segment
+	lock_guard<recursive_mutex> lock(data_mutex_);
+	logic_edge_counts_ = edge_counts;
+}
+
+bool Session::compact_analog_storage() const
+{
+	return compact_analog_storage_;
+}
+
+void Session::set_compact_analog_storage(bool compact)
+{
+	// Takes effect with the next analog segments
+	lock_guard<recursive_mutex> lock(data_mutex_);
+	compact_analog_storage_ = compact;
+}
+
+bool Session::decode_worker_processes() const
+{
+	return decode_worker_processes_;
+}
+
+void Session::set_decode_worker_processes(bool enable)
+{
+	// Takes effect with the next decode
+	decode_worker_processes_ = enable;
+}
+
+uint64_t Session::ram_budget() const
+{
+	return chunk_allocator_->ram_budget();
+}
+
+void Session::set_ram_budget(uint64_t ram_budget)
+{
+	chunk_allocator_->set_ram_budget(ram_budget);
+}
+
+QString Session::spill_directory() const
+{
+	return chunk_allocator_->spill_directory();
+}
+
+void Session::set_spill_directory(const QString &spill_directory)
+{
+	chunk_allocator_->set_spill_directory(spill_directory);
+}
+
+data::MemoryUsage Session::memory_usage() const
+{
+	// The samples taken in while measuring are counted again next time
+	const uint64_t unmeasured_bytes = unmeasured_bytes_;
+
+	data::MemoryUsage usage;
+
+	for (const shared_ptr<data::SignalData> d : all_signal_data_) {
+		assert(d);
+		usage += d->memory_usage();
+	}
+
+#ifdef ENABLE_DECODE
+	for (const shared_ptr<data::SignalBase> base : signalbases_)
+		if (base->is_decode_signal())
+			usage += base->decoder_stack()->memory_usage();
+#endif
+
+	measured_memory_usage_ = usage.total();
+	unmeasured_bytes_ -= unmeasured_bytes;
+
+	return usage;
+}
+
+uint64_t Session::memory_limit() const
+{
+	return memory_limit_;
+}
+
+void Session::set_memory_limit(uint64_t memory_limit)
+{
+	memory_limit_ = memory_limit;
+}
+
+bool Session::roll_mode() const
+{
+	return roll_mode_;
+}
+
+void Session::set_roll_mode(bool roll_mode)
+{
+	roll_mode_ = roll_mode;
+}
+
+double Session::roll_window() const
+{
+	return roll_window_;
+}
+
+void Session::set_roll_window(double roll_window)
+{
+	roll_window_ = max(roll_window, 0.0);
+}
+
+uint64_t Session::first_frame() const
+{
+	return first_frame_;
+}
+
+uint64_t Session::frame_count() const
+{
+	return frame_count_;
+}
+
 const std::unordered_set< std::shared_ptr<data::SignalBase> >
 	Session::signalbases() const
 {
@@ -837,10 +1032,42 @@ void Session::sample_thread_proc(function<void (const QString)> error_handler)
 	cur_samplerate_ = device_->read_config<uint64_t>(ConfigKey::SAMPLERATE);
 
 	out_of_memory_ = false;
+	memory_limit_reached_ = false;
+	memory_recheck_level_ = 0;
+
+	// Roll mode captures until it is stopped, so the sample limit of the
+	// device is lifted for the capture and restored afterwards
+	const shared_ptr<sigrok::Device> sr_dev = device_->device();
+	VariantBase sample_limit;
+	if (roll_mode_ && sr_dev &&
+		sr_dev->config_check(ConfigKey::LIMIT_SAMPLES, Capability::SET)) {
+		try {
+			if (sr_dev->config_check(ConfigKey::LIMIT_SAMPLES,
+					Capability::GET))
+				sample_limit = sr_dev->config_get(
+					ConfigKey::LIMIT_SAMPLES);
+			sr_dev->config_set(ConfigKey::LIMIT_SAMPLES,
+				Variant<guint64>::create(0));
+		} catch (Error e) {
+			qDebug("Failed to lift the sample limit for roll mode.");
+		}
+	}
+
+	const auto restore_sample_limit = [&]() {
+		if (!sample_limit.gobj())
+			return;
+		try {
+			sr_dev->config_set(ConfigKey::LIMIT_SAMPLES,
+				sample_limit);
+		} catch (Error e) {
+			qDebug("Failed to restore the sample limit.");
+		}
+	};
 
 	try {
 		device_->start();
 	} catch (Error e) {
+		restore_sample_limit();
 		error_handler(e.what());
 		return;
 	}
@@ -850,6 +1077,7 @@ void Session::sample_thread_proc(function<void (const QString)> error_handler)
 
 	device_->run();
 	set_capture_state(Stopped);
+	restore_sample_limit();
 
 	// Confirm that SR_DF_END was received
 	if (cur_logic_segment_) {
@@ -866,6 +1094,8 @@ void Session::sample_thread_proc(function<void (const QString)> error_handler)
 
 	if (out_of_memory_)
 		error_handler(tr("Out of memory, acquisition stopped."));
+	else if (memory_limit_reached_)
+		error_handler(tr("Memory limit reached, acquisition stopped."));
 }
 
 void Session::feed_in_header()
@@ -900,18 +1130,19 @@ void Session::feed_in_trigger()
 	uint64_t sample_count = 0;
 
 	{
-		for (const shared_ptr<pv::data::SignalData> d : all_signal_data_) {
-			assert(d);
-			uint64_t temp_count = 0;
-
-			const vector< shared_ptr<pv::data::Segment> > segments =
-				d->segments();
-			for (const shared_ptr<pv::data::Segment> &s : segments)
-				temp_count += s->get_sample_count();
-
-			if (temp_count > sample_count)
-				sample_count = temp_count;
-		}
+		lock_guard<recursive_mutex> lock(data_mutex_);
+
+		// A trigger before the first samples of a frame is at its start
+		if (cur_logic_segment_ || !cur_analog_segments_.empty())
+			for (const shared_ptr<pv::data::SignalData> d :
+					all_signal_data_) {
+				assert(d);
+				const shared_ptr<pv::data::Segment> segment =
+					d->frame_segment(frame_count_ - 1);
+				if (segment)
+					sample_count = max(sample_count,
+						segment->get_sample_count());
+			}
 	}
 
 	trigger_event(sample_count / get_samplerate());
@@ -919,8 +1150,78 @@ void Session::feed_in_trigger()
 
 void Session::feed_in_frame_begin()
 {
-	if (cur_logic_segment_ || !cur_analog_segments_.empty())
-		frame_began();
+	// Each frame of the device is kept in segments of its own
+	close_frame();
+}
+
+uint64_t Session::open_frame()
+{
+	lock_guard<recursive_mutex> lock(data_mutex_);
+
+	// The first segment of a frame begins it
+	if (!cur_logic_segment_ && cur_analog_segments_.empty()) {
+		frame_count_++;
+		frames_changed();
+	}
+
+	return frame_count_ - 1;
+}
+
+void Session::close_frame()
+{
+	lock_guard<recursive_mutex> lock(data_mutex_);
+	cur_logic_segment_.reset();
+	cur_analog_segments_.clear();
+}
+
+bool Session::evict_oldest_frame()
+{
+	lock_guard<recursive_mutex> lock(data_mutex_);
+
+	if (first_frame_ + 1 >= frame_count_)
+		return false;
+
+	first_frame_++;
+	for (const shared_ptr<data::SignalData> d : all_signal_data_)
+		d->drop_frames_before(first_frame_);
+
+	frames_changed();
+
+	return true;
+}
+
+shared_ptr<const data::ChannelPacker> Session::repack_logic_channels(
+	unsigned int unit_size)
+{
+	// Keep the channels that are shown or decoded
+	set< shared_ptr<data::SignalBase> > used;
+	for (const shared_ptr<data::SignalBase> base : signalbases_) {
+		if (base->type() == ChannelType::LOGIC && base->enabled())
+			used.insert(base);
+
+#ifdef ENABLE_DECODE
+		if (base->is_decode_signal())
+			for (const shared_ptr<data::decode::Decoder> &dec :
+					base->decoder_stack()->stack())
+				for (const auto &channel : dec->channels())
+					used.insert(channel.second);
+#endif
+	}
+
+	vector<unsigned int> channels;
+	for (const shared_ptr<data::SignalBase> &base : used)
+		if (base->channel()->index() < unit_size * 8)
+			channels.push_back(base->channel()->index());
+	sort(channels.begin(), channels.end());
+
+	// The readers find the bits of the channels through the segment
+	shared_ptr<const data::ChannelPacker> packer;
+	if (unit_size <= data::ChannelPacker::MaxSourceUnitSize &&
+			!channels.empty() && (channels.size() + 7) / 8 < unit_size)
+		packer = shared_ptr<const data::ChannelPacker>(
+			new data::ChannelPacker(channels, unit_size));
+
+	return packer;
 }
 
 void Session::feed_in_logic(shared_ptr<Logic> logic)
@@ -941,10 +1242,18 @@ void Session::feed_in_logic(shared_ptr<Logic> logic)
 		set_capture_state(Running);
 
 		// Create a new data segment
+		const uint64_t frame = open_frame();
 		cur_logic_segment_ = shared_ptr<data::LogicSegment>(
 			new data::LogicSegment(
-				logic, cur_samplerate_, sample_count));
-		logic_data_->push_segment(cur_logic_segment_);
+				logic, cur_samplerate_, sample_count,
+				(sparse_logic_storage_ && !roll_mode_) ?
+					data::LogicSegment::TransitionStorage :
+					data::LogicSegment::RawStorage,
+				chunk_allocator_,
+				repack_logic_channels(logic->unit_size()),
+				logic_edge_counts_));
+		cur_logic_segment_->set_retention(roll_retention());
+		logic_data_->push_segment(cur_logic_segment_, frame);
 
 		// @todo Putting this here means that only listeners querying
 		// for logic will be notified. Currently the only user of
@@ -956,6 +1265,8 @@ void Session::feed_in_logic(shared_ptr<Logic> logic)
 		cur_logic_segment_->append_payload(logic);
 	}
 
+	summary_worker_.update(cur_logic_segment_);
+
 	data_received();
 }
 
@@ -972,7 +1283,11 @@ void Session::feed_in_analog(shared_ptr<Analog> analog)
 	if (signalbases_.empty())
 		update_signals();
 
-	for (auto channel : channels) {
+	vector< shared_ptr<data::AnalogSegment> > segments;
+	segments.reserve(channel_count);
+
+	for (unsigned int i = 0; i < channel_count; i++) {
+		const shared_ptr<Channel> &channel = channels[i];
 		shared_ptr<data::AnalogSegment> segment;
 
 		// Try to get the segment of the channel
@@ -986,10 +1301,24 @@ void Session::feed_in_analog(shared_ptr<Analog> analog)
 			// in the sweep containing this segment.
 			sweep_beginning = true;
 
+			// Compact storage keeps the codes of an ADC if the
+			// first packet reveals them, and floats otherwise
+			data::AnalogSegment::SampleFormat format =
+				data::AnalogSegment::FloatFormat;
+			float scale = 1.0f, offset = 0.0f;
+			if (compact_analog_storage_ &&
+				data::AnalogSegment::find_int16_scale(
+					data + i, sample_count, channel_count,
+					scale, offset))
+				format = data::AnalogSegment::Int16Format;
+
 			// Create a segment, keep it in the maps of channels
+			const uint64_t frame = open_frame();
 			segment = shared_ptr<data::AnalogSegment>(
 				new data::AnalogSegment(
-					cur_samplerate_, sample_count));
+					cur_samplerate_, sample_count,
+					chunk_allocator_, format, scale, offset));
+			segment->set_retention(roll_retention());
 			cur_analog_segments_[channel] = segment;
 
 			// Find the analog data associated with the channel
@@ -1000,16 +1329,26 @@ void Session::feed_in_analog(shared_ptr<Analog> analog)
 			assert(data);
 
 			// Push the segment into the analog data.
-			data->push_segment(segment);
+			data->push_segment(segment, frame);
 		}
 
 		assert(segment);
 
-		// Append the samples in the segment
-		segment->append_interleaved_samples(data++, sample_count,
-			channel_count);
+		// Store the samples as floats from now on if they no longer
+		// fit the compact format
+		if (!segment->fits_format(data + i, sample_count, channel_count))
+			segment->store_as_floats();
+
+		segments.push_back(segment);
 	}
 
+	// Append the samples to all segments in one pass over the packet
+	data::AnalogSegment::append_interleaved_samples(segments, data,
+		sample_count);
+
+	for (const shared_ptr<data::AnalogSegment> &segment : segments)
+		summary_worker_.update(segment);
+
 	if (sweep_beginning) {
 		// This could be the first packet after a trigger
 		set_capture_state(Running);
@@ -1018,6 +1357,102 @@ void Session::feed_in_analog(shared_ptr<Analog> analog)
 	data_received();
 }
 
+bool Session::memory_limit_reached(uint64_t size)
+{
+	if (memory_limit_reached_)
+		return true;
+
+	const uint64_t limit = memory_limit_;
+	if (limit == 0)
+		return false;
+
+	unmeasured_bytes_ += size;
+	if (measured_memory_usage_ + unmeasured_bytes_ <=
+		max(limit, memory_recheck_level_))
+		return false;
+
+	// Make room by evicting the oldest frames, keeping the newest one
+	while (true) {
+		const uint64_t usage = memory_usage().total() + unmeasured_bytes_;
+		if (usage <= limit) {
+			memory_recheck_level_ = 0;
+			return false;
+		}
+
+		if (evict_oldest_frame())
+			continue;
+
+		// In roll mode the retention of the segments bounds the
+		// newest frame. Its summaries may keep the usage above the
+		// limit, so it is only measured again once another share of
+		// the limit has been taken in.
+		if (roll_mode_) {
+			memory_recheck_level_ = usage + limit * MemoryRecheckShare;
+			return false;
+		}
+
+		// Stop before the allocator fails, keeping the samples so far
+		memory_limit_reached_ = true;
+		device_->stop();
+		return true;
+	}
+
+	return false;
+}
+
+uint64_t Session::analog_packet_size(shared_ptr<Analog> analog) const
+{
+	lock_guard<recursive_mutex> lock(data_mutex_);
+
+	// The channels without a segment yet are counted as floats, the
+	// largest format they may get
+	uint64_t size = 0;
+	for (const shared_ptr<Channel> &channel : analog->channels()) {
+		const auto iter = cur_analog_segments_.find(channel);
+		size += (iter != cur_analog_segments_.end() &&
+			(*iter).second->format() !=
+				data::AnalogSegment::FloatFormat) ?
+			(*iter).second->unit_size() : sizeof(float);
+	}
+
+	return analog->num_samples() * size;
+}
+
+uint64_t Session::roll_retention() const
+{
+	if (!roll_mode_)
+		return 0;
+
+	const uint64_t limit = memory_limit_;
+	const double window = (roll_window_ > 0 || limit != 0) ?
+		roll_window_ : DefaultRollWindow;
+
+	uint64_t retention = 0;
+	if (window > 0)
+		retention = max<uint64_t>(window * cur_samplerate_, 1);
+
+	if (limit == 0)
+		return retention;
+
+	// Share the memory limit among the enabled channels
+	unsigned int logic_channels = 0, analog_channels = 0;
+	for (const shared_ptr<data::SignalBase> &base : signalbases_) {
+		if (!base->enabled())
+			continue;
+		if (base->type() == ChannelType::LOGIC)
+			logic_channels++;
+		else
+			analog_channels++;
+	}
+
+	const uint64_t sample_size = max<uint64_t>(
+		(logic_channels + 7) / 8 + analog_channels * sizeof(float), 1);
+	const uint64_t limit_retention =
+		max<uint64_t>(limit * RollMemoryShare / sample_size, 1);
+
+	return retention ? min(retention, limit_retention) : limit_retention;
+}
+
 void Session::data_feed_in(shared_ptr<sigrok::Device> device,
 	shared_ptr<Packet> packet)
 {
@@ -1044,31 +1479,46 @@ void Session::data_feed_in(shared_ptr<sigrok::Device> device,
 		feed_in_frame_begin();
 		break;
 
+	case SR_DF_FRAME_END:
+		close_frame();
+		frame_ended();
+		break;
+
 	case SR_DF_LOGIC:
+	{
+		const shared_ptr<Logic> logic =
+			dynamic_pointer_cast<Logic>(packet->payload());
+		if (memory_limit_reached(logic->data_length()))
+			break;
+
 		try {
-			feed_in_logic(dynamic_pointer_cast<Logic>(packet->payload()));
+			feed_in_logic(logic);
 		} catch (std::bad_alloc) {
 			out_of_memory_ = true;
 			device_->stop();
 		}
 		break;
+	}
 
 	case SR_DF_ANALOG:
+	{
+		const shared_ptr<Analog> analog =
+			dynamic_pointer_cast<Analog>(packet->payload());
+		if (memory_limit_reached(analog_packet_size(analog)))
+			break;
+
 		try {
-			feed_in_analog(dynamic_pointer_cast<Analog>(packet->payload()));
+			feed_in_analog(analog);
 		} catch (std::bad_alloc) {
 			out_of_memory_ = true;
 			device_->stop();
 		}
 		break;
+	}
 
 	case SR_DF_END:
 	{
-		{
-			lock_guard<recursive_mutex> lock(data_mutex_);
-			cur_logic_segment_.reset();
-			cur_analog_segments_.clear();
-		}
+		close_frame();
 		frame_ended();
 		break;
 	}
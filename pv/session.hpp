@@ -20,6 +20,7 @@
 #ifndef PULSEVIEW_PV_SESSION_HPP
 #define PULSEVIEW_PV_SESSION_HPP
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -41,6 +42,7 @@
 #include <QString>
 
 #include "util.hpp"
+#include "data/summaryworker.hpp"
 #include "views/viewbase.hpp"
 
 struct srd_decoder;
@@ -65,8 +67,11 @@ class DeviceManager;
 namespace data {
 class Analog;
 class AnalogSegment;
+class ChannelPacker;
+class ChunkAllocator;
 class Logic;
 class LogicSegment;
+struct MemoryUsage;
 class SignalBase;
 class SignalData;
 }
@@ -94,6 +99,19 @@ public:
 		Running
 	};
 
+private:
+	/// The share of the memory limit the samples may take in roll mode,
+	/// leaving the rest for the summaries and decoder annotations.
+	static const double RollMemoryShare;
+
+	/// The length in seconds of the window of samples kept in roll mode,
+	/// unless set otherwise.
+	static const double DefaultRollWindow;
+
+	/// The share of the memory limit that is taken in before the memory
+	/// usage is measured again, while roll mode keeps it above the limit.
+	static const double MemoryRecheckShare;
+
 public:
 	Session(DeviceManager &device_manager, QString name);
 
@@ -156,6 +174,102 @@ public:
 
 	double get_samplerate() const;
 
+	/**
+	 * Returns true if the logic data of new captures is stored as a list
+	 * of transitions. @see data::LogicSegment::TransitionStorage
+	 */
+	bool sparse_logic_storage() const;
+
+	void set_sparse_logic_storage(bool sparse);
+
+	/**
+	 * Returns true if the mip-maps of new logic segments keep the number
+	 * of edges of every channel. @see data::LogicSegment::LogicSegment()
+	 */
+	bool logic_edge_counts() const;
+
+	void set_logic_edge_counts(bool edge_counts);
+
+	/**
+	 * Returns true if the analog data of new captures is stored in 16
+	 * bits per sample for as long as it fits the codes of an ADC.
+	 * @see data::AnalogSegment::SampleFormat
+	 */
+	bool compact_analog_storage() const;
+
+	void set_compact_analog_storage(bool compact);
+
+	/**
+	 * Returns true if decoder stacks are run in worker processes of
+	 * their own, so that they decode in parallel.
+	 * @see data::decode::DecodeProcess
+	 */
+	bool decode_worker_processes() const;
+
+	void set_decode_worker_processes(bool enable);
+
+	/**
+	 * Returns the number of bytes of samples that are kept in memory
+	 * before the oldest are spilled to a scratch file, or 0 if there is
+	 * no limit. @see data::ChunkAllocator
+	 */
+	uint64_t ram_budget() const;
+
+	void set_ram_budget(uint64_t ram_budget);
+
+	/**
+	 * Returns the directory the scratch file is created in.
+	 */
+	QString spill_directory() const;
+
+	void set_spill_directory(const QString &spill_directory);
+
+	/**
+	 * Returns the memory held by the samples, summaries and decoder
+	 * annotations of the session. This takes the locks of all the data,
+	 * so it is only measured now and then, e.g. by the usage display.
+	 */
+	data::MemoryUsage memory_usage() const;
+
+	/**
+	 * Returns the number of bytes of memory the session may hold before
+	 * a capture is stopped, or 0 if there is no limit.
+	 * @see memory_usage()
+	 */
+	uint64_t memory_limit() const;
+
+	void set_memory_limit(uint64_t memory_limit);
+
+	/**
+	 * Returns true if captures run continuously, keeping only the most
+	 * recent samples instead of stopping at the memory limit.
+	 */
+	bool roll_mode() const;
+
+	void set_roll_mode(bool roll_mode);
+
+	/**
+	 * Returns the length in seconds of the window of samples that is
+	 * kept in roll mode, or 0 if only the memory limit bounds it. With
+	 * neither set, @c DefaultRollWindow is kept.
+	 */
+	double roll_window() const;
+
+	void set_roll_window(double roll_window);
+
+	/**
+	 * Returns the number of the oldest frame that is still held. Older
+	 * frames are evicted to stay within the memory limit.
+	 */
+	uint64_t first_frame() const;
+
+	/**
+	 * Returns the number of frames captured so far, including the
+	 * evicted ones. Frame @c n is held in the segment that
+	 * data::SignalData::frame_segment(n) returns.
+	 */
+	uint64_t frame_count() const;
+
 	void register_view(std::shared_ptr<views::ViewBase> view);
 
 	void deregister_view(std::shared_ptr<views::ViewBase> view);
@@ -190,10 +304,62 @@ private:
 
 	void feed_in_frame_begin();
 
+	/**
+	 * Returns the number of the frame that new segments belong to,
+	 * beginning a new frame if none is open.
+	 */
+	uint64_t open_frame();
+
+	/**
+	 * Ends the current frame, so that the next samples begin a new one.
+	 */
+	void close_frame();
+
+	/**
+	 * Frees the oldest frame.
+	 * @return false if only the newest frame is left.
+	 */
+	bool evict_oldest_frame();
+
+	/**
+	 * Creates the packer that narrows new logic segments to the channels
+	 * that are shown or decoded.
+	 * @param unit_size The size of the samples from the device.
+	 * @return The packer, or nullptr if repacking would not save memory.
+	 */
+	std::shared_ptr<const data::ChannelPacker> repack_logic_channels(
+		unsigned int unit_size);
+
 	void feed_in_logic(std::shared_ptr<sigrok::Logic> logic);
 
 	void feed_in_analog(std::shared_ptr<sigrok::Analog> analog);
 
+	/**
+	 * Evicts the oldest frames if taking in another @c size bytes of
+	 * samples would exceed the memory limit, or stops the capture if
+	 * only the newest frame is left. In roll mode the capture goes on,
+	 * as the retention of the segments bounds the newest frame. The
+	 * memory usage is estimated from
+	 * the last measurement and the samples taken in since, and only
+	 * measured again once the estimate reaches the limit, or in roll
+	 * mode @c MemoryRecheckShare of the limit above the last
+	 * measurement.
+	 * @return true if the capture is being stopped.
+	 */
+	bool memory_limit_reached(uint64_t size);
+
+	/**
+	 * Returns the number of bytes the samples of an analog packet take
+	 * up in the segments of its channels.
+	 */
+	uint64_t analog_packet_size(std::shared_ptr<sigrok::Analog> analog) const;
+
+	/**
+	 * Returns the number of samples each segment keeps in roll mode,
+	 * or 0 if all of them are kept.
+	 */
+	uint64_t roll_retention() const;
+
 	void data_feed_in(std::shared_ptr<sigrok::Device> device,
 		std::shared_ptr<sigrok::Packet> packet);
 
@@ -222,9 +388,35 @@ private:
 
 	std::thread sampling_thread_;
 
+	const std::shared_ptr<data::ChunkAllocator> chunk_allocator_;
+
+	bool sparse_logic_storage_;
+	bool logic_edge_counts_;
+	bool compact_analog_storage_;
+	std::atomic<bool> decode_worker_processes_;
+	std::atomic<uint64_t> memory_limit_;
+	bool memory_limit_reached_;
+
+	/// The last memory usage measured, and the bytes of samples taken
+	/// in since
+	mutable std::atomic<uint64_t> measured_memory_usage_;
+	mutable std::atomic<uint64_t> unmeasured_bytes_;
+
+	/// The estimated memory usage up to which it is not measured again,
+	/// or 0 if that is the memory limit
+	uint64_t memory_recheck_level_;
+	bool roll_mode_;
+	double roll_window_;
+	std::atomic<uint64_t> first_frame_;
+	std::atomic<uint64_t> frame_count_;
 	bool out_of_memory_;
 	bool data_saved_;
 
+	/// Builds the mip-maps and envelopes off the data feed thread. This is
+	/// declared last so that the worker stops before anything else is
+	/// torn down.
+	data::SummaryWorker summary_worker_;
+
 Q_SIGNALS:
 	void capture_state_changed(int state);
 	void device_changed();
@@ -239,8 +431,14 @@ Q_SIGNALS:
 
 	void data_received();
 
+	/// Emitted from the summary worker when it caught up with the data
+	void summaries_updated();
+
 	void frame_ended();
 
+	/// Emitted when a frame begins or the oldest one is evicted
+	void frames_changed();
+
 	void add_view(const QString &title, views::ViewType type,
 		Session *session);
 
@@ -33,6 +33,7 @@
 #include <pv/session.hpp>
 #include <pv/data/analog.hpp>
 #include <pv/data/analogsegment.hpp>
+#include <pv/data/channelpacker.hpp>
 #include <pv/data/logic.hpp>
 #include <pv/data/logicsegment.hpp>
 #include <pv/data/signalbase.hpp>
@@ -43,12 +44,12 @@
 using boost::shared_lock;
 using boost::shared_mutex;
 
-using std::deque;
 using std::dynamic_pointer_cast;
 using std::ios_base;
 using std::lock_guard;
 using std::make_pair;
 using std::map;
+using std::max;
 using std::min;
 using std::mutex;
 using std::pair;
@@ -75,11 +76,12 @@ StoreSession::StoreSession(const std::string &file_name,
 	const shared_ptr<OutputFormat> &output_format,
 	const map<string, VariantBase> &options,
 	const std::pair<uint64_t, uint64_t> sample_range,
-	const Session &session) :
+	uint64_t frame, const Session &session) :
 	file_name_(file_name),
 	output_format_(output_format),
 	options_(options),
 	sample_range_(sample_range),
+	frame_(frame),
 	session_(session),
 	interrupt_(false),
 	units_stored_(0),
@@ -120,15 +122,13 @@ bool StoreSession::start()
 			// All logic channels share the same data segments
 			shared_ptr<data::Logic> ldata = signal->logic_data();
 
-			const deque< shared_ptr<data::LogicSegment> > &lsegments =
-				ldata->logic_segments();
+			lsegment = ldata->logic_segment(frame_);
 
-			if (lsegments.empty()) {
+			if (!lsegment) {
 				error_ = tr("Can't save logic channel without data.");
 				return false;
 			}
 
-			lsegment = lsegments.front();
 			any_segment = lsegment;
 		}
 
@@ -136,16 +136,16 @@ bool StoreSession::start()
 			// Each analog channel has its own segments
 			shared_ptr<data::Analog> adata = signal->analog_data();
 
-			const deque< shared_ptr<data::AnalogSegment> > &asegments =
-				adata->analog_segments();
+			const shared_ptr<data::AnalogSegment> asegment =
+				adata->analog_segment(frame_);
 
-			if (asegments.empty()) {
+			if (!asegment) {
 				error_ = tr("Can't save analog channel without data.");
 				return false;
 			}
 
-			asegment_list.push_back(asegments.front());
-			any_segment = asegments.front();
+			asegment_list.push_back(asegment);
+			any_segment = asegment;
 
 			achannel_list.push_back(signal);
 		}
@@ -156,24 +156,24 @@ bool StoreSession::start()
 		return false;
 	}
 
-	// Check whether the user wants to export a certain sample range
+	// Check whether the user wants to export a certain sample range,
+	// starting no earlier than the oldest sample kept in roll mode
+	const uint64_t first_sample = any_segment->get_first_sample();
 	uint64_t end_sample;
 
 	if (sample_range_.first == sample_range_.second) {
-		start_sample_ = 0;
-		sample_count_ =	any_segment->get_sample_count();
+		start_sample_ = first_sample;
+		end_sample = any_segment->get_sample_count();
 	} else {
-		if (sample_range_.first > sample_range_.second) {
-			start_sample_ = sample_range_.second;
-			end_sample = min(sample_range_.first, any_segment->get_sample_count());
-			sample_count_ = end_sample - start_sample_;
-		} else {
-			start_sample_ = sample_range_.first;
-			end_sample = min(sample_range_.second, any_segment->get_sample_count());
-			sample_count_ = end_sample - start_sample_;
-		}
+		start_sample_ = max(min(sample_range_.first, sample_range_.second),
+			first_sample);
+		end_sample = min(max(sample_range_.first, sample_range_.second),
+			any_segment->get_sample_count());
 	}
 
+	sample_count_ = (end_sample > start_sample_) ?
+		end_sample - start_sample_ : 0;
+
 	// Begin storing
 	try {
 		const auto context = session_.device_manager().context();
@@ -221,14 +221,21 @@ void StoreSession::store_proc(vector< shared_ptr<data::SignalBase> > achannel_li
 	int lunit_size = 0;
 	unsigned int lsamples_per_block = INT_MAX;
 	unsigned int asamples_per_block = INT_MAX;
+	shared_ptr<const data::ChannelPacker> lpacker;
+	vector<uint8_t> lbuffer;
 
 	if (!asegment_list.empty()) {
-		// We assume all analog channels use the sample unit size
-		aunit_size = asegment_list.front()->unit_size();
+		// Analog samples are exported as floats, whatever the
+		// format they are stored in
+		aunit_size = sizeof(float);
 		asamples_per_block = BlockSize / aunit_size;
 	}
 	if (lsegment) {
-		lunit_size = lsegment->unit_size();
+		// Repacked samples are restored to the layout of the device,
+		// which is what the output formats expect
+		lpacker = lsegment->channel_packer();
+		lunit_size = lpacker ? lpacker->source_unit_size() :
+			lsegment->unit_size();
 		lsamples_per_block = BlockSize / lunit_size;
 	}
 
@@ -245,46 +252,61 @@ void StoreSession::store_proc(vector< shared_ptr<data::SignalBase> > achannel_li
 	while (!interrupt_ && sample_count_) {
 		progress_updated();
 
-		const uint64_t packet_len =
+		uint64_t packet_len =
 			std::min((uint64_t)samples_per_block, sample_count_);
 
+		// The sample views point straight into the segments and may end
+		// early at a storage chunk boundary, so shorten the packet to
+		// what all of them can provide
+		vector<data::SegmentDataView> aviews;
+		for (shared_ptr<data::AnalogSegment> asegment : asegment_list) {
+			aviews.push_back(asegment->get_samples(
+				start_sample_, start_sample_ + packet_len));
+			packet_len = min(packet_len, aviews.back().sample_count());
+		}
+
+		data::SegmentDataView lview;
+		if (lsegment) {
+			lview = lsegment->get_samples(
+				start_sample_, start_sample_ + packet_len);
+			packet_len = min(packet_len, lview.sample_count());
+		}
+
 		try {
 			const auto context = session_.device_manager().context();
 
 			for (unsigned int i = 0; i < achannel_list.size(); i++) {
 				shared_ptr<sigrok::Channel> achannel = (achannel_list.at(i))->channel();
-				shared_ptr<data::AnalogSegment> asegment = asegment_list.at(i);
-
-				const float *adata =
-					asegment->get_samples(start_sample_, start_sample_ + packet_len);
 
 				// The srzip format currently only supports packets with one
 				// analog channel. See zip_append_analog() in srzip.c
 				auto analog = context->create_analog_packet(
 					vector<shared_ptr<sigrok::Channel> >{achannel},
-					(float *)adata, packet_len,
+					(float *)aviews[i].data(), packet_len,
 					sigrok::Quantity::VOLTAGE, sigrok::Unit::VOLT,
 					vector<const sigrok::QuantityFlag *>());
 				const string adata_str = output_->receive(analog);
 
 				if (output_stream_.is_open())
 					output_stream_ << adata_str;
-
-				delete[] adata;
 			}
 
 			if (lsegment) {
-				const uint8_t* ldata =
-					lsegment->get_samples(start_sample_, start_sample_ + packet_len);
-
 				const size_t length = packet_len * lunit_size;
-				auto logic = context->create_logic_packet((void*)ldata, length, lunit_size);
+				const uint8_t *ldata = lview.data();
+				if (lpacker) {
+					lbuffer.resize(length);
+					lpacker->unpack(ldata, packet_len,
+						lbuffer.data());
+					ldata = lbuffer.data();
+				}
+
+				auto logic = context->create_logic_packet(
+					(void*)ldata, length, lunit_size);
 				const string ldata_str = output_->receive(logic);
 
 				if (output_stream_.is_open())
 					output_stream_ << ldata_str;
-
-				delete[] ldata;
 			}
 		} catch (Error error) {
 			error_ = tr("Error while saving: ") + error.what();
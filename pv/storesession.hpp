@@ -61,7 +61,7 @@ public:
 		const std::shared_ptr<sigrok::OutputFormat> &output_format,
 		const std::map<std::string, Glib::VariantBase> &options,
 		const std::pair<uint64_t, uint64_t> sample_range,
-		const Session &session);
+		uint64_t frame, const Session &session);
 
 	~StoreSession();
 
@@ -90,6 +90,7 @@ private:
 	const std::shared_ptr<sigrok::OutputFormat> output_format_;
 	const std::map<std::string, Glib::VariantBase> options_;
 	const std::pair<uint64_t, uint64_t> sample_range_;
+	const uint64_t frame_;
 	const Session &session_;
 
 	std::shared_ptr<sigrok::Output> output_;
@@ -35,6 +35,7 @@
 
 #include <boost/algorithm/string/join.hpp>
 
+#include <pv/data/memoryusage.hpp>
 #include <pv/devicemanager.hpp>
 #include <pv/devices/hardwaredevice.hpp>
 #include <pv/devices/inputfile.hpp>
@@ -43,6 +44,7 @@
 #include <pv/dialogs/inputoutputoptions.hpp>
 #include <pv/dialogs/storeprogress.hpp>
 #include <pv/mainwindow.hpp>
+#include <pv/popups/captureoptions.hpp>
 #include <pv/popups/deviceoptions.hpp>
 #include <pv/popups/channels.hpp>
 #include <pv/util.hpp>
@@ -82,6 +84,8 @@ const uint64_t MainBar::MinSampleCount = 100ULL;
 const uint64_t MainBar::MaxSampleCount = 1000000000000ULL;
 const uint64_t MainBar::DefaultSampleCount = 1000000;
 
+const int MainBar::MemoryUsageUpdatePeriod = 500;
+
 const char *MainBar::SettingOpenDirectory = "MainWindow/OpenDirectory";
 const char *MainBar::SettingSaveDirectory = "MainWindow/SaveDirectory";
 
@@ -93,6 +97,7 @@ MainBar::MainBar(Session &session, QWidget *parent,
 	action_save_as_(new QAction(this)),
 	action_save_selection_as_(new QAction(this)),
 	action_connect_(new QAction(this)),
+	action_roll_mode_(new QAction(this)),
 	open_button_(new QToolButton()),
 	save_button_(new QToolButton()),
 	device_selector_(parent, session.device_manager(),
@@ -105,7 +110,11 @@ MainBar::MainBar(Session &session, QWidget *parent,
 	sample_rate_("Hz", this),
 	updating_sample_rate_(false),
 	updating_sample_count_(false),
-	sample_count_supported_(false)
+	sample_count_supported_(false),
+	memory_usage_(this),
+	memory_limit_(this),
+	roll_window_(this),
+	capture_options_button_(this)
 #ifdef ENABLE_DECODE
 	, add_decoder_button_(new QToolButton()),
 	menu_decoders_add_(new pv::widgets::DecoderMenu(this, true))
@@ -159,6 +168,13 @@ MainBar::MainBar(Session &session, QWidget *parent,
 	connect(action_connect_, SIGNAL(triggered(bool)),
 		this, SLOT(on_actionConnect_triggered()));
 
+	action_roll_mode_->setText(tr("&Roll Mode"));
+	action_roll_mode_->setToolTip(tr("Capture continuously, keeping only "
+		"the most recent samples"));
+	action_roll_mode_->setCheckable(true);
+	connect(action_roll_mode_, SIGNAL(triggered(bool)),
+		this, SLOT(on_actionRollMode_triggered(bool)));
+
 	// Open button
 	widgets::ImportMenu *import_menu = new widgets::ImportMenu(this,
 		session.device_manager().context(), action_open_);
@@ -209,9 +225,37 @@ MainBar::MainBar(Session &session, QWidget *parent,
 	connect(&sample_rate_, SIGNAL(value_changed()),
 		this, SLOT(on_sample_rate_changed()));
 
+	memory_usage_timer_.setInterval(MemoryUsageUpdatePeriod);
+	connect(&memory_usage_timer_, SIGNAL(timeout()),
+		this, SLOT(on_memory_usage_timeout()));
+
+	memory_limit_.setRange(0, 1024 * 1024);
+	memory_limit_.setSingleStep(256);
+	memory_limit_.setPrefix(tr("Limit: "));
+	memory_limit_.setSuffix(tr(" MiB"));
+	memory_limit_.setSpecialValueText(tr("No limit"));
+	memory_limit_.setToolTip(tr("The memory the captured data may take "
+		"up. The oldest frames are dropped to make room, and the capture "
+		"stops once only the newest one is left. In roll mode the oldest "
+		"samples are dropped instead."));
+	connect(&memory_limit_, SIGNAL(valueChanged(int)),
+		this, SLOT(on_memory_limit_changed(int)));
+
+	roll_window_.setRange(0, 24 * 60 * 60);
+	roll_window_.setDecimals(1);
+	roll_window_.setPrefix(tr("Window: "));
+	roll_window_.setSuffix(tr(" s"));
+	roll_window_.setSpecialValueText(tr("By limit"));
+	roll_window_.setToolTip(tr("The time span of the samples kept in roll "
+		"mode. Fewer samples are kept if they would not fit the memory "
+		"limit."));
+	connect(&roll_window_, SIGNAL(valueChanged(double)),
+		this, SLOT(on_roll_window_changed(double)));
+
 	sample_count_.show_min_max_step(0, UINT64_MAX, 1);
 
 	set_capture_state(pv::Session::Stopped);
+	update_capture_settings();
 
 	configure_button_.setToolTip(tr("Configure Device"));
 	configure_button_.setIcon(QIcon::fromTheme("configure",
@@ -221,6 +265,12 @@ MainBar::MainBar(Session &session, QWidget *parent,
 	channels_button_.setIcon(QIcon::fromTheme("channels",
 		QIcon(":/icons/channels.svg")));
 
+	capture_options_button_.setToolTip(tr("Capture Options"));
+	capture_options_button_.setIcon(QIcon::fromTheme("document-properties",
+		QIcon(":/icons/configure.png")));
+	capture_options_button_.set_popup(
+		new popups::CaptureOptions(session_, this));
+
 	add_toolbar_widgets();
 
 	sample_count_.installEventFilter(this);
@@ -258,8 +308,32 @@ void MainBar::set_capture_state(pv::Session::capture_state state)
 	device_selector_.setEnabled(ui_enabled);
 	configure_button_.setEnabled(ui_enabled);
 	channels_button_.setEnabled(ui_enabled);
-	sample_count_.setEnabled(ui_enabled);
+	capture_options_button_.setEnabled(ui_enabled);
 	sample_rate_.setEnabled(ui_enabled);
+
+	// Roll mode captures until it is stopped
+	sample_count_.setEnabled(ui_enabled && !session_.roll_mode());
+	roll_window_.setEnabled(ui_enabled && session_.roll_mode());
+
+	// Follow the memory usage while capturing, and show the final
+	// figure once the capture has stopped
+	if (ui_enabled)
+		memory_usage_timer_.stop();
+	else
+		memory_usage_timer_.start();
+	update_memory_usage();
+}
+
+void MainBar::update_capture_settings()
+{
+	action_roll_mode_->setChecked(session_.roll_mode());
+	memory_limit_.setValue(session_.memory_limit() >> 20);
+	roll_window_.setValue(session_.roll_window());
+
+	const bool ui_enabled =
+		(session_.get_capture_state() == pv::Session::Stopped);
+	sample_count_.setEnabled(ui_enabled && !session_.roll_mode());
+	roll_window_.setEnabled(ui_enabled && session_.roll_mode());
 }
 
 void MainBar::reset_device_selector()
@@ -287,6 +361,11 @@ QAction* MainBar::action_connect() const
 	return action_connect_;
 }
 
+QAction* MainBar::action_roll_mode() const
+{
+	return action_roll_mode_;
+}
+
 void MainBar::update_sample_rate_selector()
 {
 	Glib::VariantContainerBase gvar_dict;
@@ -648,8 +727,9 @@ void MainBar::export_file(shared_ptr<OutputFormat> format,
 	if (!selection_only)
 		session_.set_name(QFileInfo(file_name).fileName());
 
+	// Save the frame that is shown
 	StoreProgress *dlg = new StoreProgress(file_name, format, options,
-		sample_range, session_, this);
+		sample_range, view_->current_frame(), session_, this);
 	dlg->run();
 }
 
@@ -705,6 +785,27 @@ void MainBar::on_device_selected()
 	session_.select_device(device);
 }
 
+void MainBar::update_memory_usage()
+{
+	const data::MemoryUsage usage = session_.memory_usage();
+	const uint64_t limit = session_.memory_limit();
+
+	if (limit)
+		memory_usage_.setText(tr("%1 of %2").arg(
+			util::format_size(usage.total()), util::format_size(limit)));
+	else
+		memory_usage_.setText(util::format_size(usage.total()));
+
+	memory_usage_.setToolTip(tr("Memory usage\n"
+		"Samples: %1\nCompressed samples: %2\nSpilled samples: %3\n"
+		"Summaries: %4\nAnnotations: %5").arg(
+		util::format_size(usage.samples),
+		util::format_size(usage.compressed),
+		util::format_size(usage.spilled),
+		util::format_size(usage.summaries),
+		util::format_size(usage.annotations)));
+}
+
 void MainBar::on_device_changed()
 {
 	update_device_list();
@@ -728,6 +829,23 @@ void MainBar::on_sample_rate_changed()
 		commit_sample_rate();
 }
 
+void MainBar::on_memory_usage_timeout()
+{
+	update_memory_usage();
+}
+
+void MainBar::on_memory_limit_changed(int mebibytes)
+{
+	session_.set_memory_limit((uint64_t)mebibytes << 20);
+	update_memory_usage();
+}
+
+void MainBar::on_roll_window_changed(double seconds)
+{
+	// Takes effect with the next capture
+	session_.set_roll_window(seconds);
+}
+
 void MainBar::on_config_changed()
 {
 	commit_sample_count();
@@ -783,6 +901,13 @@ void MainBar::on_actionConnect_triggered()
 	update_device_list();
 }
 
+void MainBar::on_actionRollMode_triggered(bool checked)
+{
+	// Takes effect with the next capture
+	session_.set_roll_mode(checked);
+	update_capture_settings();
+}
+
 void MainBar::add_toolbar_widgets()
 {
 	addAction(action_new_view_);
@@ -797,6 +922,11 @@ void MainBar::add_toolbar_widgets()
 	configure_button_action_ = addWidget(&configure_button_);
 	channels_button_action_ = addWidget(&channels_button_);
 	addWidget(&sample_count_);
+	addWidget(&memory_usage_);
+	addWidget(&capture_options_button_);
+	addAction(action_roll_mode_);
+	addWidget(&roll_window_);
+	addWidget(&memory_limit_);
 	addWidget(&sample_rate_);
 #ifdef ENABLE_DECODE
 	addSeparator();
@@ -29,7 +29,10 @@
 
 #include <QComboBox>
 #include <QDoubleSpinBox>
+#include <QLabel>
 #include <QMenu>
+#include <QSpinBox>
+#include <QTimer>
 #include <QToolBar>
 #include <QToolButton>
 
@@ -71,6 +74,9 @@ private:
 	static const uint64_t MaxSampleCount;
 	static const uint64_t DefaultSampleCount;
 
+	/// The interval of the memory usage updates while capturing, in ms
+	static const int MemoryUsageUpdatePeriod;
+
 	/**
 	 * Name of the setting used to remember the directory
 	 * containing the last file that was opened.
@@ -91,6 +97,12 @@ public:
 
 	void set_capture_state(pv::Session::capture_state state);
 
+	/**
+	 * Shows the capture settings of the session, e.g. once they have
+	 * been restored.
+	 */
+	void update_capture_settings();
+
 	void reset_device_selector();
 
 	QAction* action_new_view() const;
@@ -98,6 +110,7 @@ public:
 	QAction* action_save_as() const;
 	QAction* action_save_selection_as() const;
 	QAction* action_connect() const;
+	QAction* action_roll_mode() const;
 
 	void session_error(const QString text, const QString info_text);
 
@@ -114,12 +127,14 @@ private:
 	void update_device_config_widgets();
 	void commit_sample_rate();
 	void commit_sample_count();
+	void update_memory_usage();
 
 	QAction *const action_new_view_;
 	QAction *const action_open_;
 	QAction *const action_save_as_;
 	QAction *const action_save_selection_as_;
 	QAction *const action_connect_;
+	QAction *const action_roll_mode_;
 
 private Q_SLOTS:
 	void show_session_error(const QString text, const QString info_text);
@@ -135,6 +150,9 @@ private Q_SLOTS:
 	void on_capture_state_changed(int state);
 	void on_sample_count_changed();
 	void on_sample_rate_changed();
+	void on_memory_usage_timeout();
+	void on_memory_limit_changed(int mebibytes);
+	void on_roll_window_changed(double seconds);
 
 	void on_config_changed();
 
@@ -146,6 +164,8 @@ private Q_SLOTS:
 
 	void on_actionConnect_triggered();
 
+	void on_actionRollMode_triggered(bool checked);
+
 protected:
 	void add_toolbar_widgets();
 
@@ -172,6 +192,13 @@ private:
 
 	bool sample_count_supported_;
 
+	QLabel memory_usage_;
+	QTimer memory_usage_timer_;
+	QSpinBox memory_limit_;
+	QDoubleSpinBox roll_window_;
+
+	pv::widgets::PopupToolButton capture_options_button_;
+
 #ifdef ENABLE_DECODE
 	QToolButton *add_decoder_button_;
 	QMenu *const menu_decoders_add_;
@@ -234,5 +234,20 @@ QString format_time_minutes(const Timestamp& t, signed precision, bool sign)
 	return s;
 }
 
+QString format_size(uint64_t bytes, unsigned precision)
+{
+	static const char *const prefixes[] = {"", "Ki", "Mi", "Gi", "Ti", "Pi"};
+
+	unsigned int prefix = 0;
+	double value = bytes;
+	while (value >= 1024 && prefix + 1 < sizeof(prefixes) / sizeof(*prefixes)) {
+		value /= 1024;
+		prefix++;
+	}
+
+	return QString("%1 %2B").arg(value, 0, 'f', prefix ? precision : 0)
+		.arg(prefixes[prefix]);
+}
+
 } // namespace util
 } // namespace pv
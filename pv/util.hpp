@@ -21,6 +21,7 @@
 #define PULSEVIEW_UTIL_HPP
 
 #include <cmath>
+#include <cstdint>
 
 #ifndef Q_MOC_RUN
 #include <boost/multiprecision/cpp_dec_float.hpp>
@@ -121,6 +122,17 @@ QString format_time_minutes(
 	signed precision = 0,
 	bool sign = true);
 
+/**
+ * Formats a number of bytes with a binary prefix, e.g. "1.5 MiB".
+ *
+ * @param bytes The value to format.
+ * @param precision The number of digits after the decimal separator. No
+ *        digits are shown for values below 1 KiB.
+ *
+ * @return The formatted value.
+ */
+QString format_size(uint64_t bytes, unsigned precision = 1);
+
 } // namespace util
 } // namespace pv
 
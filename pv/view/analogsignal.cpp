@@ -20,6 +20,8 @@
 #include <extdef.h>
 
 #include <cassert>
+#include <cfloat>
+#include <climits>
 #include <cmath>
 #include <cstdlib>
 #include <limits>
@@ -44,7 +46,7 @@ using std::max;
 using std::make_pair;
 using std::min;
 using std::shared_ptr;
-using std::deque;
+using std::swap;
 
 namespace pv {
 namespace views {
@@ -61,6 +63,7 @@ const QColor AnalogSignal::GridMajorColor = QColor(0, 0, 0, 40*256/100);
 const QColor AnalogSignal::GridMinorColor = QColor(0, 0, 0, 20*256/100);
 
 const float AnalogSignal::EnvelopeThreshold = 256.0f;
+const float AnalogSignal::DecimationThreshold = 4.0f;
 
 const int AnalogSignal::MaximumVDivs = 10;
 const int AnalogSignal::MinScaleIndex = -6;
@@ -135,6 +138,25 @@ void AnalogSignal::scale_handle_drag_release()
 	update_scale();
 }
 
+pv::data::AnalogSegment::Statistics AnalogSignal::get_statistics(
+	const pv::util::Timestamp &start, const pv::util::Timestamp &end) const
+{
+	const pv::data::AnalogSegment::Statistics empty =
+		{0, 0.0, 0.0, FLT_MAX, -FLT_MAX};
+
+	if (!owner_)
+		return empty;
+
+	const shared_ptr<pv::data::AnalogSegment> segment =
+		base_->analog_data()->analog_segment(owner_->view()->current_frame());
+	if (!segment)
+		return empty;
+
+	return segment->get_statistics(
+		segment->time_to_sample(min(start, end)),
+		segment->time_to_sample(max(start, end)));
+}
+
 void AnalogSignal::paint_back(QPainter &p, const ViewItemPaintParams &pp)
 {
 	if (base_->enabled()) {
@@ -155,26 +177,24 @@ void AnalogSignal::paint_mid(QPainter &p, const ViewItemPaintParams &pp)
 
 	paint_grid(p, y, pp.left(), pp.right());
 
-	const deque< shared_ptr<pv::data::AnalogSegment> > &segments =
-		base_->analog_data()->analog_segments();
-	if (segments.empty())
+	const shared_ptr<pv::data::AnalogSegment> segment =
+		base_->analog_data()->analog_segment(owner_->view()->current_frame());
+	if (!segment)
 		return;
 
-	const shared_ptr<pv::data::AnalogSegment> &segment =
-		segments.front();
-
 	const double pixels_offset = pp.pixels_offset();
 	const double samplerate = max(1.0, segment->samplerate());
 	const pv::util::Timestamp& start_time = segment->start_time();
+	const int64_t first_sample = segment->get_first_sample();
 	const int64_t last_sample = segment->get_sample_count() - 1;
 	const double samples_per_pixel = samplerate * pp.scale();
 	const pv::util::Timestamp start = samplerate * (pp.offset() - start_time);
 	const pv::util::Timestamp end = start + samples_per_pixel * pp.width();
 
 	const int64_t start_sample = min(max(floor(start).convert_to<int64_t>(),
-		(int64_t)0), last_sample);
+		first_sample), last_sample);
 	const int64_t end_sample = min(max((ceil(end) + 1).convert_to<int64_t>(),
-		(int64_t)0), last_sample);
+		first_sample), last_sample);
 
 	if (samples_per_pixel < EnvelopeThreshold)
 		paint_trace(p, segment, y, pp.left(),
@@ -240,27 +260,77 @@ void AnalogSignal::paint_trace(QPainter &p,
 	int y, int left, const int64_t start, const int64_t end,
 	const double pixels_offset, const double samples_per_pixel)
 {
-	const int64_t sample_count = end - start;
-
-	const float *const samples = segment->get_samples(start, end);
-	assert(samples);
-
 	p.setPen(base_->colour());
 
-	QPointF *points = new QPointF[sample_count];
-	QPointF *point = points;
-
-	for (int64_t sample = start; sample != end; sample++) {
-		const float x = (sample / samples_per_pixel -
-			pixels_offset) + left;
-		*point++ = QPointF(x,
-			y - samples[sample - start] * scale_);
+	// With several samples per pixel, each pixel column is reduced to
+	// its first, lowest, highest and last sample, in the order they
+	// occur. The polyline looks the same, but has at most four points
+	// per pixel. The point buffer is kept between paints.
+	const bool decimate = samples_per_pixel >= DecimationThreshold;
+
+	trace_points_.clear();
+
+	TraceColumn column;
+	column.x = INT_MIN;
+
+	for (int64_t sample = start; sample != end;) {
+		// The view points straight into the segment and may end early
+		// at a storage chunk boundary
+		const pv::data::SegmentDataView view =
+			segment->get_samples(sample, end);
+		const float *src = (const float*)view.data();
+		const float *const src_end = src + view.sample_count();
+
+		for (; src != src_end; src++, sample++) {
+			const TraceVertex v = {sample, QPointF((sample /
+				samples_per_pixel - pixels_offset) + left,
+				y - *src * scale_)};
+
+			if (!decimate) {
+				trace_points_.push_back(v.point);
+				continue;
+			}
+
+			const int x = floor(v.point.x());
+			if (x != column.x) {
+				append_trace_column(column);
+				column.x = x;
+				column.first = column.low = column.high =
+					column.last = v;
+				continue;
+			}
+
+			if (v.point.y() < column.low.point.y())
+				column.low = v;
+			if (v.point.y() > column.high.point.y())
+				column.high = v;
+			column.last = v;
+		}
 	}
 
-	p.drawPolyline(points, point - points);
+	if (decimate)
+		append_trace_column(column);
+
+	p.drawPolyline(trace_points_.data(), trace_points_.size());
+}
+
+void AnalogSignal::append_trace_column(const TraceColumn &column)
+{
+	if (column.x == INT_MIN)
+		return;
 
-	delete[] samples;
-	delete[] points;
+	const TraceVertex *extremes[] = {&column.low, &column.high};
+	if (extremes[1]->sample < extremes[0]->sample)
+		swap(extremes[0], extremes[1]);
+
+	trace_points_.push_back(column.first.point);
+	for (const TraceVertex *v : extremes)
+		if (v->sample != column.first.sample &&
+			v->sample != column.last.sample &&
+			v->point != trace_points_.back())
+			trace_points_.push_back(v->point);
+	if (column.last.sample != column.first.sample)
+		trace_points_.push_back(column.last.point);
 }
 
 void AnalogSignal::paint_envelope(QPainter &p,
@@ -270,25 +340,29 @@ void AnalogSignal::paint_envelope(QPainter &p,
 {
 	using pv::data::AnalogSegment;
 
-	AnalogSegment::EnvelopeSection e;
-	segment->get_envelope_section(e, start, end, samples_per_pixel);
-
-	if (e.length < 2)
+	// Resample the envelope to one column per pixel. The buffers are
+	// kept between paints.
+	const int first_column = floor(start / samples_per_pixel -
+		pixels_offset);
+	const int last_column = ceil(end / samples_per_pixel -
+		pixels_offset);
+	if (last_column - first_column < 2)
 		return;
 
-	p.setPen(QPen(Qt::NoPen));
-	p.setBrush(base_->colour());
-
-	QRectF *const rects = new QRectF[e.length];
-	QRectF *rect = rects;
+	const unsigned int width = last_column - first_column;
+	envelope_columns_.resize(width);
+	segment->get_envelope_columns(envelope_columns_.data(), width,
+		(first_column + pixels_offset) * samples_per_pixel,
+		samples_per_pixel);
 
-	for (uint64_t sample = 0; sample < e.length-1; sample++) {
-		const float x = ((e.scale * sample + e.start) /
-			samples_per_pixel - pixels_offset) + left;
+	envelope_rects_.clear();
+	for (unsigned int i = 0; i < width - 1; i++) {
 		const AnalogSegment::EnvelopeSample *const s =
-			e.samples + sample;
+			&envelope_columns_[i];
+		if (s->min > s->max || (s+1)->min > (s+1)->max)
+			continue;
 
-		// We overlap this sample with the next so that vertical
+		// We overlap this column with the next so that vertical
 		// gaps do not appear during steep rising or falling edges
 		const float b = y - max(s->max, (s+1)->min) * scale_;
 		const float t = y - min(s->min, (s+1)->max) * scale_;
@@ -299,13 +373,13 @@ void AnalogSignal::paint_envelope(QPainter &p,
 		if (h <= 0.0f && h >= -1.0f)
 			h = -1.0f;
 
-		*rect++ = QRectF(x, t, 1.0f, h);
+		envelope_rects_.push_back(
+			QRectF(left + first_column + (int)i, t, 1.0f, h));
 	}
 
-	p.drawRects(rects, e.length);
-
-	delete[] rects;
-	delete[] e.samples;
+	p.setPen(QPen(Qt::NoPen));
+	p.setBrush(base_->colour());
+	p.drawRects(envelope_rects_.data(), envelope_rects_.size());
 }
 
 float AnalogSignal::get_resolution(int scale_index)
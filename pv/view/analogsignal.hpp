@@ -23,14 +23,18 @@
 #include "signal.hpp"
 
 #include <memory>
+#include <vector>
 
 #include <QComboBox>
+#include <QPointF>
+#include <QRectF>
+
+#include <pv/data/analogsegment.hpp>
 
 namespace pv {
 
 namespace data {
 class Analog;
-class AnalogSegment;
 class SignalBase;
 }
 
@@ -42,11 +46,27 @@ class AnalogSignal : public Signal
 	Q_OBJECT
 
 private:
+	struct TraceVertex
+	{
+		int64_t sample;
+		QPointF point;
+	};
+
+	/// The samples a decimated trace keeps of one pixel column
+	struct TraceColumn
+	{
+		int x;
+		TraceVertex first, low, high, last;
+	};
+
 	static const QColor SignalColours[4];
 	static const QColor GridMajorColor, GridMinorColor;
 
 	static const float EnvelopeThreshold;
 
+	/// The number of samples per pixel from which traces are decimated
+	static const float DecimationThreshold;
+
 	static const int MaximumVDivs;
 	static const int MaxScaleIndex, MinScaleIndex;
 	static const int InfoTextMarginRight, InfoTextMarginBottom;
@@ -85,6 +105,14 @@ public:
 	 */
 	void scale_handle_drag_release();
 
+	/**
+	 * Returns the statistics of the samples of the current frame that lie
+	 * between two times. The range is clipped to the samples held.
+	 */
+	pv::data::AnalogSegment::Statistics get_statistics(
+		const pv::util::Timestamp &start,
+		const pv::util::Timestamp &end) const;
+
 	/**
 	 * Paints the background layer of the signal with a QPainter
 	 * @param p the QPainter to paint into.
@@ -114,6 +142,11 @@ private:
 		int y, int left, const int64_t start, const int64_t end,
 		const double pixels_offset, const double samples_per_pixel);
 
+	/**
+	 * Appends the points of a decimated pixel column to the trace.
+	 */
+	void append_trace_column(const TraceColumn &column);
+
 	void paint_envelope(QPainter &p,
 		const std::shared_ptr<pv::data::AnalogSegment> &segment,
 		int y, int left, const int64_t start, const int64_t end,
@@ -144,6 +177,12 @@ private:
 	int div_height_;
 	int vdivs_;  // divs per positive/negative side
 	float resolution_; // e.g. 10 for 10 V/div
+
+	/// The trace points, envelope columns and their rectangles, kept
+	/// between paints
+	std::vector<QPointF> trace_points_;
+	std::vector<data::AnalogSegment::EnvelopeSample> envelope_columns_;
+	std::vector<QRectF> envelope_rects_;
 };
 
 } // namespace TraceView
@@ -19,6 +19,7 @@
 
 #include "cursorpair.hpp"
 
+#include "analogsignal.hpp"
 #include "ruler.hpp"
 #include "view.hpp"
 #include "pv/util.hpp"
@@ -29,8 +30,8 @@
 using std::max;
 using std::make_pair;
 using std::min;
-using std::shared_ptr;
 using std::pair;
+using std::shared_ptr;
 
 namespace pv {
 namespace views {
@@ -120,6 +121,14 @@ void CursorPair::paint_label(QPainter &p, const QRect &rect, bool hover)
 	const int radius = delta_rect.height() / 2;
 	const QRectF text_rect(delta_rect.intersected(
 		rect).adjusted(radius, 0, -radius, 0));
+
+	// Drop the signal statistics if they do not fit between the cursors
+	QString text = format_string();
+	if (text_rect.width() < text_size_.width()) {
+		text = format_string(false);
+		text_size_ = p.boundingRect(QRectF(), 0, text).size();
+	}
+
 	if (text_rect.width() >= text_size_.width()) {
 		const int highlight_radius = delta_rect.height() / 2 - 2;
 
@@ -139,8 +148,7 @@ void CursorPair::paint_label(QPainter &p, const QRect &rect, bool hover)
 		p.drawRoundedRect(delta_rect, highlight_radius, highlight_radius);
 
 		p.setPen(text_colour);
-		p.drawText(text_rect, Qt::AlignCenter | Qt::AlignVCenter,
-			format_string());
+		p.drawText(text_rect, Qt::AlignCenter | Qt::AlignVCenter, text);
 	}
 }
 
@@ -161,7 +169,7 @@ void CursorPair::paint_back(QPainter &p, const ViewItemPaintParams &pp)
 	p.drawRect(l, pp.top(), r - l, pp.height());
 }
 
-QString CursorPair::format_string()
+QString CursorPair::format_string(bool with_statistics)
 {
 	const pv::util::SIPrefix prefix = view_.tick_prefix();
 	const pv::util::Timestamp diff = abs(second_->time() - first_->time());
@@ -171,7 +179,35 @@ QString CursorPair::format_string()
 	const QString s2 = util::format_time_si(
 		1 / diff, pv::util::SIPrefix::unspecified, 4, "Hz", false);
 
-	return QString("%1 / %2").arg(s1).arg(s2);
+	QString s = QString("%1 / %2").arg(s1).arg(s2);
+	if (!with_statistics)
+		return s;
+
+	// Summarize the selected analog signal, or else the first one shown
+	shared_ptr<AnalogSignal> signal;
+	for (const shared_ptr<AnalogSignal> &a :
+		view_.list_by_type<AnalogSignal>()) {
+		if (!a->enabled())
+			continue;
+		if (!signal || a->selected())
+			signal = a;
+		if (a->selected())
+			break;
+	}
+
+	if (signal) {
+		const pv::data::AnalogSegment::Statistics st =
+			signal->get_statistics(first_->time(), second_->time());
+		if (st.count > 0)
+			s += QString(" / %1: %2 mean, %3 RMS")
+				.arg(signal->base()->name())
+				.arg(util::format_time_si(st.mean(),
+					pv::util::SIPrefix::unspecified, 4, "V", false))
+				.arg(util::format_time_si(st.rms(),
+					pv::util::SIPrefix::unspecified, 4, "V", false));
+	}
+
+	return s;
 }
 
 void CursorPair::compute_text_size(QPainter &p)
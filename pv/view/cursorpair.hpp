@@ -92,8 +92,10 @@ public:
 
 	/**
 	 * Constructs the string to display.
+	 * @param with_statistics true to append the mean and RMS of the
+	 * 	selected analog signal between the cursors.
 	 */
-	QString format_string();
+	QString format_string(bool with_statistics = true);
 
 	void compute_text_size(QPainter &p);
 
@@ -200,6 +200,14 @@ void DecodeTrace::paint_mid(QPainter &p, const ViewItemPaintParams &pp)
 		return;
 	}
 
+	// The decoders follow the frame of the view shown last, when more
+	// than one shows them
+	if (decoder_stack->frame() != owner_->view()->current_frame()) {
+		draw_error(p, tr("Frame %1 is decoded in another view").arg(
+			decoder_stack->frame() + 1), pp);
+		return;
+	}
+
 	// Set default pen to allow for text width calculation
 	p.setPen(Qt::black);
 
@@ -622,12 +630,13 @@ void DecodeTrace::draw_unresolved_period(QPainter &p, int h, int left,
 			((data = signalbase->logic_data())))
 			break;
 
-	if (!data || data->logic_segments().empty())
+	if (!data)
 		return;
 
 	const shared_ptr<LogicSegment> segment =
-		data->logic_segments().front();
-	assert(segment);
+		data->logic_segment(decoder_stack->frame());
+	if (!segment)
+		return;
 	const int64_t sample_count = (int64_t)segment->get_sample_count();
 	if (sample_count == 0)
 		return;
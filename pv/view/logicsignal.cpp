@@ -41,7 +41,6 @@
 
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
-using std::deque;
 using std::max;
 using std::make_pair;
 using std::min;
@@ -62,6 +61,8 @@ namespace views {
 namespace TraceView {
 
 const float LogicSignal::Oversampling = 2.0f;
+const double LogicSignal::SolidFillSamplesPerPixel = 64.0;
+const int LogicSignal::ActivityShadeCount = 8;
 
 const QColor LogicSignal::EdgeColour(0x80, 0x80, 0x80);
 const QColor LogicSignal::HighColour(0x00, 0xC0, 0x00);
@@ -112,7 +113,8 @@ LogicSignal::LogicSignal(
 {
 	shared_ptr<Trigger> trigger;
 
-	base_->set_colour(SignalColours[base->index() % countof(SignalColours)]);
+	base_->set_colour(SignalColours[base->channel()->index() %
+		countof(SignalColours)]);
 
 	/* Populate this channel's trigger setting with whatever we
 	 * find in the current session trigger, if anything. */
@@ -157,8 +159,6 @@ void LogicSignal::paint_mid(QPainter &p, const ViewItemPaintParams &pp)
 {
 	QLineF *line;
 
-	vector< pair<int64_t, bool> > edges;
-
 	assert(base_);
 	assert(owner_);
 
@@ -170,13 +170,15 @@ void LogicSignal::paint_mid(QPainter &p, const ViewItemPaintParams &pp)
 	const float high_offset = y - signal_height_ + 0.5f;
 	const float low_offset = y + 0.5f;
 
-	const deque< shared_ptr<pv::data::LogicSegment> > &segments =
-		base_->logic_data()->logic_segments();
-	if (segments.empty())
+	const shared_ptr<pv::data::LogicSegment> segment =
+		base_->logic_data()->logic_segment(owner_->view()->current_frame());
+	if (!segment)
 		return;
 
-	const shared_ptr<pv::data::LogicSegment> &segment =
-		segments.front();
+	// Channels that were not captured have no samples
+	const int bit = segment->channel_bit(base_->index());
+	if (bit < 0)
+		return;
 
 	double samplerate = segment->samplerate();
 
@@ -186,18 +188,36 @@ void LogicSignal::paint_mid(QPainter &p, const ViewItemPaintParams &pp)
 
 	const double pixels_offset = pp.pixels_offset();
 	const pv::util::Timestamp& start_time = segment->start_time();
+	const int64_t first_sample = segment->get_first_sample();
 	const int64_t last_sample = segment->get_sample_count() - 1;
 	const double samples_per_pixel = samplerate * pp.scale();
 	const pv::util::Timestamp start = samplerate * (pp.offset() - start_time);
 	const pv::util::Timestamp end = start + samples_per_pixel * pp.width();
 
 	const int64_t start_sample = min(max(floor(start).convert_to<int64_t>(),
-		(int64_t)0), last_sample);
+		first_sample), last_sample);
 	const uint64_t end_sample = min(max(ceil(end).convert_to<int64_t>(),
-		(int64_t)0), last_sample);
+		first_sample), last_sample);
+
+	// When zoomed far out, draw the busy regions as solid bars straight
+	// from the mip-map instead of resolving every edge
+	if (samples_per_pixel >= SolidFillSamplesPerPixel) {
+		const vector<uint8_t> &levels = owner_->view()->logic_levels(
+			segment, start_sample, end_sample + 1, samples_per_pixel,
+			bit);
+		const vector<uint64_t> &edge_counts =
+			owner_->view()->logic_edge_counts(segment, start_sample,
+				end_sample + 1, samples_per_pixel, bit);
+		paint_levels(p, levels, edge_counts, samples_per_pixel,
+			(start_sample / samples_per_pixel - pixels_offset) +
+			pp.left(), high_offset, low_offset);
+		return;
+	}
 
-	segment->get_subsampled_edges(edges, start_sample, end_sample,
-		samples_per_pixel / Oversampling, base_->index());
+	// The edges of all visible signals are extracted together
+	const vector< pair<int64_t, bool> > &edges =
+		owner_->view()->logic_edges(segment, start_sample, end_sample,
+			samples_per_pixel / Oversampling, bit);
 	assert(edges.size() >= 2);
 
 	// Paint the edges
@@ -266,8 +286,76 @@ void LogicSignal::paint_fore(QPainter &p, const ViewItemPaintParams &pp)
 	}
 }
 
+void LogicSignal::paint_levels(QPainter &p, const vector<uint8_t> &levels,
+	const vector<uint64_t> &edge_counts, double samples_per_pixel,
+	float x_offset, float high_offset, float low_offset)
+{
+	const uint8_t toggling = pv::data::LogicSegment::LevelHigh |
+		pv::data::LogicSegment::LevelLow;
+	assert(edge_counts.empty() || edge_counts.size() == levels.size());
+
+	// The activity is on a log scale, from one edge in a column up to an
+	// edge at every sample. Without edge counts the bars are solid.
+	const double log_max_edges = log(max(samples_per_pixel, 2.0));
+	const auto shade = [&](size_t column) {
+		if (levels[column] != toggling)
+			return 0;
+		if (edge_counts.empty())
+			return ActivityShadeCount - 1;
+		const double activity = log(max(edge_counts[column],
+			(uint64_t)1)) / log_max_edges;
+		return min((int)(activity * ActivityShadeCount),
+			ActivityShadeCount - 1);
+	};
+
+	vector< vector<QRectF> > bars(ActivityShadeCount);
+	vector<QLineF> edge_lines, high_lines, low_lines;
+
+	// Merge the runs of columns in the same state
+	for (size_t i = 0; i < levels.size();) {
+		const uint8_t level = levels[i];
+		const int s = shade(i);
+		size_t j = i + 1;
+		while (j < levels.size() && levels[j] == level &&
+			shade(j) == s)
+			j++;
+
+		const float x0 = x_offset + i, x1 = x_offset + j;
+		if (level == toggling)
+			bars[s].push_back(QRectF(QPointF(x0, high_offset),
+				QPointF(x1, low_offset)));
+		if (level & pv::data::LogicSegment::LevelHigh)
+			high_lines.push_back(QLineF(x0, high_offset,
+				x1, high_offset));
+		if (level & pv::data::LogicSegment::LevelLow)
+			low_lines.push_back(QLineF(x0, low_offset,
+				x1, low_offset));
+		if (i > 0 && levels[i - 1] != level)
+			edge_lines.push_back(QLineF(x0, high_offset,
+				x0, low_offset));
+
+		i = j;
+	}
+
+	p.setPen(Qt::NoPen);
+	for (int s = 0; s < ActivityShadeCount; s++) {
+		QColor colour(EdgeColour);
+		colour.setAlpha(0x40 + (0xFF - 0x40) * (s + 1) /
+			ActivityShadeCount);
+		p.setBrush(colour);
+		p.drawRects(bars[s].data(), bars[s].size());
+	}
+
+	p.setPen(EdgeColour);
+	p.drawLines(edge_lines.data(), edge_lines.size());
+	p.setPen(HighColour);
+	p.drawLines(high_lines.data(), high_lines.size());
+	p.setPen(LowColour);
+	p.drawLines(low_lines.data(), low_lines.size());
+}
+
 void LogicSignal::paint_caps(QPainter &p, QLineF *const lines,
-	vector< pair<int64_t, bool> > &edges, bool level,
+	const vector< pair<int64_t, bool> > &edges, bool level,
 	double samples_per_pixel, double pixels_offset, float x_offset,
 	float y_offset)
 {
@@ -52,6 +52,8 @@ class LogicSignal : public Signal
 
 private:
 	static const float Oversampling;
+	static const double SolidFillSamplesPerPixel;
+	static const int ActivityShadeCount;
 
 	static const QColor EdgeColour;
 	static const QColor HighColour;
@@ -106,8 +108,22 @@ public:
 	virtual void paint_fore(QPainter &p, const ViewItemPaintParams &pp);
 
 private:
+	/**
+	 * Paints the states of the signal in one pixel wide columns, with
+	 * the columns where it toggles drawn as solid bars. The bars are
+	 * shaded by their number of edges, as an activity heatmap.
+	 * @param levels The @c LevelFlags of each column.
+	 * @param edge_counts The number of edges in each column, or empty
+	 * 	if they are not counted, to draw the bars unshaded.
+	 * @param x_offset The position of the first column.
+	 */
+	void paint_levels(QPainter &p, const std::vector<uint8_t> &levels,
+		const std::vector<uint64_t> &edge_counts,
+		double samples_per_pixel, float x_offset,
+		float high_offset, float low_offset);
+
 	void paint_caps(QPainter &p, QLineF *const lines,
-		std::vector< std::pair<int64_t, bool> > &edges,
+		const std::vector< std::pair<int64_t, bool> > &edges,
 		bool level, double samples_per_pixel, double pixels_offset,
 		float x_offset, float y_offset);
 
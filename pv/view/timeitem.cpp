@@ -30,8 +30,8 @@ TimeItem::TimeItem(View &view) :
 
 void TimeItem::drag_by(const QPoint &delta)
 {
-	set_time(view_.offset() + (drag_point_.x() + delta.x() - 0.5) *
-		view_.scale());
+	set_time(view_.snap_to_edge(view_.offset() +
+		(drag_point_.x() + delta.x() - 0.5) * view_.scale()));
 }
 
 } // namespace TraceView
@@ -64,6 +64,8 @@
 
 #ifdef ENABLE_DECODE
 #include "decodetrace.hpp"
+#include "pv/data/decoderstack.hpp"
+#include "pv/data/signalbase.hpp"
 #endif
 
 using boost::shared_lock;
@@ -78,6 +80,7 @@ using std::back_inserter;
 using std::copy_if;
 using std::deque;
 using std::dynamic_pointer_cast;
+using std::find;
 using std::inserter;
 using std::list;
 using std::lock_guard;
@@ -103,6 +106,7 @@ const Timestamp View::MinScale("1e-12");
 
 const int View::MaxScrollValue = INT_MAX / 2;
 const int View::MaxViewAutoUpdateRate = 25; // No more than 25 Hz with sticky scrolling
+const int View::SnapDistance = 8;
 
 const int View::ScaleUnits[3] = {1, 2, 5};
 
@@ -146,6 +150,8 @@ View::View(Session &session, QWidget *parent) :
 	updating_scroll_(false),
 	sticky_scrolling_(false), // Default setting is set in MainWindow::setup_ui()
 	always_zoom_to_fit_(false),
+	current_frame_(0),
+	follow_newest_frame_(true),
 	tick_period_(0),
 	tick_prefix_(pv::util::SIPrefix::yocto),
 	tick_precision_(0),
@@ -177,6 +183,9 @@ View::View(Session &session, QWidget *parent) :
 	connect(this, SIGNAL(hover_point_changed()),
 		this, SLOT(on_hover_point_changed()));
 
+	connect(&session_, SIGNAL(frames_changed()),
+		this, SLOT(frames_updated()));
+
 	connect(&lazy_event_handler_, SIGNAL(timeout()),
 		this, SLOT(process_sticky_events()));
 	lazy_event_handler_.setSingleShot(true);
@@ -235,6 +244,109 @@ void View::add_signal(const shared_ptr<Signal> signal)
 	signals_.insert(signal);
 }
 
+const vector< pair<int64_t, bool> >& View::logic_edges(
+	const shared_ptr<data::LogicSegment> &segment,
+	uint64_t start, uint64_t end, float min_length, int sig_index)
+{
+	LogicEdgeCache &c = logic_edge_cache_;
+
+	const uint64_t sample_count = segment->get_sample_count();
+	if (c.segment.lock() != segment || c.sample_count != sample_count ||
+		c.start != start || c.end != end || c.min_length != min_length ||
+		find(c.sig_indices.begin(), c.sig_indices.end(), sig_index) ==
+			c.sig_indices.end()) {
+		c.segment = segment;
+		c.sample_count = sample_count;
+		c.start = start;
+		c.end = end;
+		c.min_length = min_length;
+		c.sig_indices = logic_sig_indices(segment, sig_index);
+		c.edges.clear();
+		segment->get_subsampled_edges(c.edges, start, end, min_length,
+			c.sig_indices);
+	}
+
+	const auto i = find(c.sig_indices.begin(), c.sig_indices.end(),
+		sig_index);
+	return c.edges[i - c.sig_indices.begin()];
+}
+
+const vector<uint8_t>& View::logic_levels(
+	const shared_ptr<data::LogicSegment> &segment,
+	uint64_t start, uint64_t end, float min_length, int sig_index)
+{
+	return logic_level_cache_.levels[update_logic_level_cache(segment,
+		start, end, min_length, sig_index)];
+}
+
+const vector<uint64_t>& View::logic_edge_counts(
+	const shared_ptr<data::LogicSegment> &segment,
+	uint64_t start, uint64_t end, float min_length, int sig_index)
+{
+	return logic_level_cache_.edge_counts[update_logic_level_cache(segment,
+		start, end, min_length, sig_index)];
+}
+
+size_t View::update_logic_level_cache(
+	const shared_ptr<data::LogicSegment> &segment,
+	uint64_t start, uint64_t end, float min_length, int sig_index)
+{
+	LogicLevelCache &c = logic_level_cache_;
+
+	const uint64_t sample_count = segment->get_sample_count();
+	if (c.segment.lock() != segment || c.sample_count != sample_count ||
+		c.start != start || c.end != end || c.min_length != min_length ||
+		find(c.sig_indices.begin(), c.sig_indices.end(), sig_index) ==
+			c.sig_indices.end()) {
+		c.segment = segment;
+		c.sample_count = sample_count;
+		c.start = start;
+		c.end = end;
+		c.min_length = min_length;
+		c.sig_indices = logic_sig_indices(segment, sig_index);
+		c.levels.clear();
+		segment->get_subsampled_levels(c.levels, start, end, min_length,
+			c.sig_indices);
+
+		// Without the counts of the mip-map the edges would be
+		// searched for one at a time
+		c.edge_counts.clear();
+		if (segment->has_edge_counts())
+			segment->get_edge_counts(c.edge_counts, start, end,
+				min_length, c.sig_indices);
+		else
+			c.edge_counts.resize(c.sig_indices.size());
+	}
+
+	return find(c.sig_indices.begin(), c.sig_indices.end(), sig_index) -
+		c.sig_indices.begin();
+}
+
+vector<int> View::logic_sig_indices(
+	const shared_ptr<data::LogicSegment> &segment, int sig_index) const
+{
+	vector<int> sig_indices;
+
+	// Query all enabled logic signals that show this segment
+	for (const shared_ptr<Signal> &signal : signals_) {
+		const shared_ptr<data::SignalBase> base = signal->base();
+		const shared_ptr<data::Logic> logic = base->logic_data();
+		if (!base->enabled() || !logic ||
+			logic->logic_segment(current_frame_) != segment)
+			continue;
+
+		const int bit = segment->channel_bit(base->index());
+		if (bit >= 0)
+			sig_indices.push_back(bit);
+	}
+
+	if (find(sig_indices.begin(), sig_indices.end(), sig_index) ==
+			sig_indices.end())
+		sig_indices.push_back(sig_index);
+
+	return sig_indices;
+}
+
 #ifdef ENABLE_DECODE
 void View::clear_decode_signals()
 {
@@ -246,6 +358,7 @@ void View::add_decode_signal(shared_ptr<data::SignalBase> signalbase)
 	shared_ptr<DecodeTrace> d(
 		new DecodeTrace(session_, signalbase, decode_traces_.size()));
 	decode_traces_.push_back(d);
+	decode_current_frame();
 }
 
 void View::remove_decode_signal(shared_ptr<data::SignalBase> signalbase)
@@ -491,6 +604,120 @@ void View::zoom_one_to_one()
 	set_zoom(1.0 / session_.get_samplerate(), w / 2);
 }
 
+void View::go_to_edge(bool next)
+{
+	shared_ptr<data::SignalBase> base;
+	shared_ptr<data::Logic> logic;
+	int top = INT_MAX;
+
+	// Use the logic signal under the mouse cursor, or else the topmost
+	// selected one
+	for (const shared_ptr<Signal> &signal : signals_) {
+		const shared_ptr<data::SignalBase> b = signal->base();
+		const shared_ptr<data::Logic> l = b->logic_data();
+		if (!b->enabled() || !l || !l->logic_segment(current_frame_))
+			continue;
+
+		const int y = signal->get_visual_y();
+		const pair<int, int> extents = signal->v_extents();
+		if (hover_point_.y() >= 0 &&
+			hover_point_.y() >= y + extents.first &&
+			hover_point_.y() < y + extents.second) {
+			base = b;
+			logic = l;
+			break;
+		}
+
+		if (signal->selected() && y < top) {
+			base = b;
+			logic = l;
+			top = y;
+		}
+	}
+
+	if (!logic)
+		return;
+
+	const shared_ptr<data::LogicSegment> segment =
+		logic->logic_segment(current_frame_);
+	if (!segment)
+		return;
+
+	const int bit = segment->channel_bit(base->index());
+	if (bit < 0)
+		return;
+
+	double samplerate = segment->samplerate();
+	if (samplerate == 0.0)
+		samplerate = 1.0;
+
+	// Search from the sample nearest to the centre of the view
+	const double time_width = scale_ * viewport_->width();
+	const Timestamp centre = offset_ + time_width / 2;
+	const int64_t sample = max(floor((centre - segment->start_time()) *
+		samplerate + 0.5).convert_to<int64_t>(), (int64_t)0);
+
+	uint64_t edge;
+	if (!(next ? segment->find_next_edge(bit, sample, edge) :
+			segment->find_previous_edge(bit, sample, edge)))
+		return;
+
+	set_scale_offset(scale_, segment->start_time() +
+		Timestamp(edge) / samplerate - time_width / 2);
+}
+
+Timestamp View::snap_to_edge(const Timestamp& time) const
+{
+	Timestamp snapped = time;
+	double best_distance = SnapDistance;
+
+	for (const shared_ptr<Signal> &signal : signals_) {
+		const shared_ptr<data::SignalBase> base = signal->base();
+		const shared_ptr<data::Logic> logic = base->logic_data();
+		if (!base->enabled() || !logic)
+			continue;
+
+		const shared_ptr<data::LogicSegment> segment =
+			logic->logic_segment(current_frame_);
+		if (!segment)
+			continue;
+
+		const int bit = segment->channel_bit(base->index());
+		if (bit < 0)
+			continue;
+
+		double samplerate = segment->samplerate();
+		if (samplerate == 0.0)
+			samplerate = 1.0;
+
+		const int64_t sample = max(floor((time - segment->start_time()) *
+			samplerate).convert_to<int64_t>(), (int64_t)0);
+
+		// Consider the edges on either side of the time
+		uint64_t edges[2];
+		const bool found[2] = {
+			segment->find_previous_edge(bit, sample + 1, edges[0]),
+			segment->find_next_edge(bit, sample, edges[1])
+		};
+
+		for (int i = 0; i < 2; i++) {
+			if (!found[i])
+				continue;
+
+			const Timestamp edge_time = segment->start_time() +
+				Timestamp(edges[i]) / samplerate;
+			const double distance = fabs(
+				((edge_time - time) / scale_).convert_to<double>());
+			if (distance < best_distance) {
+				best_distance = distance;
+				snapped = edge_time;
+			}
+		}
+	}
+
+	return snapped;
+}
+
 void View::set_scale_offset(double scale, const Timestamp& offset)
 {
 	// Disable sticky scrolling / always zoom to fit when acquisition runs
@@ -535,20 +762,25 @@ pair<Timestamp, Timestamp> View::get_time_extents() const
 	boost::optional<Timestamp> left_time, right_time;
 	const set< shared_ptr<SignalData> > visible_data = get_visible_data();
 	for (const shared_ptr<SignalData> d : visible_data) {
-		const vector< shared_ptr<Segment> > segments =
-			d->segments();
-		for (const shared_ptr<Segment> &s : segments) {
-			double samplerate = s->samplerate();
-			samplerate = (samplerate <= 0.0) ? 1.0 : samplerate;
-
-			const Timestamp start_time = s->start_time();
-			left_time = left_time ?
-				min(*left_time, start_time) :
-				                start_time;
-			right_time = right_time ?
-				max(*right_time, start_time + d->max_sample_count() / samplerate) :
-				                 start_time + d->max_sample_count() / samplerate;
-		}
+		const shared_ptr<Segment> s = d->frame_segment(current_frame_);
+		if (!s)
+			continue;
+
+		double samplerate = s->samplerate();
+		samplerate = (samplerate <= 0.0) ? 1.0 : samplerate;
+
+		// In roll mode the oldest samples have been dropped
+		const Timestamp start_time = s->start_time();
+		const Timestamp first_time = start_time +
+			s->get_first_sample() / samplerate;
+		const Timestamp end_time = start_time +
+			s->get_sample_count() / samplerate;
+		left_time = left_time ?
+			min(*left_time, first_time) :
+			                first_time;
+		right_time = right_time ?
+			max(*right_time, end_time) :
+			                 end_time;
 	}
 
 	if (!left_time || !right_time)
@@ -558,6 +790,32 @@ pair<Timestamp, Timestamp> View::get_time_extents() const
 	return make_pair(*left_time, *right_time);
 }
 
+uint64_t View::current_frame() const
+{
+	return current_frame_;
+}
+
+void View::set_current_frame(uint64_t frame)
+{
+	const uint64_t frame_count = session_.frame_count();
+	if (frame_count == 0)
+		return;
+
+	frame = min(max(frame, session_.first_frame()), frame_count - 1);
+	follow_newest_frame_ = (frame == frame_count - 1);
+	if (frame == current_frame_)
+		return;
+
+	// The summaries of each frame are kept, so nothing needs rebuilding
+	current_frame_ = frame;
+	decode_current_frame();
+	frames_changed();
+
+	update_scroll();
+	ruler_->update();
+	viewport_->update();
+}
+
 void View::enable_sticky_scrolling(bool state)
 {
 	sticky_scrolling_ = state;
@@ -600,6 +858,8 @@ void View::show_cursors(bool show)
 	show_cursors_ = show;
 	ruler_->update();
 	viewport_->update();
+
+	time_items_changed();
 }
 
 void View::centre_cursors()
@@ -687,7 +947,7 @@ void View::get_scroll_layout(double &length, Timestamp &offset) const
 {
 	const pair<Timestamp, Timestamp> extents = get_time_extents();
 	length = ((extents.second - extents.first) / scale_).convert_to<double>();
-	offset = offset_ / scale_;
+	offset = (offset_ - extents.first) / scale_;
 }
 
 void View::set_zoom(double scale, int offset)
@@ -796,7 +1056,7 @@ void View::update_scroll()
 	} else {
 		hscrollbar->setRange(0, MaxScrollValue);
 		hscrollbar->setSliderPosition(
-			(offset_ * MaxScrollValue / (scale_ * length)).convert_to<double>());
+			(offset * MaxScrollValue / length).convert_to<double>());
 	}
 
 	updating_scroll_ = false;
@@ -814,6 +1074,27 @@ void View::update_scroll()
 
 	if (scroll_needs_defaults_)
 		set_scroll_default();
+
+	pin_visible_samples();
+}
+
+void View::pin_visible_samples()
+{
+	assert(viewport_);
+
+	const Timestamp end = offset_ + scale_ * viewport_->width();
+
+	// The new pins are taken before the old ones are released, so that
+	// the chunks still in view stay decompressed
+	vector< shared_ptr<data::SegmentPin> > pins;
+	for (const shared_ptr<SignalData> d : get_visible_data()) {
+		const shared_ptr<Segment> s = d->frame_segment(current_frame_);
+		if (s)
+			pins.push_back(s->pin_samples(s->time_to_sample(offset_),
+				s->time_to_sample(end)));
+	}
+
+	visible_sample_pins_.swap(pins);
 }
 
 void View::reset_scroll()
@@ -845,6 +1126,18 @@ void View::set_scroll_default()
 	scroll_needs_defaults_ = !size_finalized_;
 }
 
+void View::decode_current_frame()
+{
+#ifdef ENABLE_DECODE
+	for (const shared_ptr<DecodeTrace> &d : decode_traces_) {
+		const shared_ptr<data::DecoderStack> decoder_stack =
+			d->base()->decoder_stack();
+		if (decoder_stack)
+			decoder_stack->set_frame(current_frame_);
+	}
+#endif
+}
+
 void View::update_layout()
 {
 	scrollarea_.setViewportMargins(
@@ -1003,6 +1296,8 @@ void View::time_item_appearance_changed(bool label, bool content)
 		ruler_->update();
 	if (content)
 		viewport_->update();
+
+	time_items_changed();
 }
 
 void View::extents_changed(bool horz, bool vert)
@@ -1025,14 +1320,16 @@ void View::h_scroll_value_changed(int value)
 		sticky_scrolling_changed(false);
 	}
 
+	// The scroll bar starts at the first sample that is kept
+	const Timestamp first = get_time_extents().first;
 	const int range = scrollarea_.horizontalScrollBar()->maximum();
 	if (range < MaxScrollValue)
-		set_offset(scale_ * value);
+		set_offset(first + scale_ * value);
 	else {
 		double length = 0;
 		Timestamp offset;
 		get_scroll_layout(length, offset);
-		set_offset(scale_ * length * value / MaxScrollValue);
+		set_offset(first + scale_ * length * value / MaxScrollValue);
 	}
 
 	ruler_->update();
@@ -1223,6 +1520,12 @@ void View::capture_state_updated(int state)
 		set_time_unit(util::TimeUnit::Samples);
 
 		trigger_markers_.clear();
+
+		// Follow the newest samples like an oscilloscope roll display
+		if (session_.roll_mode() && !sticky_scrolling_) {
+			sticky_scrolling_ = true;
+			sticky_scrolling_changed(true);
+		}
 	}
 
 	if (state == Session::Stopped) {
@@ -1251,6 +1554,27 @@ void View::data_updated()
 	}
 }
 
+void View::frames_updated()
+{
+	const uint64_t first_frame = session_.first_frame();
+	const uint64_t frame_count = session_.frame_count();
+
+	// Follow the newest frame, or stay on the one shown unless it has
+	// been evicted
+	if (frame_count == 0) {
+		current_frame_ = 0;
+		follow_newest_frame_ = true;
+	} else if (follow_newest_frame_)
+		current_frame_ = frame_count - 1;
+	else
+		current_frame_ = min(max(current_frame_, first_frame),
+			frame_count - 1);
+
+	decode_current_frame();
+	frames_changed();
+	data_updated();
+}
+
 void View::perform_delayed_view_update()
 {
 	if (always_zoom_to_fit_)
@@ -1265,7 +1589,7 @@ void View::perform_delayed_view_update()
 		const QSize areaSize = viewport_->size();
 		length = max(length - areaSize.width(), 0.0);
 
-		set_offset(scale_ * length);
+		set_offset(get_time_extents().first + scale_ * length);
 	}
 
 	determine_time_unit();
@@ -48,6 +48,11 @@ namespace pv {
 
 class Session;
 
+namespace data {
+class LogicSegment;
+class SegmentPin;
+}
+
 namespace views {
 
 namespace TraceView {
@@ -86,6 +91,9 @@ private:
 	static const int MaxScrollValue;
 	static const int MaxViewAutoUpdateRate;
 
+	/// The maximum distance in pixels at which markers snap to edges
+	static const int SnapDistance;
+
 	static const int ScaleUnits[3];
 
 public:
@@ -103,6 +111,37 @@ public:
 
 	virtual void add_signal(const std::shared_ptr<Signal> signal);
 
+	/**
+	 * Returns the edges of one signal of a logic segment for painting.
+	 * The edges of all enabled logic signals of the segment are extracted
+	 * in one pass and kept until they are requested with other parameters.
+	 * @see pv::data::LogicSegment::get_subsampled_edges()
+	 */
+	const std::vector< std::pair<int64_t, bool> >& logic_edges(
+		const std::shared_ptr<data::LogicSegment> &segment,
+		uint64_t start, uint64_t end, float min_length, int sig_index);
+
+	/**
+	 * Returns the levels of one signal of a logic segment in blocks of
+	 * @c min_length samples for painting. Like with @c logic_edges() the
+	 * levels of all enabled logic signals of the segment are summarized
+	 * in one pass.
+	 * @see pv::data::LogicSegment::get_subsampled_levels()
+	 */
+	const std::vector<uint8_t>& logic_levels(
+		const std::shared_ptr<data::LogicSegment> &segment,
+		uint64_t start, uint64_t end, float min_length, int sig_index);
+
+	/**
+	 * Returns the edge counts of one signal in the blocks of
+	 * @c logic_levels(), which are counted together with the levels if
+	 * the segment keeps edge counts. They are empty otherwise.
+	 * @see pv::data::LogicSegment::get_edge_counts()
+	 */
+	const std::vector<uint64_t>& logic_edge_counts(
+		const std::shared_ptr<data::LogicSegment> &segment,
+		uint64_t start, uint64_t end, float min_length, int sig_index);
+
 #ifdef ENABLE_DECODE
 	virtual void clear_decode_signals();
 
@@ -187,6 +226,20 @@ public:
 
 	void zoom_one_to_one();
 
+	/**
+	 * Centres the view on the next or previous edge of the logic signal
+	 * under the mouse cursor, or else of the topmost selected one.
+	 * @param next true for the next edge, false for the previous one.
+	 */
+	void go_to_edge(bool next);
+
+	/**
+	 * Returns the time of the logic signal edge that is nearest to
+	 * @c time if it is less than @c SnapDistance pixels away, or else
+	 * @c time itself.
+	 */
+	pv::util::Timestamp snap_to_edge(const pv::util::Timestamp& time) const;
+
 	/**
 	 * Sets the scale and offset.
 	 * @param scale The new view scale in seconds per pixel.
@@ -199,6 +252,18 @@ public:
 
 	std::pair<pv::util::Timestamp, pv::util::Timestamp> get_time_extents() const;
 
+	/**
+	 * Returns the number of the frame that is shown.
+	 * @see Session::frame_count()
+	 */
+	uint64_t current_frame() const;
+
+	/**
+	 * Shows another frame of the capture. The view follows the newest
+	 * frame while it is the one shown.
+	 */
+	void set_current_frame(uint64_t frame);
+
 	/**
 	 * Enables or disables sticky scrolling, i.e. the view always shows
 	 * the most recent samples when capturing data.
@@ -277,6 +342,12 @@ Q_SIGNALS:
 	/// Emitted when the time_unit changed.
 	void time_unit_changed();
 
+	/// Emitted when the frame shown or the frames held changed.
+	void frames_changed();
+
+	/// Emitted when the cursors or flags moved, or were shown or hidden.
+	void time_items_changed();
+
 public Q_SLOTS:
 	void trigger_event(util::Timestamp location);
 
@@ -299,10 +370,37 @@ private:
 
 	void update_scroll();
 
+	/**
+	 * Returns the signal indices in @c segment of the enabled logic
+	 * signals that show it, including @c sig_index.
+	 */
+	std::vector<int> logic_sig_indices(
+		const std::shared_ptr<data::LogicSegment> &segment,
+		int sig_index) const;
+
+	/**
+	 * Summarizes the logic signals of @c segment for @c logic_levels()
+	 * and @c logic_edge_counts(), unless they are cached already.
+	 * @return The position of @c sig_index in the cache.
+	 */
+	size_t update_logic_level_cache(
+		const std::shared_ptr<data::LogicSegment> &segment,
+		uint64_t start, uint64_t end, float min_length, int sig_index);
+
+	/**
+	 * Keeps the samples in view decompressed while they are shown.
+	 */
+	void pin_visible_samples();
+
 	void reset_scroll();
 
 	void set_scroll_default();
 
+	/**
+	 * Has the decoders decode the frame that is shown.
+	 */
+	void decode_current_frame();
+
 	void update_layout();
 
 	TraceTreeItemOwner* find_prevalent_trace_group(
@@ -337,6 +435,7 @@ private Q_SLOTS:
 	void signals_changed();
 	void capture_state_updated(int state);
 	void data_updated();
+	void frames_updated();
 
 	void perform_delayed_view_update();
 
@@ -387,6 +486,25 @@ private:
 
 	std::unordered_set< std::shared_ptr<Signal> > signals_;
 
+	struct LogicEdgeCache
+	{
+		std::weak_ptr<data::LogicSegment> segment;
+		uint64_t sample_count, start, end;
+		float min_length;
+		std::vector<int> sig_indices;
+		std::vector< std::vector< std::pair<int64_t, bool> > > edges;
+	} logic_edge_cache_;
+
+	struct LogicLevelCache
+	{
+		std::weak_ptr<data::LogicSegment> segment;
+		uint64_t sample_count, start, end;
+		float min_length;
+		std::vector<int> sig_indices;
+		std::vector< std::vector<uint8_t> > levels;
+		std::vector< std::vector<uint64_t> > edge_counts;
+	} logic_level_cache_;
+
 #ifdef ENABLE_DECODE
 	std::vector< std::shared_ptr<DecodeTrace> > decode_traces_;
 #endif
@@ -404,6 +522,11 @@ private:
 	bool always_zoom_to_fit_;
 	QTimer delayed_view_updater_;
 
+	uint64_t current_frame_;
+	bool follow_newest_frame_;
+
+	std::vector< std::shared_ptr<data::SegmentPin> > visible_sample_pins_;
+
 	pv::util::Timestamp tick_period_;
 	pv::util::SIPrefix tick_prefix_;
 	unsigned int tick_precision_;
@@ -0,0 +1,185 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <QStringList>
+
+#include "measurementspanel.hpp"
+
+#include <pv/data/analog.hpp>
+#include <pv/data/analogsegment.hpp>
+#include <pv/data/signalbase.hpp>
+#include <pv/session.hpp>
+#include <pv/util.hpp>
+#include <pv/view/analogsignal.hpp>
+#include <pv/view/cursorpair.hpp>
+#include <pv/view/view.hpp>
+
+using std::find_if;
+using std::max;
+using std::min;
+using std::shared_ptr;
+using std::vector;
+
+using pv::data::AnalogMeasurements;
+using pv::data::AnalogSegment;
+using pv::util::SIPrefix;
+using pv::util::Timestamp;
+using pv::views::TraceView::AnalogSignal;
+using pv::views::TraceView::View;
+
+namespace pv {
+namespace views {
+
+namespace trace {
+
+const int MeasurementsPanel::UpdateDelay = 100;
+
+MeasurementsPanel::MeasurementsPanel(Session &session, View *view,
+	QWidget *parent) :
+	QTreeWidget(parent),
+	view_(view),
+	worker_([this]() { measurements_ready(); })
+{
+	setRootIsDecorated(false);
+	setHeaderLabels(QStringList() << tr("Signal") << tr("Samples") <<
+		tr("Min") << tr("Max") << tr("Peak-to-peak") << tr("Mean") <<
+		tr("RMS") << tr("AC RMS") << tr("Energy") << tr("Rise time") <<
+		tr("Fall time") << tr("Frequency"));
+
+	connect(this, SIGNAL(measurements_ready()),
+		this, SLOT(show_measurements()));
+
+	update_timer_.setSingleShot(true);
+	update_timer_.setInterval(UpdateDelay);
+	connect(&update_timer_, SIGNAL(timeout()),
+		this, SLOT(update_measurements()));
+
+	connect(view_, SIGNAL(time_items_changed()),
+		this, SLOT(schedule_update()));
+	connect(view_, SIGNAL(frames_changed()),
+		this, SLOT(schedule_update()));
+	connect(&session, SIGNAL(signals_changed()),
+		this, SLOT(schedule_update()));
+	connect(&session, SIGNAL(summaries_updated()),
+		this, SLOT(schedule_update()));
+}
+
+void MeasurementsPanel::showEvent(QShowEvent *event)
+{
+	QTreeWidget::showEvent(event);
+	update_measurements();
+}
+
+void MeasurementsPanel::schedule_update()
+{
+	if (isVisible() && !update_timer_.isActive())
+		update_timer_.start();
+}
+
+void MeasurementsPanel::update_measurements()
+{
+	const bool cursors = view_->cursors_shown();
+	const Timestamp start = view_->cursors()->first()->time();
+	const Timestamp end = view_->cursors()->second()->time();
+
+	vector<AnalogMeasurements> ranges;
+	for (const shared_ptr<AnalogSignal> &signal :
+		view_->list_by_type<AnalogSignal>()) {
+		if (!signal->enabled())
+			continue;
+
+		AnalogMeasurements m;
+		m.segment = signal->base()->analog_data()->analog_segment(
+			view_->current_frame());
+		if (!m.segment)
+			continue;
+
+		m.start = cursors ?
+			m.segment->time_to_sample(min(start, end)) : 0;
+		m.end = cursors ?
+			m.segment->time_to_sample(max(start, end)) :
+			m.segment->get_sample_count();
+		ranges.push_back(m);
+	}
+
+	worker_.measure(ranges);
+}
+
+void MeasurementsPanel::show_measurements()
+{
+	clear();
+
+	const vector<AnalogMeasurements> results = worker_.results();
+
+	for (const shared_ptr<AnalogSignal> &signal :
+		view_->list_by_type<AnalogSignal>()) {
+		if (!signal->enabled())
+			continue;
+
+		const shared_ptr<AnalogSegment> segment =
+			signal->base()->analog_data()->analog_segment(
+				view_->current_frame());
+		const auto m = find_if(results.begin(), results.end(),
+			[&](const AnalogMeasurements &r) {
+				return r.segment == segment;
+			});
+		if (!segment || m == results.end())
+			continue;
+
+		const AnalogSegment::Statistics &st = m->statistics;
+
+		// The energy a signal in volts delivers into 1 ohm
+		const double energy = st.sum_sq / max(1.0, segment->samplerate());
+
+		QTreeWidgetItem *const item = new QTreeWidgetItem(this);
+		item->setText(0, signal->base()->name());
+		item->setForeground(0, signal->base()->colour());
+		item->setText(1, QString::number(st.count));
+
+		if (st.count > 0) {
+			item->setText(2, format_value(st.min, "V"));
+			item->setText(3, format_value(st.max, "V"));
+			item->setText(4, format_value(st.peak_to_peak(), "V"));
+			item->setText(5, format_value(st.mean(), "V"));
+			item->setText(6, format_value(st.rms(), "V"));
+			item->setText(7, format_value(st.ac_rms(), "V"));
+			item->setText(8, format_value(energy,
+				QString::fromUtf8("V²s")));
+		}
+
+		if (m->rising_edges > 0)
+			item->setText(9, format_value(m->rise_time, "s"));
+		if (m->falling_edges > 0)
+			item->setText(10, format_value(m->fall_time, "s"));
+		if (m->frequency > 0)
+			item->setText(11, format_value(m->frequency, "Hz"));
+	}
+}
+
+QString MeasurementsPanel::format_value(double value, const QString &unit)
+{
+	return util::format_time_si(value, SIPrefix::unspecified, 4,
+		unit, false);
+}
+
+} // namespace trace
+} // namespace views
+} // namespace pv
@@ -0,0 +1,87 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_VIEWS_TRACE_MEASUREMENTSPANEL_HPP
+#define PULSEVIEW_PV_VIEWS_TRACE_MEASUREMENTSPANEL_HPP
+
+#include <QTimer>
+#include <QTreeWidget>
+
+#include <pv/data/measurementworker.hpp>
+
+namespace pv {
+
+class Session;
+
+namespace views {
+
+namespace TraceView {
+class View;
+}
+
+namespace trace {
+
+/**
+ * Lists the measurements of each analog signal, between the cursors if
+ * they are shown, or else over the whole frame. They are taken by a
+ * @c data::MeasurementWorker, so that long captures do not stall the
+ * user interface.
+ */
+class MeasurementsPanel : public QTreeWidget
+{
+	Q_OBJECT
+
+private:
+	/// The delay in ms that collects bursts of changes into one update
+	static const int UpdateDelay;
+
+public:
+	MeasurementsPanel(Session &session, TraceView::View *view,
+		QWidget *parent = nullptr);
+
+protected:
+	void showEvent(QShowEvent *event);
+
+Q_SIGNALS:
+	/// Emitted from the worker thread when the measurements are ready
+	void measurements_ready();
+
+private Q_SLOTS:
+	void schedule_update();
+
+	void update_measurements();
+
+	void show_measurements();
+
+private:
+	static QString format_value(double value, const QString &unit);
+
+private:
+	TraceView::View *const view_;
+
+	QTimer update_timer_;
+
+	data::MeasurementWorker worker_;
+};
+
+} // namespace trace
+} // namespace views
+} // namespace pv
+
+#endif // PULSEVIEW_PV_VIEWS_TRACE_MEASUREMENTSPANEL_HPP
@@ -42,7 +42,12 @@ StandardBar::StandardBar(Session &session, QWidget *parent,
 	action_view_zoom_out_(new QAction(this)),
 	action_view_zoom_fit_(new QAction(this)),
 	action_view_zoom_one_to_one_(new QAction(this)),
-	action_view_show_cursors_(new QAction(this))
+	action_view_show_cursors_(new QAction(this)),
+	action_view_previous_edge_(new QAction(this)),
+	action_view_next_edge_(new QAction(this)),
+	frame_selector_(new QSpinBox(this)),
+	frame_selector_action_(nullptr),
+	updating_frame_selector_(false)
 {
 	setObjectName(QString::fromUtf8("StandardBar"));
 
@@ -85,9 +90,28 @@ StandardBar::StandardBar(Session &session, QWidget *parent,
 		this, SLOT(on_actionViewShowCursors_triggered()));
 	action_view_show_cursors_->setText(tr("Show &Cursors"));
 
+	action_view_previous_edge_->setText(tr("&Previous Edge"));
+	action_view_previous_edge_->setIcon(QIcon::fromTheme("go-previous"));
+	action_view_previous_edge_->setShortcut(QKeySequence(Qt::Key_Comma));
+	connect(action_view_previous_edge_, SIGNAL(triggered(bool)),
+		this, SLOT(on_actionViewPreviousEdge_triggered()));
+
+	action_view_next_edge_->setText(tr("&Next Edge"));
+	action_view_next_edge_->setIcon(QIcon::fromTheme("go-next"));
+	action_view_next_edge_->setShortcut(QKeySequence(Qt::Key_Period));
+	connect(action_view_next_edge_, SIGNAL(triggered(bool)),
+		this, SLOT(on_actionViewNextEdge_triggered()));
+
 	connect(view_, SIGNAL(always_zoom_to_fit_changed(bool)),
 		this, SLOT(on_always_zoom_to_fit_changed(bool)));
 
+	frame_selector_->setToolTip(tr("Frame"));
+	frame_selector_->setPrefix(tr("Frame "));
+	connect(frame_selector_, SIGNAL(valueChanged(int)),
+		this, SLOT(on_frame_selected(int)));
+	connect(view_, SIGNAL(frames_changed()),
+		this, SLOT(on_frames_changed()));
+
 	if (add_default_widgets)
 		add_toolbar_widgets();
 }
@@ -106,6 +130,13 @@ void StandardBar::add_toolbar_widgets()
 	addAction(action_view_zoom_one_to_one_);
 	addSeparator();
 	addAction(action_view_show_cursors_);
+	addSeparator();
+	addAction(action_view_previous_edge_);
+	addAction(action_view_next_edge_);
+	addSeparator();
+	frame_selector_action_ = addWidget(frame_selector_);
+
+	on_frames_changed();
 }
 
 QAction* StandardBar::action_view_zoom_in() const
@@ -133,6 +164,16 @@ QAction* StandardBar::action_view_show_cursors() const
 	return action_view_show_cursors_;
 }
 
+QAction* StandardBar::action_view_previous_edge() const
+{
+	return action_view_previous_edge_;
+}
+
+QAction* StandardBar::action_view_next_edge() const
+{
+	return action_view_next_edge_;
+}
+
 void StandardBar::on_actionViewZoomIn_triggered()
 {
 	view_->zoom(1);
@@ -162,11 +203,43 @@ void StandardBar::on_actionViewShowCursors_triggered()
 	view_->show_cursors(show);
 }
 
+void StandardBar::on_actionViewPreviousEdge_triggered()
+{
+	view_->go_to_edge(false);
+}
+
+void StandardBar::on_actionViewNextEdge_triggered()
+{
+	view_->go_to_edge(true);
+}
+
 void StandardBar::on_always_zoom_to_fit_changed(bool state)
 {
 	action_view_zoom_fit_->setChecked(state);
 }
 
+void StandardBar::on_frame_selected(int value)
+{
+	if (!updating_frame_selector_)
+		view_->set_current_frame(value - 1);
+}
+
+void StandardBar::on_frames_changed()
+{
+	const uint64_t frame_count = session_.frame_count();
+
+	// Only captures of more than one frame need the selector
+	if (frame_selector_action_)
+		frame_selector_action_->setVisible(frame_count > 1);
+
+	updating_frame_selector_ = true;
+	frame_selector_->setRange(session_.first_frame() + 1,
+		frame_count ? frame_count : 1);
+	frame_selector_->setSuffix(tr(" of %1").arg(frame_count));
+	frame_selector_->setValue(view_->current_frame() + 1);
+	updating_frame_selector_ = false;
+}
+
 } // namespace trace
 } // namespace views
 } // namespace pv
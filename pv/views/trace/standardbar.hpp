@@ -24,6 +24,7 @@
 #include <stdint.h>
 
 #include <QAction>
+#include <QSpinBox>
 #include <QToolBar>
 #include <QWidget>
 
@@ -57,6 +58,8 @@ public:
 	QAction* action_view_zoom_fit() const;
 	QAction* action_view_zoom_one_to_one() const;
 	QAction* action_view_show_cursors() const;
+	QAction* action_view_previous_edge() const;
+	QAction* action_view_next_edge() const;
 
 protected:
 	virtual void add_toolbar_widgets();
@@ -69,6 +72,13 @@ protected:
 	QAction *const action_view_zoom_fit_;
 	QAction *const action_view_zoom_one_to_one_;
 	QAction *const action_view_show_cursors_;
+	QAction *const action_view_previous_edge_;
+	QAction *const action_view_next_edge_;
+
+	/// Steps between the frames of a capture, numbered from 1
+	QSpinBox *const frame_selector_;
+	QAction *frame_selector_action_;
+	bool updating_frame_selector_;
 
 protected Q_SLOTS:
 	void on_actionViewZoomIn_triggered();
@@ -81,7 +91,15 @@ protected Q_SLOTS:
 
 	void on_actionViewShowCursors_triggered();
 
+	void on_actionViewPreviousEdge_triggered();
+
+	void on_actionViewNextEdge_triggered();
+
 	void on_always_zoom_to_fit_changed(bool state);
+
+	void on_frame_selected(int value);
+
+	void on_frames_changed();
 };
 
 } // namespace trace
@@ -43,6 +43,8 @@ ViewBase::ViewBase(Session &session, QWidget *parent) :
 		this, SLOT(capture_state_updated(int)));
 	connect(&session_, SIGNAL(data_received()),
 		this, SLOT(data_updated()));
+	connect(&session_, SIGNAL(summaries_updated()),
+		this, SLOT(data_updated()));
 	connect(&session_, SIGNAL(frame_ended()),
 		this, SLOT(data_updated()));
 }
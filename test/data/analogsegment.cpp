@@ -21,12 +21,160 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
 #include <boost/test/unit_test.hpp>
 
 #include <pv/data/analogsegment.hpp>
 
 using pv::data::AnalogSegment;
 
+BOOST_AUTO_TEST_SUITE(CompactStorageTest)
+
+BOOST_AUTO_TEST_CASE(FitsFormat)
+{
+	AnalogSegment s(1, 0, std::shared_ptr<pv::data::ChunkAllocator>(),
+		AnalogSegment::Int16Format, 0.5f, 1.0f);
+
+	const float in_range[] = {1.0f, 1.25f, -2.0f, 1.0f + 0.5f * 32767};
+	BOOST_CHECK(s.fits_format(in_range, 4, 1));
+
+	const float above[] = {1.0f + 0.5f * 40000};
+	BOOST_CHECK(!s.fits_format(above, 1, 1));
+
+	const float below[] = {1.0f - 0.5f * 40000};
+	BOOST_CHECK(!s.fits_format(below, 1, 1));
+
+	const float nan[] = {NAN};
+	BOOST_CHECK(!s.fits_format(nan, 1, 1));
+
+	// Only every other sample belongs to the segment
+	const float interleaved[] = {1.0f, 1e9f, 2.0f, 1e9f};
+	BOOST_CHECK(s.fits_format(interleaved, 2, 2));
+
+	AnalogSegment f(1);
+	BOOST_CHECK(f.fits_format(above, 1, 1));
+}
+
+BOOST_AUTO_TEST_CASE(StoreAsFloats)
+{
+	// The codes span more than one chunk, and the change to floats falls
+	// into a chunk that is being filled and has been allocated ahead
+	const uint64_t num_samples = 700001;
+	AnalogSegment s(1, 2 * num_samples,
+		std::shared_ptr<pv::data::ChunkAllocator>(),
+		AnalogSegment::Int16Format, 0.5f, 1.0f);
+
+	std::vector<float> expected(2 * num_samples);
+	double sum = 0.0;
+	for (uint64_t i = 0; i < 2 * num_samples; i++) {
+		expected[i] = (i < num_samples) ?
+			1.0f + 0.5f * (int)(i % 101) : 1e5f + 0.1f * (i % 37);
+		sum += expected[i];
+	}
+
+	s.append_interleaved_samples(expected.data(), num_samples, 1);
+	const float *const floats = expected.data() + num_samples;
+	BOOST_REQUIRE(!s.fits_format(floats, num_samples, 1));
+
+	s.store_as_floats();
+	BOOST_CHECK(s.format() == AnalogSegment::FloatFormat);
+	BOOST_CHECK(s.fits_format(floats, num_samples, 1));
+	s.append_interleaved_samples(floats, num_samples, 1);
+	BOOST_REQUIRE(s.get_sample_count() == 2 * num_samples);
+
+	while (s.update_summaries());
+
+	uint64_t mismatches = 0;
+	for (uint64_t i = 0; i < 2 * num_samples;) {
+		const pv::data::SegmentDataView view =
+			s.get_samples(i, 2 * num_samples);
+		BOOST_REQUIRE(view.sample_count() > 0);
+		const float *const samples = (const float*)view.data();
+		for (uint64_t j = 0; j < view.sample_count(); j++)
+			if (samples[j] != expected[i + j])
+				mismatches++;
+		i += view.sample_count();
+	}
+	BOOST_CHECK_EQUAL(mismatches, 0);
+
+	// The blocks that straddle the change are summarized from both
+	const AnalogSegment::Statistics st =
+		s.get_statistics(0, 2 * num_samples);
+	BOOST_CHECK_EQUAL(st.count, 2 * num_samples);
+	BOOST_CHECK_EQUAL(st.min, 1.0f);
+	BOOST_CHECK_EQUAL(st.max, 1e5f + 3.6f);
+	BOOST_CHECK_CLOSE(st.sum, sum, 1e-6);
+
+	const AnalogSegment::Statistics edge =
+		s.get_statistics(num_samples - 3, num_samples + 3);
+	BOOST_CHECK_EQUAL(edge.min,
+		*std::min_element(&expected[num_samples - 3],
+			&expected[num_samples + 3]));
+	BOOST_CHECK_EQUAL(edge.max,
+		*std::max_element(&expected[num_samples - 3],
+			&expected[num_samples + 3]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(EnvelopeColumnsTest)
+
+BOOST_AUTO_TEST_CASE(SpikesStayInTheirColumns)
+{
+	AnalogSegment s(1);
+
+	const unsigned int num_samples = 4096;
+	float data[num_samples];
+	for (unsigned int i = 0; i < num_samples; i++)
+		data[i] = 0.0f;
+	data[1000] = 10.0f;
+	data[3000] = -10.0f;
+
+	const auto check_columns = [&](unsigned int sample_count) {
+		const unsigned int width = 14;
+		const double samples_per_column = 300.0;
+		AnalogSegment::EnvelopeSample columns[width];
+		s.get_envelope_columns(columns, width, 0.0, samples_per_column);
+
+		for (unsigned int i = 0; i < width; i++) {
+			const unsigned int s0 = i * samples_per_column;
+			const unsigned int s1 = std::min((unsigned int)
+				((i + 1) * samples_per_column), sample_count);
+			if (s0 >= sample_count) {
+				BOOST_CHECK(columns[i].min > columns[i].max);
+				continue;
+			}
+
+			float lo = data[s0], hi = data[s0];
+			for (unsigned int j = s0; j < s1; j++) {
+				lo = std::min(lo, data[j]);
+				hi = std::max(hi, data[j]);
+			}
+
+			BOOST_CHECK_EQUAL(columns[i].min, lo);
+			BOOST_CHECK_EQUAL(columns[i].max, hi);
+		}
+	};
+
+	s.append_interleaved_samples(data, num_samples / 2, 1);
+	while (s.update_summaries());
+	check_columns(num_samples / 2);
+
+	// The samples that have not been summarized yet are read too
+	s.append_interleaved_samples(data + num_samples / 2,
+		num_samples / 2, 1);
+	check_columns(num_samples);
+
+	while (s.update_summaries());
+	check_columns(num_samples);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 #if 0
 BOOST_AUTO_TEST_SUITE(AnalogSegmentTest)
 
@@ -0,0 +1,86 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/channelpacker.hpp>
+
+using pv::data::ChannelPacker;
+using std::vector;
+
+BOOST_AUTO_TEST_SUITE(ChannelPackerTest)
+
+BOOST_AUTO_TEST_CASE(RoundTrip)
+{
+	const uint64_t sample_count = 1000;
+	const vector<unsigned int> channels = {0, 3, 9, 10, 17, 31, 40, 63};
+	const ChannelPacker packer(channels, 8);
+
+	BOOST_CHECK_EQUAL(packer.unit_size(), 1);
+	BOOST_CHECK_EQUAL(packer.packed_index(17), 4);
+	BOOST_CHECK_EQUAL(packer.packed_index(18), -1);
+
+	vector<uint8_t> data(sample_count * 8);
+	for (uint8_t &d : data)
+		d = rand();
+
+	vector<uint8_t> packed(sample_count);
+	packer.pack(data.data(), sample_count, packed.data());
+
+	for (uint64_t i = 0; i < sample_count; i++)
+		for (unsigned int j = 0; j < channels.size(); j++)
+			BOOST_CHECK_EQUAL((packed[i] >> j) & 1,
+				(data[i * 8 + channels[j] / 8] >>
+					(channels[j] % 8)) & 1);
+
+	// Only the kept channels survive the round trip
+	vector<uint8_t> unpacked(data.size());
+	packer.unpack(packed.data(), sample_count, unpacked.data());
+
+	uint64_t mask = 0;
+	for (unsigned int c : channels)
+		mask |= 1ULL << c;
+	for (uint64_t i = 0; i < data.size(); i++)
+		BOOST_CHECK_EQUAL(unpacked[i],
+			data[i] & (uint8_t)(mask >> ((i % 8) * 8)));
+}
+
+BOOST_AUTO_TEST_CASE(Wide)
+{
+	// More than 8 channels need more than one byte
+	vector<unsigned int> channels;
+	for (unsigned int c = 0; c < 24; c += 2)
+		channels.push_back(c);
+	const ChannelPacker packer(channels, 3);
+
+	BOOST_CHECK_EQUAL(packer.unit_size(), 2);
+
+	const uint8_t sample[3] = {0xff, 0x00, 0x55};
+	uint8_t packed[2];
+	packer.pack(sample, 1, packed);
+	BOOST_CHECK_EQUAL(packed[0], 0x0f);
+	BOOST_CHECK_EQUAL(packed[1], 0x0f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
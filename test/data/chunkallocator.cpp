@@ -0,0 +1,163 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <QDir>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <pv/data/chunkallocator.hpp>
+
+using pv::data::ChunkAllocator;
+using std::make_shared;
+using std::shared_ptr;
+using std::vector;
+
+namespace {
+
+const uint64_t ChunkSize = 1024 * 1024;
+
+int spill_file_count(const QString &directory)
+{
+	return QDir(directory).entryList(QStringList("*.spill"),
+		QDir::Files).size();
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(ChunkAllocatorTest)
+
+BOOST_AUTO_TEST_CASE(RamBudget)
+{
+	const shared_ptr<ChunkAllocator> allocator =
+		make_shared<ChunkAllocator>();
+	allocator->set_ram_budget(3 * ChunkSize);
+
+	vector< shared_ptr<uint8_t> > chunks;
+	for (int i = 0; i < 3; i++) {
+		chunks.push_back(allocator->allocate_resident(ChunkSize));
+		BOOST_REQUIRE(chunks.back());
+		BOOST_CHECK(!ChunkAllocator::is_spilled(chunks.back()));
+	}
+	BOOST_CHECK_EQUAL(allocator->resident_bytes(), 3 * ChunkSize);
+
+	// The budget is used up
+	BOOST_CHECK(!allocator->allocate_resident(ChunkSize));
+	BOOST_CHECK(!allocator->allocate_resident(1));
+	BOOST_CHECK_EQUAL(allocator->resident_bytes(), 3 * ChunkSize);
+
+	// Releasing a chunk makes room for another
+	chunks.pop_back();
+	BOOST_CHECK_EQUAL(allocator->resident_bytes(), 2 * ChunkSize);
+	BOOST_CHECK(allocator->allocate_resident(ChunkSize));
+
+	// Without a budget there is no limit
+	allocator->set_ram_budget(0);
+	chunks.push_back(allocator->allocate_resident(ChunkSize));
+	chunks.push_back(allocator->allocate_resident(ChunkSize));
+	BOOST_CHECK(chunks.back());
+	BOOST_CHECK_EQUAL(allocator->resident_bytes(), 4 * ChunkSize);
+
+	chunks.clear();
+	BOOST_CHECK_EQUAL(allocator->resident_bytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(SpillRegionReuse)
+{
+	QTemporaryDir directory;
+	BOOST_REQUIRE(directory.isValid());
+
+	const shared_ptr<ChunkAllocator> allocator =
+		make_shared<ChunkAllocator>();
+	allocator->set_spill_directory(directory.path());
+
+	vector< shared_ptr<uint8_t> > chunks;
+	for (int i = 0; i < 4; i++) {
+		chunks.push_back(allocator->allocate_spilled(ChunkSize));
+		BOOST_REQUIRE(chunks.back());
+		BOOST_CHECK(ChunkAllocator::is_spilled(chunks.back()));
+		memset(chunks.back().get(), i, ChunkSize);
+	}
+	BOOST_CHECK_EQUAL(allocator->spilled_bytes(), 4 * ChunkSize);
+	BOOST_CHECK_EQUAL(spill_file_count(directory.path()), 1);
+
+	// The chunks are carved out of one mapped region
+	for (int i = 1; i < 4; i++)
+		BOOST_CHECK(chunks[i].get() == chunks[i - 1].get() + ChunkSize);
+
+	// A released chunk is handed out again, and the others keep their
+	// contents
+	uint8_t *const released = chunks[1].get();
+	chunks[1].reset();
+	BOOST_CHECK_EQUAL(allocator->spilled_bytes(), 3 * ChunkSize);
+	chunks[1] = allocator->allocate_spilled(ChunkSize);
+	BOOST_CHECK(chunks[1].get() == released);
+
+	BOOST_CHECK_EQUAL(chunks[0].get()[ChunkSize - 1], 0);
+	BOOST_CHECK_EQUAL(chunks[2].get()[0], 2);
+	BOOST_CHECK_EQUAL(chunks[3].get()[ChunkSize - 1], 3);
+
+	chunks.clear();
+	BOOST_CHECK_EQUAL(allocator->spilled_bytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(SpillDirectoryChange)
+{
+	QTemporaryDir first, second;
+	BOOST_REQUIRE(first.isValid());
+	BOOST_REQUIRE(second.isValid());
+
+	const shared_ptr<ChunkAllocator> allocator =
+		make_shared<ChunkAllocator>();
+	allocator->set_spill_directory(first.path());
+
+	shared_ptr<uint8_t> a = allocator->allocate_spilled(ChunkSize);
+	BOOST_REQUIRE(a);
+	BOOST_CHECK_EQUAL(spill_file_count(first.path()), 1);
+
+	// The old file stays in use while it holds chunks
+	allocator->set_spill_directory(second.path());
+	BOOST_CHECK(allocator->spill_directory() == second.path());
+	shared_ptr<uint8_t> b = allocator->allocate_spilled(ChunkSize);
+	BOOST_REQUIRE(b);
+	BOOST_CHECK_EQUAL(spill_file_count(first.path()), 1);
+	BOOST_CHECK_EQUAL(spill_file_count(second.path()), 0);
+
+	// Once its last chunk is released, the old file is removed and the
+	// next chunk goes to the new directory
+	a.reset();
+	BOOST_CHECK_EQUAL(spill_file_count(first.path()), 1);
+	b.reset();
+	BOOST_CHECK_EQUAL(spill_file_count(first.path()), 0);
+
+	shared_ptr<uint8_t> c = allocator->allocate_spilled(ChunkSize);
+	BOOST_REQUIRE(c);
+	BOOST_CHECK_EQUAL(spill_file_count(first.path()), 0);
+	BOOST_CHECK_EQUAL(spill_file_count(second.path()), 1);
+	memset(c.get(), 0xff, ChunkSize);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,110 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <stdexcept>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/decode/message.hpp>
+
+using pv::data::decode::MessageReader;
+using std::runtime_error;
+using std::string;
+
+namespace decode = pv::data::decode;
+
+BOOST_AUTO_TEST_SUITE(MessageTest)
+
+BOOST_AUTO_TEST_CASE(RoundTrip)
+{
+	int fds[2];
+	BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	// Two messages are written at once, as the worker does
+	string m;
+	decode::begin_message(m, decode::AnnotationMessage);
+	decode::put_u32(m, 3);
+	decode::put_u64(m, 0x123456789abcdefULL);
+	decode::put_string(m, "SDA");
+	decode::put_string(m, "");
+	decode::end_message(m, 0);
+
+	const size_t offset = m.size();
+	decode::begin_message(m, decode::DoneMessage);
+	decode::end_message(m, offset);
+
+	decode::write_messages(fds[0], m);
+	close(fds[0]);
+
+	uint32_t type;
+	string payload;
+	BOOST_REQUIRE(decode::read_message(fds[1], type, payload));
+	BOOST_CHECK_EQUAL(type, (uint32_t)decode::AnnotationMessage);
+
+	MessageReader r(payload);
+	BOOST_CHECK_EQUAL(r.u32(), 3);
+	BOOST_CHECK_EQUAL(r.u64(), 0x123456789abcdefULL);
+	BOOST_CHECK_EQUAL(r.str(), "SDA");
+	BOOST_CHECK_EQUAL(r.str(), "");
+	BOOST_CHECK_THROW(r.u32(), runtime_error);
+
+	BOOST_REQUIRE(decode::read_message(fds[1], type, payload));
+	BOOST_CHECK_EQUAL(type, (uint32_t)decode::DoneMessage);
+	BOOST_CHECK(payload.empty());
+
+	// The stream ends between messages
+	BOOST_CHECK(!decode::read_message(fds[1], type, payload));
+	close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(Malformed)
+{
+	// A string that claims to be longer than the payload
+	string payload;
+	decode::put_u32(payload, 100);
+	payload += "abc";
+
+	MessageReader r(payload);
+	BOOST_CHECK_THROW(r.str(), runtime_error);
+
+	// A stream that ends inside a message
+	int fds[2];
+	BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	string m;
+	decode::begin_message(m, decode::SamplesMessage);
+	decode::put_u64(m, 42);
+	decode::end_message(m, 0);
+	m.resize(m.size() - 4);
+
+	decode::write_messages(fds[0], m);
+	close(fds[0]);
+
+	uint32_t type;
+	BOOST_CHECK_THROW(decode::read_message(fds[1], type, payload),
+		runtime_error);
+	close(fds[1]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
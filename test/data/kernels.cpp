@@ -0,0 +1,432 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/kernels.hpp>
+
+using std::vector;
+
+namespace kernels = pv::data::kernels;
+
+namespace {
+
+// The reference loops, as previously used by LogicSegment
+void reference_transitions(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size, const uint8_t *prev_sample)
+{
+	vector<uint8_t> prev(prev_sample, prev_sample + unit_size);
+	for (uint64_t b = 0; b < block_count; b++) {
+		for (unsigned int j = 0; j < unit_size; j++)
+			dest[j] = 0;
+		for (unsigned int i = 0; i < kernels::BlockLength; i++) {
+			for (unsigned int j = 0; j < unit_size; j++) {
+				dest[j] |= prev[j] ^ src[j];
+				prev[j] = src[j];
+			}
+			src += unit_size;
+		}
+		dest += unit_size;
+	}
+}
+
+void reference_reduce(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		for (unsigned int j = 0; j < unit_size; j++)
+			dest[j] = 0;
+		for (unsigned int i = 0; i < kernels::BlockLength; i++) {
+			for (unsigned int j = 0; j < unit_size; j++)
+				dest[j] |= src[j];
+			src += unit_size;
+		}
+		dest += unit_size;
+	}
+}
+
+void reference_any_low(const uint8_t *src, uint8_t *dest,
+	uint64_t block_count, unsigned int unit_size)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		for (unsigned int j = 0; j < unit_size; j++)
+			dest[j] = 0;
+		for (unsigned int i = 0; i < kernels::BlockLength; i++) {
+			for (unsigned int j = 0; j < unit_size; j++)
+				dest[j] |= ~src[j];
+			src += unit_size;
+		}
+		dest += unit_size;
+	}
+}
+
+// Pulses of random length on every channel, like a real capture
+vector<uint8_t> make_pulses(uint64_t sample_count, unsigned int unit_size)
+{
+	vector<uint8_t> data(sample_count * unit_size);
+	vector<uint8_t> sample(unit_size, 0);
+
+	for (uint64_t i = 0; i < sample_count; i++) {
+		if (rand() % 64 == 0)
+			sample[rand() % unit_size] ^= 1 << (rand() % 8);
+		for (unsigned int j = 0; j < unit_size; j++)
+			data[i * unit_size + j] = sample[j];
+	}
+
+	return data;
+}
+
+// The reference loops, as previously used by AnalogSegment
+void reference_envelope_minmax(const float *src, float *dest,
+	uint64_t block_count)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		dest[0] = *std::min_element(src, src + kernels::BlockLength);
+		dest[1] = *std::max_element(src, src + kernels::BlockLength);
+		src += kernels::BlockLength;
+		dest += 2;
+	}
+}
+
+void reference_envelope_reduce(const float *src, float *dest,
+	uint64_t block_count)
+{
+	for (uint64_t b = 0; b < block_count; b++) {
+		dest[0] = src[0];
+		dest[1] = src[1];
+		for (unsigned int i = 1; i < kernels::BlockLength; i++) {
+			dest[0] = std::min(dest[0], src[2 * i]);
+			dest[1] = std::max(dest[1], src[2 * i + 1]);
+		}
+		src += 2 * kernels::BlockLength;
+		dest += 2;
+	}
+}
+
+// A noisy sine wave
+vector<float> make_wave(uint64_t sample_count)
+{
+	vector<float> data(sample_count);
+
+	for (uint64_t i = 0; i < sample_count; i++)
+		data[i] = sinf(i * 0.01f) + (rand() % 1000) / 5000.0f;
+
+	return data;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(KernelsTest)
+
+BOOST_AUTO_TEST_CASE(Transitions)
+{
+	const uint64_t block_count = 67;
+
+	for (unsigned int unit_size = 1; unit_size <= 8; unit_size++) {
+		const vector<uint8_t> data = make_pulses(
+			block_count * kernels::BlockLength, unit_size);
+		const vector<uint8_t> prev(unit_size, 0xA5);
+
+		vector<uint8_t> expected(block_count * unit_size);
+		vector<uint8_t> actual(block_count * unit_size);
+
+		reference_transitions(data.data(), expected.data(),
+			block_count, unit_size, prev.data());
+		kernels::logic_mipmap_transitions(data.data(), actual.data(),
+			block_count, unit_size, prev.data());
+
+		BOOST_CHECK(expected == actual);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Reduce)
+{
+	const uint64_t block_count = 67;
+
+	for (unsigned int unit_size = 1; unit_size <= 8; unit_size++) {
+		const vector<uint8_t> data = make_pulses(
+			block_count * kernels::BlockLength, unit_size);
+
+		vector<uint8_t> expected(block_count * unit_size);
+		vector<uint8_t> actual(block_count * unit_size);
+
+		reference_reduce(data.data(), expected.data(),
+			block_count, unit_size);
+		kernels::logic_mipmap_reduce(data.data(), actual.data(),
+			block_count, unit_size);
+
+		BOOST_CHECK(expected == actual);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(AnyLow)
+{
+	const uint64_t block_count = 67;
+
+	for (unsigned int unit_size = 1; unit_size <= 8; unit_size++) {
+		const vector<uint8_t> data = make_pulses(
+			block_count * kernels::BlockLength, unit_size);
+
+		vector<uint8_t> expected(block_count * unit_size);
+		vector<uint8_t> actual(block_count * unit_size);
+
+		reference_any_low(data.data(), expected.data(),
+			block_count, unit_size);
+		kernels::logic_mipmap_any_low(data.data(), actual.data(),
+			block_count, unit_size);
+
+		BOOST_CHECK(expected == actual);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(EdgeCountsReduce)
+{
+	const uint64_t block_count = 5;
+	const unsigned int channel_count = 3;
+
+	vector<uint8_t> counts(block_count * kernels::BlockLength *
+		channel_count);
+	for (uint64_t i = 0; i < counts.size(); i++)
+		counts[i] = (i % channel_count == 2) ? 255 : rand() % 17;
+
+	vector<uint8_t> sums(block_count * channel_count);
+	kernels::logic_edge_counts_reduce(counts.data(), sums.data(),
+		block_count, channel_count);
+
+	for (uint64_t b = 0; b < block_count; b++)
+		for (unsigned int c = 0; c < channel_count; c++) {
+			unsigned int sum = 0;
+			for (unsigned int i = 0; i < kernels::BlockLength; i++)
+				sum += counts[(b * kernels::BlockLength + i) *
+					channel_count + c];
+
+			BOOST_CHECK_EQUAL(sums[b * channel_count + c],
+				std::min(sum, 255U));
+		}
+}
+
+BOOST_AUTO_TEST_CASE(EnvelopeMinMax)
+{
+	// Odd counts exercise the scalar tails of the vector kernels
+	for (uint64_t block_count = 1; block_count <= 9; block_count++) {
+		const vector<float> data = make_wave(
+			block_count * kernels::BlockLength);
+
+		vector<float> expected(block_count * 2);
+		vector<float> actual(block_count * 2);
+
+		reference_envelope_minmax(data.data(), expected.data(),
+			block_count);
+		kernels::analog_envelope_minmax(data.data(), actual.data(),
+			block_count);
+
+		BOOST_CHECK(expected == actual);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(EnvelopeReduce)
+{
+	for (uint64_t block_count = 1; block_count <= 9; block_count++) {
+		const vector<float> data = make_wave(
+			block_count * kernels::BlockLength * 2);
+
+		vector<float> expected(block_count * 2);
+		vector<float> actual(block_count * 2);
+
+		reference_envelope_reduce(data.data(), expected.data(),
+			block_count);
+		kernels::analog_envelope_reduce(data.data(), actual.data(),
+			block_count);
+
+		BOOST_CHECK(expected == actual);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(BlockSums)
+{
+	for (uint64_t block_count = 1; block_count <= 9; block_count++) {
+		const vector<float> data = make_wave(
+			block_count * kernels::BlockLength);
+
+		vector<double> sums(block_count * 2);
+		kernels::analog_block_sums(data.data(), sums.data(),
+			block_count);
+
+		for (uint64_t b = 0; b < block_count; b++) {
+			double sum = 0, sum_sq = 0;
+			for (unsigned int i = 0; i < kernels::BlockLength; i++) {
+				const double v = data[b * kernels::BlockLength + i];
+				sum += v;
+				sum_sq += v * v;
+			}
+
+			BOOST_CHECK_CLOSE(sums[2 * b], sum, 1e-9);
+			BOOST_CHECK_CLOSE(sums[2 * b + 1], sum_sq, 1e-9);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(SumsReduce)
+{
+	for (uint64_t block_count = 1; block_count <= 9; block_count++) {
+		vector<double> data(block_count * kernels::BlockLength * 2);
+		for (uint64_t i = 0; i < data.size(); i++)
+			data[i] = (rand() % 1000) / 8.0;
+
+		vector<double> sums(block_count * 2);
+		kernels::analog_sums_reduce(data.data(), sums.data(),
+			block_count);
+
+		for (uint64_t b = 0; b < block_count; b++) {
+			double sum = 0, sum_sq = 0;
+			for (unsigned int i = 0; i < kernels::BlockLength; i++) {
+				sum += data[(b * kernels::BlockLength + i) * 2];
+				sum_sq += data[(b * kernels::BlockLength + i) * 2 + 1];
+			}
+
+			BOOST_CHECK_EQUAL(sums[2 * b], sum);
+			BOOST_CHECK_EQUAL(sums[2 * b + 1], sum_sq);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Deinterleave)
+{
+	// Odd sample counts exercise the scalar tails of the vector kernels
+	const uint64_t sample_count = 1031;
+
+	for (unsigned int channel_count = 1; channel_count <= 12;
+			channel_count++) {
+		const vector<float> data = make_wave(sample_count * channel_count);
+
+		vector< vector<float> > channels(channel_count,
+			vector<float>(sample_count));
+		vector<float*> dest;
+		for (vector<float> &channel : channels)
+			dest.push_back(channel.data());
+
+		kernels::analog_deinterleave(data.data(), dest.data(),
+			channel_count, sample_count);
+
+		for (unsigned int c = 0; c < channel_count; c++)
+			for (uint64_t i = 0; i < sample_count; i++)
+				BOOST_REQUIRE_EQUAL(channels[c][i],
+					data[i * channel_count + c]);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Int16Conversion)
+{
+	const float scale = 0.0025f, offset = -1.5f;
+	const uint64_t sample_count = 1031;
+
+	vector<float> data(sample_count);
+	for (uint64_t i = 0; i < sample_count; i++)
+		data[i] = ((int)(rand() % 4096) - 2048) * scale + offset;
+
+	// Values outside the integer range saturate
+	data[3] = 1e6f;
+	data[4] = -1e6f;
+
+	vector<int16_t> codes(sample_count);
+	vector<float> actual(sample_count);
+
+	kernels::analog_float_to_int16(data.data(), codes.data(),
+		sample_count, scale, offset);
+	kernels::analog_int16_to_float(codes.data(), actual.data(),
+		sample_count, scale, offset);
+
+	BOOST_CHECK_EQUAL(codes[3], INT16_MAX);
+	BOOST_CHECK_EQUAL(codes[4], INT16_MIN);
+
+	for (uint64_t i = 0; i < sample_count; i++)
+		if (i != 3 && i != 4)
+			BOOST_REQUIRE_SMALL(actual[i] - data[i], scale / 100);
+}
+
+BOOST_AUTO_TEST_CASE(Throughput)
+{
+	typedef std::chrono::steady_clock clock;
+	typedef std::chrono::duration<double> seconds;
+
+	const uint64_t block_count = 1 << 18;
+	const unsigned int unit_sizes[] = {1, 2, 3, 4, 8};
+
+	for (unsigned int unit_size : unit_sizes) {
+		const vector<uint8_t> data = make_pulses(
+			block_count * kernels::BlockLength, unit_size);
+		const vector<uint8_t> prev(unit_size, 0);
+		vector<uint8_t> expected(block_count * unit_size);
+		vector<uint8_t> actual(block_count * unit_size);
+
+		clock::time_point t = clock::now();
+		reference_transitions(data.data(), expected.data(),
+			block_count, unit_size, prev.data());
+		const seconds reference = clock::now() - t;
+
+		t = clock::now();
+		kernels::logic_mipmap_transitions(data.data(), actual.data(),
+			block_count, unit_size, prev.data());
+		const seconds simd = clock::now() - t;
+
+		const double megabytes = data.size() / 1e6;
+		BOOST_TEST_MESSAGE("unit_size " << unit_size <<
+			": reference " << megabytes / reference.count() << " MB/s" <<
+			", kernel " << megabytes / simd.count() << " MB/s");
+
+		BOOST_CHECK(expected == actual);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(EnvelopeThroughput)
+{
+	typedef std::chrono::steady_clock clock;
+	typedef std::chrono::duration<double> seconds;
+
+	const uint64_t block_count = 1 << 18;
+	const vector<float> data = make_wave(block_count * kernels::BlockLength);
+	vector<float> expected(block_count * 2);
+	vector<float> actual(block_count * 2);
+
+	clock::time_point t = clock::now();
+	reference_envelope_minmax(data.data(), expected.data(), block_count);
+	const seconds reference = clock::now() - t;
+
+	t = clock::now();
+	kernels::analog_envelope_minmax(data.data(), actual.data(),
+		block_count);
+	const seconds simd = clock::now() - t;
+
+	const double megasamples = data.size() / 1e6;
+	BOOST_TEST_MESSAGE("envelope: reference " <<
+		megasamples / reference.count() << " MS/s, kernel " <<
+		megasamples / simd.count() << " MS/s");
+
+	BOOST_CHECK(expected == actual);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
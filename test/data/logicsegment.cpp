@@ -20,12 +20,30 @@
 #include <extdef.h>
 
 #include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
 
 #include <boost/test/unit_test.hpp>
 
+#include <pv/data/channelpacker.hpp>
 #include <pv/data/logicsegment.hpp>
 
+#include <libsigrokcxx/libsigrokcxx.hpp>
+
+using pv::data::ChannelPacker;
 using pv::data::LogicSegment;
+using pv::data::SegmentDataView;
+using pv::data::SegmentPin;
+using std::dynamic_pointer_cast;
+using std::max;
+using std::make_pair;
+using std::min;
+using std::mt19937;
+using std::reverse;
+using std::shared_ptr;
 using std::vector;
 
 // Dummy, remove again when unit tests are fixed.
@@ -36,6 +54,476 @@ BOOST_AUTO_TEST_CASE(DummyTestCase)
 }
 BOOST_AUTO_TEST_SUITE_END()
 
+namespace {
+
+const unsigned int StorageUnitSize = 2;
+
+shared_ptr<sigrok::Logic> make_logic(vector<uint8_t> &data)
+{
+	static const shared_ptr<sigrok::Context> context =
+		sigrok::Context::create();
+	return dynamic_pointer_cast<sigrok::Logic>(
+		context->create_logic_packet(data.data(), data.size(),
+			StorageUnitSize)->payload());
+}
+
+/**
+ * Sparse samples in which the low channels change more often than the
+ * high ones, and channel 15 never does.
+ */
+vector<uint8_t> make_sparse_samples(uint64_t sample_count)
+{
+	mt19937 rng(1);
+	vector<uint8_t> data(sample_count * StorageUnitSize);
+	uint16_t value = 0;
+	for (uint64_t i = 0; i < sample_count; i++) {
+		for (unsigned int bit = 0; bit < 15; bit++)
+			if (rng() % (64 << bit) == 0)
+				value ^= 1 << bit;
+		memcpy(&data[i * StorageUnitSize], &value, StorageUnitSize);
+	}
+	return data;
+}
+
+/**
+ * Appends the samples in packets of random length, as they come from a
+ * device.
+ */
+void append_samples(LogicSegment &s, const vector<uint8_t> &data,
+	uint64_t first_packet)
+{
+	mt19937 rng(2);
+	for (uint64_t i = first_packet * StorageUnitSize; i < data.size();) {
+		const uint64_t length = min((uint64_t)data.size() - i,
+			(uint64_t)(1 + rng() % 5000) * StorageUnitSize);
+		vector<uint8_t> packet(data.begin() + i,
+			data.begin() + i + length);
+		s.append_payload(make_logic(packet));
+		i += length;
+	}
+
+	while (s.update_summaries());
+}
+
+/**
+ * Returns whether a signal changes at a sample, counting from the second
+ * sample on.
+ */
+bool is_edge(const vector<uint8_t> &data, int sig, uint64_t sample)
+{
+	if (sample == 0)
+		return false;
+
+	uint16_t a, b;
+	memcpy(&a, &data[(sample - 1) * StorageUnitSize], StorageUnitSize);
+	memcpy(&b, &data[sample * StorageUnitSize], StorageUnitSize);
+	return ((a ^ b) >> sig) & 1;
+}
+
+/**
+ * Returns the edges of a signal from @c start up to but not including
+ * @c end.
+ */
+vector<uint64_t> find_edges(const vector<uint8_t> &data, int sig,
+	uint64_t start, uint64_t end)
+{
+	vector<uint64_t> edges;
+	for (uint64_t i = max(start, (uint64_t)1); i < end; i++)
+		if (is_edge(data, sig, i))
+			edges.push_back(i);
+	return edges;
+}
+
+/**
+ * Walks the edges of a signal forwards from @c start with
+ * LogicSegment::find_next_edge().
+ */
+vector<uint64_t> walk_next_edges(const LogicSegment &s, int sig,
+	uint64_t start)
+{
+	vector<uint64_t> edges;
+	for (uint64_t edge; s.find_next_edge(sig, start, edge); start = edge)
+		edges.push_back(edge);
+	return edges;
+}
+
+/**
+ * Walks the edges of a signal backwards from @c end with
+ * LogicSegment::find_previous_edge(), and returns them in order.
+ */
+vector<uint64_t> walk_previous_edges(const LogicSegment &s, int sig,
+	uint64_t end)
+{
+	vector<uint64_t> edges;
+	for (uint64_t edge; s.find_previous_edge(sig, end, edge); end = edge)
+		edges.push_back(edge);
+	reverse(edges.begin(), edges.end());
+	return edges;
+}
+
+struct SparseSegments
+{
+	SparseSegments() :
+		data(make_sparse_samples(300000)),
+		first(data.begin(), data.begin() + 100 * StorageUnitSize),
+		raw(make_logic(first), 1000, 0, LogicSegment::RawStorage),
+		transitions(make_logic(first), 1000, 0,
+			LogicSegment::TransitionStorage)
+	{
+		append_samples(raw, data, 100);
+		append_samples(transitions, data, 100);
+	}
+
+	vector<uint8_t> data;
+	vector<uint8_t> first;
+	LogicSegment raw;
+	LogicSegment transitions;
+};
+
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(TransitionStorageTest, SparseSegments)
+
+BOOST_AUTO_TEST_CASE(TransitionCount)
+{
+	const uint64_t sample_count = data.size() / StorageUnitSize;
+	BOOST_REQUIRE_EQUAL(transitions.get_sample_count(), sample_count);
+
+	// The first sample is always stored
+	uint64_t count = 1;
+	for (uint64_t i = 1; i < sample_count; i++)
+		if (memcmp(&data[i * StorageUnitSize],
+			&data[(i - 1) * StorageUnitSize], StorageUnitSize) != 0)
+			count++;
+
+	BOOST_CHECK_EQUAL(transitions.get_transition_count(), count);
+	BOOST_CHECK(transitions.memory_usage().samples < data.size() / 2);
+}
+
+BOOST_AUTO_TEST_CASE(Samples)
+{
+	const uint64_t sample_count = data.size() / StorageUnitSize;
+
+	for (uint64_t start : {0ULL, 1ULL, 12345ULL, 299990ULL}) {
+		for (uint64_t i = start; i < sample_count;) {
+			const SegmentDataView v = transitions.get_samples(i,
+				sample_count);
+			BOOST_REQUIRE(v.sample_count() > 0);
+			BOOST_REQUIRE(memcmp(v.data(), &data[i * StorageUnitSize],
+				v.size()) == 0);
+			i += v.sample_count();
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Edges)
+{
+	const uint64_t end = data.size() / StorageUnitSize - 1;
+
+	// At full resolution both storage modes give the exact edges
+	for (int sig : {0, 3, 9, 15}) {
+		vector<LogicSegment::EdgePair> raw_edges, transition_edges;
+		raw.get_subsampled_edges(raw_edges, 7, end, 1, sig);
+		transitions.get_subsampled_edges(transition_edges, 7, end, 1,
+			sig);
+		BOOST_CHECK(raw_edges == transition_edges);
+	}
+
+	vector< vector<LogicSegment::EdgePair> > raw_edges, transition_edges;
+	const vector<int> sigs = {1, 2, 15};
+	raw.get_subsampled_edges(raw_edges, 0, end, 1, sigs);
+	transitions.get_subsampled_edges(transition_edges, 0, end, 1, sigs);
+	BOOST_CHECK(raw_edges == transition_edges);
+}
+
+BOOST_AUTO_TEST_CASE(Levels)
+{
+	const uint64_t end = data.size() / StorageUnitSize;
+
+	for (float min_length : {1.0f, 7.5f, 300.0f, 20000.0f}) {
+		for (int sig : {0, 6, 15}) {
+			vector<uint8_t> raw_levels, transition_levels;
+			raw.get_subsampled_levels(raw_levels, 3, end,
+				min_length, sig);
+			transitions.get_subsampled_levels(transition_levels, 3,
+				end, min_length, sig);
+			BOOST_CHECK(raw_levels == transition_levels);
+		}
+	}
+
+	// All signals at once give the same levels as one at a time
+	const vector<int> sigs = {15, 0, 6};
+	for (LogicSegment *s : {&raw, &transitions}) {
+		vector< vector<uint8_t> > batched;
+		s->get_subsampled_levels(batched, 3, end, 300.0f, sigs);
+		BOOST_REQUIRE_EQUAL(batched.size(), sigs.size());
+		for (size_t i = 0; i < sigs.size(); i++) {
+			vector<uint8_t> single;
+			s->get_subsampled_levels(single, 3, end, 300.0f,
+				sigs[i]);
+			BOOST_CHECK(batched[i] == single);
+		}
+	}
+
+	// Channel 15 is low throughout
+	vector<uint8_t> levels;
+	transitions.get_subsampled_levels(levels, 0, end, 1000, 15);
+	for (uint8_t level : levels)
+		BOOST_CHECK_EQUAL(level, LogicSegment::LevelLow);
+}
+
+BOOST_AUTO_TEST_CASE(EdgeSearch)
+{
+	const uint64_t sample_count = data.size() / StorageUnitSize;
+
+	for (int sig : {0, 3, 9, 14, 15}) {
+		const vector<uint64_t> edges = find_edges(data, sig, 0,
+			sample_count);
+		BOOST_CHECK(walk_next_edges(raw, sig, 0) == edges);
+		BOOST_CHECK(walk_next_edges(transitions, sig, 0) == edges);
+		BOOST_CHECK(walk_previous_edges(raw, sig, sample_count) ==
+			edges);
+		BOOST_CHECK(walk_previous_edges(transitions, sig,
+			sample_count) == edges);
+
+		// Start at block boundaries, on edges and past the end
+		for (uint64_t sample : {0ULL, 1ULL, 15ULL, 16ULL, 255ULL,
+				4096ULL, 65536ULL, 299999ULL, 300000ULL,
+				400000ULL}) {
+			const vector<uint64_t> after = find_edges(data, sig,
+				sample + 1, sample_count);
+			const vector<uint64_t> before = find_edges(data, sig, 0,
+				min(sample, sample_count));
+
+			for (const LogicSegment *s : {&raw, &transitions}) {
+				uint64_t edge = 0;
+				BOOST_CHECK_EQUAL(s->find_next_edge(sig, sample,
+					edge), !after.empty());
+				if (!after.empty())
+					BOOST_CHECK_EQUAL(edge, after.front());
+
+				BOOST_CHECK_EQUAL(s->find_previous_edge(sig, sample,
+					edge), !before.empty());
+				if (!before.empty())
+					BOOST_CHECK_EQUAL(edge, before.back());
+			}
+		}
+
+		for (const auto &range : {make_pair(0ULL, 300000ULL),
+				make_pair(1ULL, 16ULL), make_pair(17ULL, 70000ULL),
+				make_pair(65536ULL, 65537ULL)}) {
+			const uint64_t count = find_edges(data, sig, range.first,
+				range.second).size();
+			BOOST_CHECK_EQUAL(raw.get_edge_count(sig, range.first,
+				range.second), count);
+			BOOST_CHECK_EQUAL(transitions.get_edge_count(sig,
+				range.first, range.second), count);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(EdgeSearchTest)
+
+BOOST_AUTO_TEST_CASE(Append)
+{
+	const vector<uint8_t> data = make_sparse_samples(200000);
+	vector<uint8_t> first(data.begin(), data.begin() +
+		100000 * StorageUnitSize);
+	LogicSegment s(make_logic(first), 1000, 0, LogicSegment::RawStorage);
+	while (s.update_summaries());
+
+	BOOST_CHECK(walk_next_edges(s, 2, 0) ==
+		find_edges(data, 2, 0, 100000));
+
+	// The samples that have not been summarized yet are searched too
+	vector<uint8_t> rest(data.begin() + 100000 * StorageUnitSize,
+		data.end());
+	s.append_payload(make_logic(rest));
+
+	const vector<uint64_t> edges = find_edges(data, 2, 0, 200000);
+	BOOST_CHECK(walk_next_edges(s, 2, 0) == edges);
+	BOOST_CHECK(walk_previous_edges(s, 2, 200000) == edges);
+
+	while (s.update_summaries());
+	BOOST_CHECK(walk_next_edges(s, 2, 0) == edges);
+	BOOST_CHECK(walk_previous_edges(s, 2, 200000) == edges);
+}
+
+BOOST_AUTO_TEST_CASE(DropBefore)
+{
+	const uint64_t SampleCount = 1500000;
+	const vector<uint8_t> data = make_sparse_samples(SampleCount);
+	vector<uint8_t> first(data.begin(), data.begin() +
+		100 * StorageUnitSize);
+	LogicSegment s(make_logic(first), 1000, 0, LogicSegment::RawStorage);
+	s.set_retention(600000);
+	append_samples(s, data, 100);
+
+	const uint64_t first_sample = s.get_first_sample();
+	BOOST_REQUIRE(first_sample > 0);
+
+	// The edge into the first sample held is not found, as its
+	// predecessor has been dropped
+	for (int sig : {0, 5, 10}) {
+		const vector<uint64_t> edges = find_edges(data, sig,
+			first_sample + 1, SampleCount);
+		BOOST_CHECK(walk_next_edges(s, sig, 0) == edges);
+		BOOST_CHECK(walk_previous_edges(s, sig, SampleCount) ==
+			edges);
+		BOOST_CHECK_EQUAL(s.get_edge_count(sig, 0, SampleCount),
+			edges.size());
+
+		uint64_t edge;
+		BOOST_CHECK(!s.find_previous_edge(sig, first_sample + 1,
+			edge));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(EdgeCounts)
+{
+	const uint64_t SampleCount = 1500000;
+
+	// Channel 15 toggles at every sample for a while, so that the counts
+	// of its blocks saturate
+	vector<uint8_t> data = make_sparse_samples(SampleCount);
+	for (uint64_t i = 1000000; i < 1020000; i += 2)
+		data[i * StorageUnitSize + 1] |= 0x80;
+
+	vector<uint8_t> first(data.begin(), data.begin() +
+		100 * StorageUnitSize);
+	LogicSegment s(make_logic(first), 1000, 0, LogicSegment::RawStorage,
+		shared_ptr<pv::data::ChunkAllocator>(),
+		shared_ptr<const ChannelPacker>(), true);
+	s.set_retention(600000);
+	append_samples(s, data, 100);
+
+	const uint64_t first_sample = s.get_first_sample();
+	BOOST_REQUIRE(first_sample > 0);
+
+	mt19937 rng(3);
+	for (int sig : {0, 5, 15}) {
+		BOOST_CHECK_EQUAL(s.get_edge_count(sig, 0, SampleCount),
+			find_edges(data, sig, first_sample + 1,
+				SampleCount).size());
+
+		for (int i = 0; i < 50; i++) {
+			uint64_t start = first_sample +
+				rng() % (SampleCount - first_sample);
+			uint64_t end = first_sample +
+				rng() % (SampleCount - first_sample);
+			if (start > end)
+				std::swap(start, end);
+
+			BOOST_CHECK_EQUAL(s.get_edge_count(sig, start, end),
+				find_edges(data, sig, max(start,
+					first_sample + 1), end).size());
+		}
+	}
+
+	// The counts of the blocks agree with the edge searches, except
+	// that saturated blocks count an edge at every sample
+	const vector<int> sigs = {5, 15};
+	const float block_length = 4096.0f;
+	vector< vector<uint64_t> > counts;
+	s.get_edge_counts(counts, first_sample, SampleCount, block_length,
+		sigs);
+	BOOST_REQUIRE_EQUAL(counts.size(), sigs.size());
+	for (size_t i = 0; i < sigs.size(); i++) {
+		uint64_t index = first_sample;
+		for (size_t j = 0; j < counts[i].size(); j++) {
+			const uint64_t end = min(SampleCount,
+				first_sample + (uint64_t)((j + 1) * block_length));
+			const uint64_t exact = s.get_edge_count(sigs[i],
+				index, end);
+			if (sigs[i] == 15) {
+				BOOST_CHECK(counts[i][j] >= exact);
+				BOOST_CHECK(counts[i][j] <= end - index);
+			} else
+				BOOST_CHECK_EQUAL(counts[i][j], exact);
+			index = end;
+		}
+		BOOST_CHECK_EQUAL(index, SampleCount);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(ChannelBitTest)
+
+BOOST_AUTO_TEST_CASE(Repacked)
+{
+	// Channel 12 goes high half way through
+	vector<uint8_t> data(100 * StorageUnitSize, 0);
+	for (unsigned int i = 50; i < 100; i++)
+		data[i * StorageUnitSize + 1] = 0x10;
+
+	const shared_ptr<const ChannelPacker> packer(
+		new ChannelPacker({1, 5, 12}, StorageUnitSize));
+	LogicSegment packed(make_logic(data), 1000, 0,
+		LogicSegment::RawStorage, shared_ptr<pv::data::ChunkAllocator>(),
+		packer);
+	LogicSegment raw(make_logic(data), 1000);
+
+	BOOST_CHECK_EQUAL(packed.channel_bit(5), 1);
+	BOOST_CHECK_EQUAL(packed.channel_bit(12), 2);
+	BOOST_CHECK_EQUAL(packed.channel_bit(3), -1);
+	BOOST_CHECK_EQUAL(raw.channel_bit(12), 12);
+	BOOST_CHECK_EQUAL(raw.channel_bit(16), -1);
+
+	// Both segments find the edge through their own bit of the channel
+	uint64_t edge = 0;
+	BOOST_CHECK(packed.find_next_edge(packed.channel_bit(12), 0, edge));
+	BOOST_CHECK_EQUAL(edge, 50);
+	edge = 0;
+	BOOST_CHECK(raw.find_next_edge(raw.channel_bit(12), 0, edge));
+	BOOST_CHECK_EQUAL(edge, 50);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(CompressedChunkTest)
+
+BOOST_AUTO_TEST_CASE(PinnedChunks)
+{
+	// Samples that change rarely compress well
+	const uint64_t SampleCount = 6000000;
+	vector<uint8_t> data(SampleCount * StorageUnitSize);
+	for (uint64_t i = 0; i < SampleCount; i++) {
+		const uint16_t value = i >> 12;
+		memcpy(&data[i * StorageUnitSize], &value, StorageUnitSize);
+	}
+
+	vector<uint8_t> first(data.begin(), data.begin() +
+		100 * StorageUnitSize);
+	LogicSegment s(make_logic(first), 1000, 0, LogicSegment::RawStorage);
+	append_samples(s, data, 100);
+	BOOST_REQUIRE(s.memory_usage().compressed > 0);
+
+	// The samples read back from the compressed chunks are unchanged
+	for (int sig : {0, 4, 11}) {
+		BOOST_CHECK(walk_next_edges(s, sig, 0) ==
+			find_edges(data, sig, 0, SampleCount));
+
+		vector<LogicSegment::EdgePair> edges;
+		s.get_subsampled_edges(edges, 0, SampleCount - 1, 1, sig);
+		BOOST_CHECK_EQUAL(edges.size(),
+			find_edges(data, sig, 1, SampleCount - 1).size() + 2);
+	}
+
+	// A pinned chunk stays decompressed however many others are read
+	const shared_ptr<SegmentPin> pin = s.pin_samples(1000, 2000);
+	const uint8_t *const pinned = s.get_samples(1000, 2000).data();
+	for (uint64_t i = 0; i < SampleCount; i += 100000)
+		BOOST_CHECK(!s.get_samples(i, i + 1).empty());
+	BOOST_CHECK(s.get_samples(1000, 2000).data() == pinned);
+	BOOST_CHECK(memcmp(pinned, &data[1000 * StorageUnitSize],
+		1000 * StorageUnitSize) == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 #if 0
 BOOST_AUTO_TEST_SUITE(LogicSegmentTest)
 
@@ -0,0 +1,128 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <extdef.h>
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/analogsegment.hpp>
+#include <pv/data/measurementworker.hpp>
+
+using std::atomic;
+using std::make_shared;
+using std::shared_ptr;
+using std::vector;
+
+using pv::data::AnalogMeasurements;
+using pv::data::AnalogSegment;
+using pv::data::MeasurementWorker;
+
+namespace {
+
+// A trapezoid wave from -0.5 to 1.5 with a period of 1000 samples, which
+// rises over 100 samples and falls over 50
+shared_ptr<AnalogSegment> make_trapezoid(uint64_t sample_count)
+{
+	vector<float> data(sample_count);
+	for (uint64_t i = 0; i < sample_count; i++) {
+		const uint64_t phase = (i + 300) % 1000;
+		float x = 0.0f;
+		if (phase < 100)
+			x = phase / 100.0f;
+		else if (phase < 500)
+			x = 1.0f;
+		else if (phase < 550)
+			x = 1.0f - (phase - 500) / 50.0f;
+		data[i] = 2.0f * x - 0.5f;
+	}
+
+	const shared_ptr<AnalogSegment> segment =
+		make_shared<AnalogSegment>(1000000);
+	segment->append_interleaved_samples(data.data(), sample_count, 1);
+	while (segment->update_summaries());
+
+	return segment;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(MeasurementWorkerTest)
+
+BOOST_AUTO_TEST_CASE(Trapezoid)
+{
+	AnalogMeasurements m;
+	m.segment = make_trapezoid(1000000);
+	m.start = 12345;
+	m.end = 1000000 - 777;
+
+	atomic<bool> interrupt(false);
+	BOOST_REQUIRE(MeasurementWorker::measure_range(m, interrupt));
+
+	BOOST_CHECK_EQUAL(m.statistics.count, m.end - m.start);
+	BOOST_CHECK_EQUAL(m.statistics.min, -0.5f);
+	BOOST_CHECK_EQUAL(m.statistics.max, 1.5f);
+	BOOST_CHECK_CLOSE(m.statistics.peak_to_peak(), 2.0, 1e-6);
+
+	// 10% to 90% of the swings, at 1 MHz
+	BOOST_CHECK_CLOSE(m.rise_time, 80e-6, 0.1);
+	BOOST_CHECK_CLOSE(m.fall_time, 40e-6, 0.1);
+	BOOST_CHECK_CLOSE(m.frequency, 1000.0, 0.01);
+	BOOST_CHECK(m.rising_edges >= 985 && m.rising_edges <= 988);
+}
+
+BOOST_AUTO_TEST_CASE(Flat)
+{
+	const float value = 0.25f;
+	const shared_ptr<AnalogSegment> segment =
+		make_shared<AnalogSegment>(1000);
+	const vector<float> data(10000, value);
+	segment->append_interleaved_samples(data.data(), data.size(), 1);
+
+	AnalogMeasurements m;
+	m.segment = segment;
+	m.start = 0;
+	m.end = data.size();
+
+	atomic<bool> interrupt(false);
+	BOOST_REQUIRE(MeasurementWorker::measure_range(m, interrupt));
+
+	BOOST_CHECK_EQUAL(m.statistics.peak_to_peak(), 0.0);
+	BOOST_CHECK_CLOSE(m.statistics.mean(), value, 1e-6);
+	BOOST_CHECK_EQUAL(m.rising_edges, 0u);
+	BOOST_CHECK_EQUAL(m.frequency, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(Interrupted)
+{
+	AnalogMeasurements m;
+	m.segment = make_trapezoid(100000);
+	m.start = 0;
+	m.end = 100000;
+
+	atomic<bool> interrupt(true);
+	BOOST_CHECK(!MeasurementWorker::measure_range(m, interrupt));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/pagedarray.hpp>
+
+using pv::data::PagedArray;
+
+BOOST_AUTO_TEST_SUITE(PagedArrayTest)
+
+BOOST_AUTO_TEST_CASE(DropKeepsIndices)
+{
+	const uint64_t length = 1000000;
+
+	for (unsigned int entry_size : {1u, 3u, 8u}) {
+		PagedArray a(entry_size);
+		a.reserve(length);
+		BOOST_REQUIRE(a.capacity() >= length);
+
+		// Fill the array page by page
+		for (uint64_t i = 0; i < length;) {
+			const uint64_t count = a.contiguous_entries(i);
+			BOOST_REQUIRE(count > 0);
+			uint8_t *dest = a.entry(i);
+			for (uint64_t j = 0; j < count; j++, i++)
+				memset(dest + j * entry_size, (uint8_t)(i * 7),
+					entry_size);
+		}
+
+		const uint64_t memory = a.memory_usage();
+		a.drop_before(length / 2);
+		BOOST_CHECK(a.first() <= length / 2);
+		BOOST_CHECK(a.first() > 0);
+		BOOST_CHECK(a.memory_usage() < memory);
+
+		// The entries that are still held are unchanged
+		for (uint64_t i = a.first(); i < length; i++)
+			BOOST_REQUIRE_EQUAL(a.entry(i)[entry_size - 1],
+				(uint8_t)(i * 7));
+
+		// Growing again keeps the dropped pages freed
+		a.reserve(length * 2);
+		BOOST_CHECK(a.capacity() >= length * 2);
+		BOOST_CHECK_EQUAL(a.entry(length - 1)[0],
+			(uint8_t)((length - 1) * 7));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(HeldPageOutlivesDrop)
+{
+	PagedArray a(4);
+	a.reserve(a.contiguous_entries(0) * 2);
+	memset(a.entry(0), 0x5A, 4);
+
+	const std::shared_ptr<const uint8_t> page = a.page(0);
+	BOOST_CHECK(page.get() == a.entry(0));
+
+	// The held page stays valid after the array lets go of it
+	const uint64_t memory = a.memory_usage();
+	a.drop_before(a.contiguous_entries(0));
+	BOOST_CHECK(a.memory_usage() < memory);
+	BOOST_CHECK_EQUAL(page.get()[3], 0x5A);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/runcodec.hpp>
+
+using std::vector;
+
+namespace runcodec = pv::data::runcodec;
+
+BOOST_AUTO_TEST_SUITE(RunCodecTest)
+
+BOOST_AUTO_TEST_CASE(RoundTrip)
+{
+	const uint64_t sample_count = 100000;
+
+	for (unsigned int unit_size = 1; unit_size <= 9; unit_size++) {
+		// Runs of all lengths, including ones that need long run lengths
+		vector<uint8_t> data(sample_count * unit_size);
+		vector<uint8_t> sample(unit_size, 0);
+		for (uint64_t i = 0; i < sample_count; i++) {
+			if (rand() % ((i < sample_count / 2) ? 3 : 5000) == 0)
+				sample[rand() % unit_size] ^= 1 << (rand() % 8);
+			for (unsigned int j = 0; j < unit_size; j++)
+				data[i * unit_size + j] = sample[j];
+		}
+
+		vector<uint8_t> encoded;
+		BOOST_REQUIRE(runcodec::encode(data.data(), sample_count,
+			unit_size, encoded, data.size()));
+		BOOST_CHECK(encoded.size() < data.size());
+
+		vector<uint8_t> decoded(data.size());
+		runcodec::decode(encoded.data(), encoded.size(),
+			decoded.data(), unit_size);
+		BOOST_CHECK(decoded == data);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(Incompressible)
+{
+	vector<uint8_t> data(4096);
+	for (uint8_t &d : data)
+		d = rand();
+
+	vector<uint8_t> encoded;
+	BOOST_CHECK(!runcodec::encode(data.data(), data.size(), 1, encoded,
+		data.size() / 2));
+	BOOST_CHECK(encoded.size() <= data.size() / 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
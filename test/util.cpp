@@ -236,4 +236,14 @@ BOOST_AUTO_TEST_CASE(format_time_minutes_test)
 	BOOST_CHECK_EQUAL(format_time_minutes(ts(-100), 0, false), "-1:40");
 }
 
+BOOST_AUTO_TEST_CASE(format_size_test)
+{
+	BOOST_CHECK_EQUAL(format_size(0), "0 B");
+	BOOST_CHECK_EQUAL(format_size(1023), "1023 B");
+	BOOST_CHECK_EQUAL(format_size(1024), "1.0 KiB");
+	BOOST_CHECK_EQUAL(format_size(1536), "1.5 KiB");
+	BOOST_CHECK_EQUAL(format_size(3 << 20, 2), "3.00 MiB");
+	BOOST_CHECK_EQUAL(format_size(5ULL << 30, 0), "5 GiB");
+}
+
 BOOST_AUTO_TEST_SUITE_END()